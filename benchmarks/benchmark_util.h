@@ -0,0 +1,49 @@
+// Helpers shared by the text pipeline benchmarks.
+
+#ifndef LINGUA_BENCHMARK_UTIL_H
+#define LINGUA_BENCHMARK_UTIL_H
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace lingua::benchmark {
+
+/**
+ * @brief Repeat a run until it has taken a measurable time.
+ *
+ * @param run The callable to time
+ * @return double The seconds per run
+ */
+template <typename Run>
+double seconds_per_run(Run&& run) {
+    using Clock = std::chrono::steady_clock;
+    size_t runs = 0;
+    const auto start = Clock::now();
+    double seconds = 0.0;
+    do {
+        run();
+        ++runs;
+        seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (seconds < 0.3);
+    return seconds / runs;
+}
+
+/**
+ * @brief Read the test sentences of a language.
+ *
+ * @param code The ISO 639-1 code of the language
+ * @return std::string The contents of models/<code>/testdata/sentences.txt, empty if it cannot be read
+ */
+inline std::string read_sentences(const std::string& code) {
+    std::ifstream file("models/" + code + "/testdata/sentences.txt");
+    std::ostringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+} // namespace lingua::benchmark
+
+#endif // LINGUA_BENCHMARK_UTIL_H
@@ -0,0 +1,116 @@
+// Measures scoring throughput in MB of UTF-8 text per second: summing the log
+// probabilities of every 1- to 5-gram of a text, once with the n-grams of an
+// NgramExtractor looked up in the exact hash table models, and once with the
+// hashes of an NgramHasher looked up in the same models frozen as hashed
+// n-grams (ModelBuilder::freeze_hashed), which never builds an n-gram.
+//
+// Usage: hashed_scoring_benchmark [ISO_639_1_CODE...]
+//
+// Run it from the directory that contains models/. The text is the sentences
+// of models/<code>/testdata/sentences.txt of each language (default: en, ru,
+// ar, hi, zh, ko), scored against the probability models of that language up
+// to the first n-gram length it has no model for. Besides the throughput it
+// prints the memory of both model sets and how many n-grams got a different
+// probability, which only fingerprint collisions of the hashed models cause.
+
+#include "benchmark_util.h"
+#include "lingua/model_builder.h"
+#include "lingua/model_loader.h"
+#include "lingua/ngram_extractor.h"
+#include "lingua/ngram_hasher.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+using namespace lingua::benchmark;
+
+namespace {
+    double log_probability(double probability) {
+        return probability > 0.0 ? std::log(probability) : 0.0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> codes(argv + 1, argv + argc);
+    if (codes.empty()) {
+        codes = {"en", "ru", "ar", "hi", "zh", "ko"};
+    }
+
+    std::printf("%-4s %8s %12s %12s %14s %14s %10s\n", "lang", "MB", "exact MB/s", "hashed MB/s", "exact MiB",
+                "hashed MiB", "differ");
+    NgramExtractor extractor;
+    NgramHasher hasher;
+    for (const std::string& code : codes) {
+        const std::string text = read_sentences(code);
+        if (text.empty()) {
+            std::printf("%-4s no models/%s/testdata/sentences.txt\n", code.c_str(), code.c_str());
+            continue;
+        }
+        std::vector<std::shared_ptr<const NgramProbabilityModel>> exact;
+        std::vector<std::unique_ptr<NgramProbabilityModel>> hashed;
+        size_t exact_bytes = 0;
+        size_t hashed_bytes = 0;
+        try {
+            const Language language = from_iso_code_639_1(code);
+            for (size_t ngram_length = 1; ngram_length <= Ngram::MAX_CHAR_COUNT; ++ngram_length) {
+                const std::string path = ModelLoader::model_file_path(
+                    language, ngram_length, ModelKind::PROBABILITY, ModelLoader::JSON_MODEL_EXTENSION);
+                if (!std::filesystem::exists(path)) {
+                    break;
+                }
+                exact.push_back(ModelLoader::get_instance().load_probability_model(language, ngram_length));
+                hashed.push_back(std::make_unique<NgramProbabilityModel>(
+                    ModelBuilder::freeze_hashed(exact.back()->frozen_model())));
+                exact_bytes += exact.back()->memory_usage_bytes();
+                hashed_bytes += hashed.back()->memory_usage_bytes();
+            }
+        } catch (const std::exception& error) {
+            std::printf("%-4s cannot load models: %s\n", code.c_str(), error.what());
+            continue;
+        }
+
+        // Orders without a model are scored by neither
+        const size_t orders = exact.size();
+        double exact_score = 0.0;
+        const double exact_seconds = seconds_per_run([&] {
+            extractor.extract(text);
+            exact_score = 0.0;
+            for (size_t order = 1; order <= orders; ++order) {
+                for (const Ngram& ngram : extractor.ngrams(order)) {
+                    exact_score += log_probability(exact[order - 1]->get_probability(ngram));
+                }
+            }
+        });
+        double hashed_score = 0.0;
+        const double hashed_seconds = seconds_per_run([&] {
+            hasher.extract(text);
+            hashed_score = 0.0;
+            for (size_t order = 1; order <= orders; ++order) {
+                for (uint64_t ngram_hash : hasher.hashes(order)) {
+                    hashed_score += log_probability(hashed[order - 1]->get_probability_by_hash(ngram_hash));
+                }
+            }
+        });
+
+        size_t differ = 0;
+        for (size_t order = 1; order <= orders; ++order) {
+            const auto ngrams = extractor.ngrams(order);
+            const auto hashes = hasher.hashes(order);
+            for (size_t i = 0; i < ngrams.size(); ++i) {
+                differ += exact[order - 1]->get_probability(ngrams[i])
+                          != hashed[order - 1]->get_probability_by_hash(hashes[i]);
+            }
+        }
+        const double megabytes = text.size() / 1e6;
+        std::printf("%-4s %8.2f %12.1f %12.1f %14.1f %14.1f %10zu  (%.0f / %.0f)\n", code.c_str(), megabytes,
+                    megabytes / exact_seconds, megabytes / hashed_seconds, exact_bytes / 1048576.0,
+                    hashed_bytes / 1048576.0, differ, exact_score, hashed_score);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,220 @@
+// Measures lookup throughput and dTLB misses of random probes into the
+// probability models, with the models on base pages and on huge pages
+// (ModelLoader::set_page_policy).
+//
+// Usage: huge_page_benchmark [--probes N] [--memory-map] [ISO_639_1_CODE...]
+//
+// Run it from the directory that contains models/. Each policy runs in a fresh
+// process that loads the models of the given languages (default: every
+// language), then probes them in random order with n-grams drawn from the
+// models and as many n-grams that miss. dTLB misses are read from the
+// hardware counters (perf_event_open) and shown as n/a where they cannot be.
+// --memory-map maps binary models instead of reading them; read-only file
+// mappings only get huge pages on file systems that support them.
+
+#include "lingua/model_loader.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+
+namespace {
+    struct Profile {
+        const char* name;
+        PagePolicy pages;
+    };
+
+    struct Probe {
+        const NgramProbabilityModel* model;
+        std::string ngram;
+    };
+
+    // Counts the dTLB load misses of this process in user space, if the hardware exposes them
+    class DtlbMissCounter {
+    public:
+        DtlbMissCounter() {
+            perf_event_attr attributes {};
+            attributes.type = PERF_TYPE_HW_CACHE;
+            attributes.size = sizeof(attributes);
+            attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attributes.disabled = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+        }
+
+        ~DtlbMissCounter() {
+            if (fd_ >= 0) {
+                ::close(fd_);
+            }
+        }
+
+        bool available() const {
+            return fd_ >= 0;
+        }
+
+        void start() {
+            if (fd_ >= 0) {
+                ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+
+        uint64_t stop() {
+            uint64_t count = 0;
+            if (fd_ >= 0) {
+                ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+                if (::read(fd_, &count, sizeof(count)) != sizeof(count)) {
+                    count = 0;
+                }
+            }
+            return count;
+        }
+
+    private:
+        int fd_ = -1;
+    };
+
+    // Anonymous, file and shared memory mapped with huge pages, from /proc/self/smaps_rollup
+    double huge_page_mib() {
+        std::ifstream rollup("/proc/self/smaps_rollup");
+        double kib = 0.0;
+        for (std::string line; std::getline(rollup, line);) {
+            for (const char* field : {"AnonHugePages:", "FilePmdMapped:", "ShmemPmdMapped:"}) {
+                if (line.rfind(field, 0) == 0) {
+                    kib += std::strtod(line.c_str() + std::strlen(field), nullptr);
+                }
+            }
+        }
+        return kib / 1024.0;
+    }
+
+    int run_profile(const Profile& profile, const std::vector<Language>& languages, size_t probe_count, bool map) {
+        auto& loader = ModelLoader::get_instance();
+        MappingOptions options;
+        options.pages = profile.pages;
+        loader.set_memory_mapping(map, options);
+
+        std::vector<std::shared_ptr<const NgramProbabilityModel>> models;
+        size_t model_bytes = 0;
+        for (Language language : languages) {
+            for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+                const std::string path = ModelLoader::model_file_path(
+                    language, ngram_length, ModelKind::PROBABILITY, ModelLoader::JSON_MODEL_EXTENSION);
+                if (!std::filesystem::exists(path)) {
+                    continue;
+                }
+                models.push_back(loader.load_probability_model(language, ngram_length));
+                model_bytes += models.back()->memory_usage_bytes();
+            }
+        }
+
+        // Half of the probes hit a random model, half miss it
+        std::mt19937_64 random(42);
+        std::vector<Probe> probes;
+        probes.reserve(probe_count);
+        while (probes.size() < probe_count) {
+            const NgramProbabilityModel& model = *models[random() % models.size()];
+            const FrozenModel& frozen = model.frozen_model();
+            if (frozen.size() == 0) {
+                continue;
+            }
+            std::string ngram(frozen.ngram_at(random() % frozen.size()));
+            if (probes.size() % 2 == 1) {
+                ngram.back() = static_cast<char>('0' + random() % 10);
+            }
+            probes.push_back({&model, std::move(ngram)});
+        }
+
+        // One untimed pass faults every page in, so only steady-state lookups are measured
+        double checksum = 0.0;
+        for (const Probe& probe : probes) {
+            checksum += probe.model->get_probability(probe.ngram);
+        }
+        DtlbMissCounter counter;
+        const auto start = std::chrono::steady_clock::now();
+        counter.start();
+        for (const Probe& probe : probes) {
+            checksum += probe.model->get_probability(probe.ngram);
+        }
+        const uint64_t misses = counter.stop();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        char misses_per_probe[32] = "n/a";
+        if (counter.available()) {
+            std::snprintf(misses_per_probe, sizeof(misses_per_probe), "%.3f", static_cast<double>(misses) / probes.size());
+        }
+        std::printf("%-12s %6zu %10.1f %10.1f %12.2f %12s %10.1f  (checksum %.3g)\n", profile.name, models.size(),
+                    model_bytes / 1048576.0, huge_page_mib(), probes.size() / seconds / 1e6, misses_per_probe,
+                    seconds * 1e9 / probes.size(), checksum);
+        return EXIT_SUCCESS;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t probe_count = 4000000;
+    bool map = false;
+    std::vector<Language> languages;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            if (argument == "--probes" && i + 1 < argc) {
+                probe_count = std::stoul(argv[++i]);
+            } else if (argument == "--memory-map") {
+                map = true;
+            } else {
+                languages.push_back(from_iso_code_639_1(argument));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Usage: huge_page_benchmark [--probes N] [--memory-map] [ISO_639_1_CODE...]: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    if (languages.empty()) {
+        const auto all = all_languages();
+        languages.assign(all.begin(), all.end());
+        std::sort(languages.begin(), languages.end());
+    }
+
+    const Profile profiles[] = {
+        {"base pages", PagePolicy::DEFAULT},
+        {"huge pages", PagePolicy::HUGE_PAGES},
+    };
+
+    std::printf("%-12s %6s %10s %10s %12s %12s %10s\n", "policy", "models", "MiB", "huge MiB", "Mprobes/s",
+                "dTLB/probe", "ns/probe");
+    int status = EXIT_SUCCESS;
+    for (const Profile& profile : profiles) {
+        std::fflush(stdout);
+        const pid_t child = fork();
+        if (child == 0) {
+            try {
+                std::exit(run_profile(profile, languages, probe_count, map));
+            } catch (const std::exception& e) {
+                std::printf("%-12s failed: %s\n", profile.name, e.what());
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        int child_status = 0;
+        waitpid(child, &child_status, 0);
+        if (!WIFEXITED(child_status) || WEXITSTATUS(child_status) != EXIT_SUCCESS) {
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,180 @@
+// Measures load time, resident memory and first-query latency of the binary
+// models for each ModelLoader page-fault profile: read into memory, and mmap
+// lazily, with MAP_POPULATE, with MADV_RANDOM, with MADV_WILLNEED and with mlock.
+//
+// Usage: mmap_loading_benchmark [--drop-caches] [ISO_639_1_CODE...]
+//
+// Run it from the directory that contains models/ after converting the models
+// (`cmake --build . --target convert_models`). Each profile runs in a fresh
+// process. --drop-caches empties the page cache before each profile (needs root),
+// measuring cold-start behavior instead of warm page cache behavior.
+
+#include "lingua/model_loader.h"
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+
+namespace {
+    struct Profile {
+        const char* name;
+        bool map;
+        MappingOptions options;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_ms(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    double resident_mib() {
+        std::ifstream statm("/proc/self/statm");
+        size_t total_pages = 0;
+        size_t resident_pages = 0;
+        statm >> total_pages >> resident_pages;
+        return static_cast<double>(resident_pages) * static_cast<double>(sysconf(_SC_PAGESIZE)) / 1048576.0;
+    }
+
+    void drop_caches() {
+        sync();
+        std::ofstream drop("/proc/sys/vm/drop_caches");
+        drop << "3\n";
+        if (!drop) {
+            std::fprintf(stderr, "Cannot drop the page cache; measuring with a warm cache\n");
+        }
+    }
+
+    struct LoadedModel {
+        std::shared_ptr<const NgramProbabilityModel> probabilities;
+        std::shared_ptr<const NgramCountModel> counts;
+
+        bool probe(const std::string& ngram) const {
+            return probabilities ? probabilities->get_probability(ngram) > 0.0 : counts->contains(ngram);
+        }
+    };
+
+    int run_profile(const Profile& profile, const std::vector<Language>& languages) {
+        auto& loader = ModelLoader::get_instance();
+        loader.set_memory_mapping(profile.map, profile.options);
+
+        const double rss_before = resident_mib();
+        const auto load_start = Clock::now();
+        std::vector<LoadedModel> models;
+        for (Language language : languages) {
+            for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+                for (ModelKind kind : {ModelKind::PROBABILITY, ModelKind::UNIQUE, ModelKind::MOST_COMMON}) {
+                    const std::string path = ModelLoader::model_file_path(
+                        language, ngram_length, kind, ModelLoader::BINARY_MODEL_EXTENSION);
+                    if (!std::filesystem::exists(path)) {
+                        continue;
+                    }
+                    if (kind == ModelKind::PROBABILITY) {
+                        models.push_back({loader.load_probability_model(language, ngram_length), nullptr});
+                    } else {
+                        const auto model_type = kind == ModelKind::UNIQUE ? NgramModelType::UNIQUE : NgramModelType::MOST_COMMON;
+                        models.push_back({nullptr, loader.load_count_model(language, ngram_length, model_type)});
+                    }
+                }
+            }
+        }
+        const double load_ms = elapsed_ms(load_start);
+        const double rss_loaded = resident_mib();
+        if (models.empty()) {
+            std::fprintf(stderr, "No binary models found; run the convert_models target first\n");
+            return EXIT_FAILURE;
+        }
+
+        // The first probe of each model pays for its page faults, later probes do not
+        std::vector<double> first_query_us;
+        size_t hits = 0;
+        for (const auto& model : models) {
+            const auto start = Clock::now();
+            hits += model.probe("the") ? 1 : 0;
+            first_query_us.push_back(elapsed_ms(start) * 1000.0);
+        }
+        std::sort(first_query_us.begin(), first_query_us.end());
+        double first_query_total = 0.0;
+        for (double us : first_query_us) {
+            first_query_total += us;
+        }
+
+        const auto warm_start = Clock::now();
+        for (const auto& model : models) {
+            hits += model.probe("and") ? 1 : 0;
+        }
+        const double warm_query_us = elapsed_ms(warm_start) * 1000.0 / static_cast<double>(models.size());
+
+        std::printf("%-14s %6zu %10.1f %10.1f %10.1f %10.2f %10.2f %10.2f %10.3f  (%zu hits)\n",
+                    profile.name, models.size(), load_ms, rss_loaded - rss_before, resident_mib() - rss_before,
+                    first_query_total / static_cast<double>(models.size()),
+                    first_query_us[first_query_us.size() / 2], first_query_us.back(), warm_query_us, hits);
+        return EXIT_SUCCESS;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool cold = false;
+    std::vector<Language> languages;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            if (argument == "--drop-caches") {
+                cold = true;
+            } else {
+                languages.push_back(from_iso_code_639_1(argument));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Usage: mmap_loading_benchmark [--drop-caches] [ISO_639_1_CODE...]: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    if (languages.empty()) {
+        const auto all = all_languages();
+        languages.assign(all.begin(), all.end());
+        std::sort(languages.begin(), languages.end());
+    }
+
+    const Profile profiles[] = {
+        {"read", false, {}},
+        {"mmap", true, {}},
+        {"mmap+populate", true, {true, MappingAdvice::NORMAL, false}},
+        {"mmap+random", true, {false, MappingAdvice::RANDOM, false}},
+        {"mmap+willneed", true, {false, MappingAdvice::WILLNEED, false}},
+        {"mmap+mlock", true, {false, MappingAdvice::NORMAL, true}},
+    };
+
+    std::printf("%-14s %6s %10s %10s %10s %10s %10s %10s %10s\n", "profile", "models", "load ms", "RSS MiB",
+                "RSS+q MiB", "1st avg us", "1st p50 us", "1st max us", "warm us");
+    int status = EXIT_SUCCESS;
+    for (const Profile& profile : profiles) {
+        if (cold) {
+            drop_caches();
+        }
+        std::fflush(stdout);
+        const pid_t child = fork();
+        if (child == 0) {
+            try {
+                std::exit(run_profile(profile, languages));
+            } catch (const std::exception& e) {
+                std::printf("%-14s failed: %s\n", profile.name, e.what());
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        int child_status = 0;
+        waitpid(child, &child_status, 0);
+        if (!WIFEXITED(child_status) || WEXITSTATUS(child_status) != EXIT_SUCCESS) {
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
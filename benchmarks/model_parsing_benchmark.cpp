@@ -0,0 +1,106 @@
+// Measures how fast JSON models are turned into frozen models, in n-grams per
+// second, for the English fivegram probability model by default.
+//
+// Usage: model_parsing_benchmark [ISO_639_1_CODE [NGRAM_LENGTH [ITERATIONS]]]
+//
+// Run it from the directory that contains models/. The Brotli decoding time is
+// measured separately and subtracted from ModelLoader::parse_model to get the
+// JSON parsing time; freezing is timed on the parsed builder. Finally the whole
+// compile_model is timed with 1, 2, 4, ... loader threads up to the hardware
+// thread count (at least 4), since large models are parsed in parallel.
+
+#include "lingua/model_loader.h"
+#include <brotli/decode.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    double elapsed_seconds(Clock::time_point start) {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    // Decodes the whole file once with the one-shot API, as a baseline for the loader's decoding
+    size_t decode(const std::string& compressed, std::vector<uint8_t>& output) {
+        size_t decoded_size = output.size();
+        if (BrotliDecoderDecompress(compressed.size(), reinterpret_cast<const uint8_t*>(compressed.data()),
+                                    &decoded_size, output.data()) != BROTLI_DECODER_RESULT_SUCCESS) {
+            throw std::runtime_error("Cannot decode model file");
+        }
+        return decoded_size;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    try {
+        const Language language = from_iso_code_639_1(argc > 1 ? argv[1] : "en");
+        const size_t ngram_length = argc > 2 ? std::stoul(argv[2]) : 5;
+        const int iterations = argc > 3 ? std::stoi(argv[3]) : 10;
+
+        const std::string path = ModelLoader::model_file_path(
+            language, ngram_length, ModelKind::PROBABILITY, ModelLoader::JSON_MODEL_EXTENSION);
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        const std::string compressed{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        std::vector<uint8_t> decoded(compressed.size() * 16);
+
+        auto& loader = ModelLoader::get_instance();
+        size_t ngram_count = loader.compile_model(language, ngram_length, ModelKind::PROBABILITY).size();
+        size_t decoded_size = 0;
+
+        double best_decode = 1e9;
+        double best_parse = 1e9;
+        double best_freeze = 1e9;
+        for (int i = 0; i < iterations; ++i) {
+            auto start = Clock::now();
+            decoded_size = decode(compressed, decoded);
+            best_decode = std::min(best_decode, elapsed_seconds(start));
+
+            start = Clock::now();
+            const ModelBuilder builder = loader.parse_model(language, ngram_length, ModelKind::PROBABILITY);
+            best_parse = std::min(best_parse, elapsed_seconds(start));
+
+            start = Clock::now();
+            ngram_count = builder.freeze().size();
+            best_freeze = std::min(best_freeze, elapsed_seconds(start));
+        }
+
+        const double parse = std::max(best_parse - best_decode, 1e-9);
+        const double total = best_parse + best_freeze;
+        std::printf("%s: %zu n-grams, %.1f MiB JSON, best of %d\n", path.c_str(), ngram_count,
+                    decoded_size / 1048576.0, iterations);
+        std::printf("  decode:  %8.2f ms  %7.1f MiB/s\n", best_decode * 1e3, decoded_size / best_decode / 1048576.0);
+        std::printf("  parse:   %8.2f ms  %7.2f M n-grams/s\n", parse * 1e3, ngram_count / parse / 1e6);
+        std::printf("  freeze:  %8.2f ms  %7.2f M n-grams/s\n", best_freeze * 1e3, ngram_count / best_freeze / 1e6);
+        std::printf("  total:   %8.2f ms  %7.2f M n-grams/s\n", total * 1e3, ngram_count / total / 1e6);
+
+        const size_t max_thread_count = std::max<size_t>(4, ThreadPool::default_thread_count());
+        for (size_t thread_count = 1; thread_count <= max_thread_count; thread_count *= 2) {
+            loader.set_thread_count(thread_count);
+            double best_compile = 1e9;
+            for (int i = 0; i < iterations; ++i) {
+                const auto start = Clock::now();
+                ngram_count = loader.compile_model(language, ngram_length, ModelKind::PROBABILITY).size();
+                best_compile = std::min(best_compile, elapsed_seconds(start));
+            }
+            std::printf("  compile_model, %2zu threads: %8.2f ms  %7.2f M n-grams/s\n", thread_count,
+                        best_compile * 1e3, ngram_count / best_compile / 1e6);
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "model_parsing_benchmark: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
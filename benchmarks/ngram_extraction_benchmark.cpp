@@ -0,0 +1,61 @@
+// Measures n-gram extraction throughput in MB of UTF-8 text per second: the
+// single-pass NgramExtractor, which produces every order at once, against
+// TextProcessor::generate_ngrams, which is called once per order.
+//
+// Usage: ngram_extraction_benchmark [ISO_639_1_CODE...]
+//
+// Run it from the directory that contains models/. The text is the sentences
+// of models/<code>/testdata/sentences.txt of each language (default: en, de,
+// ru, ar, zh). generate_ngrams joins whole words into n-grams while the
+// extractor slices words into character n-grams, so the counts differ; the
+// comparison is of the cost of producing the n-grams a scorer looks up.
+
+#include "benchmark_util.h"
+#include "lingua/ngram_extractor.h"
+#include "lingua/text_processor.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+using namespace lingua::benchmark;
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> codes(argv + 1, argv + argc);
+    if (codes.empty()) {
+        codes = {"en", "de", "ru", "ar", "zh"};
+    }
+
+    std::printf("%-4s %5s %8s %16s %12s %16s %12s\n", "lang", "order", "MB", "generate MB/s", "count",
+                "extractor MB/s", "count");
+    NgramExtractor extractor;
+    for (const std::string& code : codes) {
+        const std::string text = read_sentences(code);
+        if (text.empty()) {
+            std::printf("%-4s no models/%s/testdata/sentences.txt\n", code.c_str(), code.c_str());
+            continue;
+        }
+        const double megabytes = text.size() / 1e6;
+
+        size_t sink = 0;
+        const double extract_seconds = seconds_per_run([&] {
+            extractor.extract(text);
+            sink += extractor.ngrams(1).size();
+        });
+        double generate_total = 0.0;
+        for (size_t order = 1; order <= Ngram::MAX_CHAR_COUNT; ++order) {
+            size_t generated = 0;
+            const double generate_seconds = seconds_per_run([&] {
+                generated = TextProcessor::generate_ngrams(text, order).size();
+            });
+            generate_total += generate_seconds;
+            std::printf("%-4s %5zu %8.2f %16.1f %12zu %16.1f %12zu\n", code.c_str(), order, megabytes,
+                        megabytes / generate_seconds, generated, megabytes / extract_seconds,
+                        extractor.ngrams(order).size());
+        }
+        std::printf("%-4s %5s %8.2f %16.1f %12s %16.1f %12s  (%zu)\n", code.c_str(), "all", megabytes,
+                    megabytes / generate_total, "", megabytes / extract_seconds, "", sink % 10);
+    }
+    return EXIT_SUCCESS;
+}
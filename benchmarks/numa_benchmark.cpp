@@ -0,0 +1,165 @@
+// Measures lookup throughput of random probes into the probability models from
+// threads pinned to each NUMA node, with a single copy of the models and with
+// one replica per node (ModelLoader::set_numa_replication).
+//
+// Usage: numa_benchmark [--probes N] [ISO_639_1_CODE...]
+//
+// Run it from the directory that contains models/. Each profile runs in a fresh
+// process that loads the models of the given languages (default: every
+// language) from node 0, so the single copy lives in node 0's memory, then
+// probes them in random order from each node in turn with n-grams drawn from
+// the models and as many n-grams that miss. Hosts with one node show one row
+// per profile.
+
+#include "lingua/model_loader.h"
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+
+namespace {
+    struct Profile {
+        const char* name;
+        size_t replica_budget;
+    };
+
+    struct Probe {
+        const NgramProbabilityModel* model;
+        std::string ngram;
+    };
+
+    // Restricts the calling thread to the CPUs of a node, if they are known
+    bool pin_to_node(const NumaTopology& topology, size_t node) {
+        const std::vector<unsigned>& cpus = topology.node_cpus(node);
+        if (cpus.empty()) {
+            return true;
+        }
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (unsigned cpu : cpus) {
+            CPU_SET(cpu, &set);
+        }
+        return ::sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+
+    int run_profile(const Profile& profile, const std::vector<Language>& languages, size_t probe_count) {
+        const auto topology = NumaTopology::system();
+        auto& loader = ModelLoader::get_instance();
+        loader.set_thread_count(1);
+        loader.set_numa_replication(profile.replica_budget, topology);
+        pin_to_node(*topology, 0);
+
+        std::vector<std::shared_ptr<const NgramProbabilityModel>> models;
+        size_t model_bytes = 0;
+        for (Language language : languages) {
+            for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+                const std::string path = ModelLoader::model_file_path(
+                    language, ngram_length, ModelKind::PROBABILITY, ModelLoader::JSON_MODEL_EXTENSION);
+                if (!std::filesystem::exists(path)) {
+                    continue;
+                }
+                models.push_back(loader.load_probability_model(language, ngram_length));
+                model_bytes += models.back()->memory_usage_bytes();
+            }
+        }
+
+        // Half of the probes hit a random model, half miss it
+        std::mt19937_64 random(42);
+        std::vector<Probe> probes;
+        probes.reserve(probe_count);
+        while (probes.size() < probe_count) {
+            const NgramProbabilityModel& model = *models[random() % models.size()];
+            const FrozenModel& frozen = model.frozen_model();
+            if (frozen.size() == 0) {
+                continue;
+            }
+            std::string ngram(frozen.ngram_at(random() % frozen.size()));
+            if (probes.size() % 2 == 1) {
+                ngram.back() = static_cast<char>('0' + random() % 10);
+            }
+            probes.push_back({&model, std::move(ngram)});
+        }
+
+        for (size_t node = 0; node < topology->node_count(); ++node) {
+            if (!pin_to_node(*topology, node)) {
+                std::printf("%-14s %4zu cannot pin to node\n", profile.name, node);
+                continue;
+            }
+            // One untimed pass faults every page in and settles the thread on the node
+            double checksum = 0.0;
+            for (const Probe& probe : probes) {
+                checksum += probe.model->get_probability(probe.ngram);
+            }
+            const auto start = std::chrono::steady_clock::now();
+            for (const Probe& probe : probes) {
+                checksum += probe.model->get_probability(probe.ngram);
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::printf("%-14s %4zu %6zu %10.1f %12.1f %12.2f %10.1f  (checksum %.3g)\n", profile.name, node,
+                        models.size(), model_bytes / 1048576.0, loader.numa_replica_bytes() / 1048576.0,
+                        probes.size() / seconds / 1e6, seconds * 1e9 / probes.size(), checksum);
+        }
+        return EXIT_SUCCESS;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t probe_count = 4000000;
+    std::vector<Language> languages;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            if (argument == "--probes" && i + 1 < argc) {
+                probe_count = std::stoul(argv[++i]);
+            } else {
+                languages.push_back(from_iso_code_639_1(argument));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Usage: numa_benchmark [--probes N] [ISO_639_1_CODE...]: %s\n", e.what());
+        return EXIT_FAILURE;
+    }
+    if (languages.empty()) {
+        const auto all = all_languages();
+        languages.assign(all.begin(), all.end());
+        std::sort(languages.begin(), languages.end());
+    }
+
+    const Profile profiles[] = {
+        {"single copy", 0},
+        {"node replicas", SIZE_MAX},
+    };
+
+    std::printf("%d NUMA node(s)\n", static_cast<int>(NumaTopology::system()->node_count()));
+    std::printf("%-14s %4s %6s %10s %12s %12s %10s\n", "profile", "node", "models", "MiB", "replica MiB",
+                "Mprobes/s", "ns/probe");
+    int status = EXIT_SUCCESS;
+    for (const Profile& profile : profiles) {
+        std::fflush(stdout);
+        const pid_t child = fork();
+        if (child == 0) {
+            try {
+                std::exit(run_profile(profile, languages, probe_count));
+            } catch (const std::exception& e) {
+                std::printf("%-14s failed: %s\n", profile.name, e.what());
+                std::exit(EXIT_FAILURE);
+            }
+        }
+        int child_status = 0;
+        waitpid(child, &child_status, 0);
+        if (!WIFEXITED(child_status) || WEXITSTATUS(child_status) != EXIT_SUCCESS) {
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
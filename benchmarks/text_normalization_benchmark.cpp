@@ -0,0 +1,63 @@
+// Measures text normalization throughput in MB of UTF-8 text per second: the
+// TextProcessor chain of to_lowercase(), remove_punctuation(), remove_numbers(),
+// remove_extra_whitespace() and tokenize() against the single pass of
+// TextNormalizer::normalize(), and the latter followed by the n-gram extraction
+// of the normalized text.
+//
+// Usage: text_normalization_benchmark [ISO_639_1_CODE...]
+//
+// Run it from the directory that contains models/. The text of each language
+// is models/<code>/testdata/sentences.txt (default: one language per script).
+// Besides the throughput it prints the word count of both, which differ where
+// the ASCII-only chain keeps Unicode punctuation and digits as words.
+
+#include "benchmark_util.h"
+#include "lingua/ngram_extractor.h"
+#include "lingua/text_normalizer.h"
+#include "lingua/text_processor.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+using namespace lingua::benchmark;
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> codes(argv + 1, argv + argc);
+    if (codes.empty()) {
+        codes = {"en", "de", "ru", "el", "ar", "hi", "zh", "ko"};
+    }
+
+    std::printf("%-4s %8s %11s %14s %16s %11s %11s\n", "lang", "MB", "chain MB/s", "normalize MB/s",
+                "+ extract MB/s", "chain words", "words");
+    TextNormalizer normalizer;
+    NgramExtractor extractor;
+    for (const std::string& code : codes) {
+        const std::string text = read_sentences(code);
+        if (text.empty()) {
+            std::printf("%-4s no models/%s/testdata/sentences.txt\n", code.c_str(), code.c_str());
+            continue;
+        }
+
+        size_t chain_words = 0;
+        const double chain_seconds = seconds_per_run([&] {
+            chain_words = TextProcessor::tokenize(TextProcessor::remove_extra_whitespace(TextProcessor::remove_numbers(
+                TextProcessor::remove_punctuation(TextProcessor::to_lowercase(text))))).size();
+        });
+        size_t words = 0;
+        const double normalize_seconds = seconds_per_run([&] {
+            words = normalizer.normalize(text).size();
+        });
+        const double extract_seconds = seconds_per_run([&] {
+            normalizer.normalize(text);
+            extractor.extract(normalizer.text());
+        });
+
+        const double megabytes = text.size() / 1e6;
+        std::printf("%-4s %8.2f %11.1f %14.1f %16.1f %11zu %11zu\n", code.c_str(), megabytes,
+                    megabytes / chain_seconds, megabytes / normalize_seconds, megabytes / extract_seconds,
+                    chain_words, words);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+// Measures UTF-8 decoding and validation throughput in GB/s per script:
+// lingua's decode_utf8() and is_valid_utf8() against utfcpp's utf8to32() and
+// is_valid(), which the text pipeline used before.
+//
+// Usage: utf8_decoding_benchmark [ISO_639_1_CODE...]
+//
+// Run it from the directory that contains models/. The text of each language
+// is models/<code>/testdata/sentences.txt (default: one language per script).
+// Which SIMD path decode_utf8() takes depends on the target the library was
+// compiled for; build with -mavx2 or -march=native for the AVX2 one.
+
+#include "benchmark_util.h"
+#include "lingua/unicode.h"
+#include <utf8.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+using namespace lingua::benchmark;
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> codes(argv + 1, argv + argc);
+    if (codes.empty()) {
+        codes = {"en", "ru", "el", "hy", "ka", "he", "ar", "hi", "bn", "ta", "th", "zh", "ja", "ko"};
+    }
+
+    std::printf("%-4s %8s %9s %14s %14s %14s %14s\n", "lang", "MB", "bytes/cp", "utf8to32 GB/s", "decode GB/s",
+                "is_valid GB/s", "validate GB/s");
+    std::vector<char32_t> code_points;
+    for (const std::string& code : codes) {
+        const std::string text = read_sentences(code);
+        if (text.empty()) {
+            std::printf("%-4s no models/%s/testdata/sentences.txt\n", code.c_str(), code.c_str());
+            continue;
+        }
+        const double gigabytes = text.size() / 1e9;
+        code_points.resize(text.size());
+
+        size_t written = 0;
+        const double utfcpp_seconds = seconds_per_run([&] {
+            written = utf8::utf8to32(text.begin(), text.end(), code_points.begin()) - code_points.begin();
+        });
+        const double decode_seconds = seconds_per_run([&] {
+            written = decode_utf8(text, code_points).code_points_written;
+        });
+        bool valid = true;
+        const double is_valid_seconds = seconds_per_run([&] {
+            valid &= utf8::is_valid(text.begin(), text.end());
+        });
+        const double validate_seconds = seconds_per_run([&] {
+            valid &= is_valid_utf8(text);
+        });
+        std::printf("%-4s %8.2f %9.2f %14.2f %14.2f %14.2f %14.2f%s\n", code.c_str(), text.size() / 1e6,
+                    static_cast<double>(text.size()) / written, gigabytes / utfcpp_seconds,
+                    gigabytes / decode_seconds, gigabytes / is_valid_seconds, gigabytes / validate_seconds,
+                    valid ? "" : "  (invalid UTF-8)");
+    }
+    return EXIT_SUCCESS;
+}
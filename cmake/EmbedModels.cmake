@@ -0,0 +1,79 @@
+# lingua_embed_models(<target> [ISO_639_1_CODE...])
+#
+# Converts the JSON models of the given languages (all languages without codes)
+# into binary models at build time with lingua_convert_models, and links them
+# into <target> as read-only data with .incbin. src/embedded_models.cpp lists
+# them through the generated embedded_models.inc; see lingua/embedded_models.h.
+function(lingua_embed_models target)
+    set(languages ${ARGN})
+    set(output_dir "${CMAKE_CURRENT_BINARY_DIR}/embedded_models")
+
+    if (languages)
+        set(json_files)
+        foreach (iso_code IN LISTS languages)
+            file(GLOB language_files "${CMAKE_CURRENT_SOURCE_DIR}/models/${iso_code}/models/*.json.br")
+            if (NOT language_files)
+                message(FATAL_ERROR "No models found for language '${iso_code}'")
+            endif ()
+            list(APPEND json_files ${language_files})
+        endforeach ()
+    else ()
+        file(GLOB json_files "${CMAKE_CURRENT_SOURCE_DIR}/models/*/models/*.json.br")
+        if (NOT json_files)
+            message(FATAL_ERROR "No models found in ${CMAKE_CURRENT_SOURCE_DIR}/models")
+        endif ()
+    endif ()
+
+    set(ngram_names unigrams bigrams trigrams quadrigrams fivegrams)
+    set(binary_files)
+    set(table "")
+    # 8-byte aligned blocks, as FrozenModel::from_bytes() requires
+    set(assembly "    .section .rodata.lingua_models,\"a\"\n")
+    foreach (json_file IN LISTS json_files)
+        if (NOT json_file MATCHES "/models/([a-z]+)/models/(unique_|mostcommon_)?([a-z]+)\\.json\\.br$")
+            message(FATAL_ERROR "Unexpected model file name: ${json_file}")
+        endif ()
+        set(iso_code ${CMAKE_MATCH_1})
+        set(prefix ${CMAKE_MATCH_2})
+        set(ngram_name ${CMAKE_MATCH_3})
+        list(FIND ngram_names ${ngram_name} ngram_index)
+        math(EXPR ngram_length "${ngram_index} + 1")
+        if (prefix STREQUAL "unique_")
+            set(kind UNIQUE)
+        elseif (prefix STREQUAL "mostcommon_")
+            set(kind MOST_COMMON)
+        else ()
+            set(kind PROBABILITY)
+        endif ()
+
+        set(binary_file "${output_dir}/models/${iso_code}/models/${prefix}${ngram_name}.lfm")
+        set(symbol "lingua_model_${iso_code}_${ngram_length}_${kind}")
+        list(APPEND binary_files ${binary_file})
+        string(APPEND table "LINGUA_EMBEDDED_MODEL(${iso_code}, ${ngram_length}, ${kind})\n")
+        string(APPEND assembly
+                "    .balign 8\n"
+                "    .globl ${symbol}\n"
+                "${symbol}:\n"
+                "    .incbin \"${binary_file}\"\n"
+                "    .globl ${symbol}_end\n"
+                "${symbol}_end:\n")
+    endforeach ()
+    string(APPEND assembly "    .section .note.GNU-stack,\"\",%progbits\n")
+
+    file(GENERATE OUTPUT "${output_dir}/embedded_models.inc" CONTENT "${table}")
+    file(GENERATE OUTPUT "${output_dir}/embedded_models.S" CONTENT "${assembly}")
+
+    add_custom_command(
+            OUTPUT ${binary_files}
+            COMMAND lingua_convert_models --output-dir "${output_dir}" ${languages}
+            DEPENDS lingua_convert_models ${json_files}
+            WORKING_DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}
+            COMMENT "Converting the embedded models"
+            VERBATIM
+    )
+    set_source_files_properties("${output_dir}/embedded_models.S" PROPERTIES OBJECT_DEPENDS "${binary_files}")
+
+    target_sources(${target} PRIVATE "${output_dir}/embedded_models.S")
+    target_include_directories(${target} PRIVATE "${output_dir}")
+    target_compile_definitions(${target} PRIVATE LINGUA_EMBED_MODELS)
+endfunction()
@@ -0,0 +1,63 @@
+#ifndef LINGUA_EMBEDDED_MODELS_H
+#define LINGUA_EMBEDDED_MODELS_H
+
+#include "lingua/language.h"
+#include "lingua/model_kind.h"
+#include <cstddef>
+#include <span>
+
+namespace lingua {
+
+/**
+ * @brief A binary model linked into the library as read-only data.
+ *
+ * Models are embedded when lingua_cpp is configured with -DLINGUA_EMBED_MODELS=ON;
+ * the block is 8-byte aligned and can be wrapped with FrozenModel::from_bytes().
+ */
+struct EmbeddedModel {
+    /**
+     * @brief ISO 639-1 code of the model's language
+     */
+    const char* iso_code;
+
+    /**
+     * @brief Length of the model's n-grams (1-5)
+     */
+    size_t ngram_length;
+
+    /**
+     * @brief Kind of data the model holds
+     */
+    ModelKind kind;
+
+    /**
+     * @brief First byte of the frozen model block
+     */
+    const std::byte* begin;
+
+    /**
+     * @brief One past the last byte of the frozen model block
+     */
+    const std::byte* end;
+};
+
+/**
+ * @brief Get the models embedded into the library at build time
+ *
+ * @return std::span<const EmbeddedModel> The embedded models, empty unless built with LINGUA_EMBED_MODELS
+ */
+std::span<const EmbeddedModel> embedded_models();
+
+/**
+ * @brief Find an embedded model
+ *
+ * @param language The language of the model
+ * @param ngram_length The length of n-grams in the model
+ * @param kind The kind of model
+ * @return const EmbeddedModel* The embedded model, or nullptr if it was not embedded
+ */
+const EmbeddedModel* find_embedded_model(Language language, size_t ngram_length, ModelKind kind);
+
+} // namespace lingua
+
+#endif // LINGUA_EMBEDDED_MODELS_H
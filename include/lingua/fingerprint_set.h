@@ -0,0 +1,194 @@
+#ifndef LINGUA_FINGERPRINT_SET_H
+#define LINGUA_FINGERPRINT_SET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace lingua {
+
+/**
+ * @brief Compact, read-only membership set of n-gram fingerprints.
+ *
+ * Every n-gram is reduced to a fingerprint made of the top `fingerprint_bits` bits
+ * of its 64-bit hash. The sorted fingerprints are stored with Elias-Fano coding:
+ * the low bits of each value are packed verbatim and the high bits are stored as
+ * unary gaps in a bit vector that is searched with a sampled select. This takes
+ * about `2 + fingerprint_bits - log2(size)` bits per n-gram.
+ *
+ * Membership tests have no false negatives. An n-gram that is not in the set is
+ * reported as present when its fingerprint collides with a member's fingerprint,
+ * which happens with probability `size / 2^fingerprint_bits`.
+ *
+ * The bit arrays are immutable and shared between copies. They are either owned
+ * by the set or borrowed from a FrozenModel block, see from_parts().
+ */
+class FingerprintSet {
+public:
+    /**
+     * @brief Smallest accepted fingerprint width in bits
+     */
+    static constexpr unsigned MIN_FINGERPRINT_BITS = 8;
+
+    /**
+     * @brief Largest accepted fingerprint width in bits
+     */
+    static constexpr unsigned MAX_FINGERPRINT_BITS = 64;
+
+    /**
+     * @brief Constructs an empty FingerprintSet
+     */
+    FingerprintSet() = default;
+
+    /**
+     * @brief Constructs a FingerprintSet from n-grams.
+     *
+     * @param ngrams The n-grams to store; duplicates are allowed
+     * @param fingerprint_bits The fingerprint width in bits
+     * @throws std::invalid_argument if fingerprint_bits is not between 8 and 64
+     */
+    FingerprintSet(const std::vector<std::string_view>& ngrams, unsigned fingerprint_bits);
+
+    /**
+     * @brief Constructs a FingerprintSet over existing Elias-Fano arrays.
+     *
+     * The parameters are those reported by another set's accessors, so that a set
+     * written into a contiguous block can be used in place.
+     *
+     * @param size The number of distinct fingerprints
+     * @param fingerprint_bits The fingerprint width in bits
+     * @param lower_bit_count The number of low bits stored verbatim per fingerprint
+     * @param bucket_count The number of high-bit buckets
+     * @param lower_bits The packed low bits
+     * @param upper_bits The unary-coded high bits
+     * @param zero_samples The sampled positions of zeros in upper_bits
+     * @param owner Keeps the arrays alive for as long as the set or its copies exist
+     * @return FingerprintSet The set
+     */
+    static FingerprintSet from_parts(
+        size_t size,
+        unsigned fingerprint_bits,
+        unsigned lower_bit_count,
+        uint64_t bucket_count,
+        std::span<const uint64_t> lower_bits,
+        std::span<const uint64_t> upper_bits,
+        std::span<const uint64_t> zero_samples,
+        std::shared_ptr<const void> owner
+    );
+
+    /**
+     * @brief Get the fingerprint width needed for a target false-positive rate.
+     *
+     * @param ngram_count The number of n-grams that will be stored
+     * @param false_positive_rate The accepted probability of reporting a non-member as present
+     * @return unsigned The fingerprint width, clamped to 8..64
+     * @throws std::invalid_argument if false_positive_rate is not in (0, 1)
+     */
+    static unsigned fingerprint_bits_for(size_t ngram_count, double false_positive_rate);
+
+    /**
+     * @brief Compute the fingerprint of an n-gram.
+     *
+     * @param ngram The n-gram
+     * @param fingerprint_bits The fingerprint width in bits
+     * @return uint64_t The fingerprint, in the range [0, 2^fingerprint_bits)
+     */
+    static uint64_t fingerprint(std::string_view ngram, unsigned fingerprint_bits);
+
+    /**
+     * @brief Check if the set contains an n-gram.
+     *
+     * @param ngram The n-gram to check
+     * @return true if the n-gram is a member or collides with a member's fingerprint
+     * @return false if the n-gram is definitely not a member
+     */
+    bool contains(std::string_view ngram) const;
+
+    /**
+     * @brief Get the number of distinct fingerprints in the set.
+     *
+     * @return size_t The count of fingerprints
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the fingerprint width in bits.
+     *
+     * @return unsigned The fingerprint width
+     */
+    unsigned fingerprint_bits() const;
+
+    /**
+     * @brief Get the expected false-positive rate for non-member lookups.
+     *
+     * @return double The probability `size / 2^fingerprint_bits`
+     */
+    double false_positive_rate() const;
+
+    /**
+     * @brief Get the memory used by the set.
+     *
+     * @return size_t The size of this object plus the size of its bit arrays in bytes
+     */
+    size_t memory_usage_bytes() const;
+
+    /**
+     * @brief Get the number of low bits stored verbatim per fingerprint.
+     *
+     * @return unsigned The low bit count
+     */
+    unsigned lower_bit_count() const;
+
+    /**
+     * @brief Get the number of high-bit buckets.
+     *
+     * @return uint64_t The bucket count
+     */
+    uint64_t bucket_count() const;
+
+    /**
+     * @brief Get the packed low bits.
+     *
+     * @return std::span<const uint64_t> The low bit words
+     */
+    std::span<const uint64_t> lower_bits() const;
+
+    /**
+     * @brief Get the unary-coded high bits.
+     *
+     * @return std::span<const uint64_t> The high bit words
+     */
+    std::span<const uint64_t> upper_bits() const;
+
+    /**
+     * @brief Get the sampled positions of zeros in the high bits.
+     *
+     * @return std::span<const uint64_t> The zero positions
+     */
+    std::span<const uint64_t> zero_samples() const;
+
+private:
+    // Number of zeros in upper_bits_ between two entries of zero_samples_
+    static constexpr size_t SELECT_SAMPLE_RATE = 256;
+
+    size_t size_ = 0;
+    unsigned fingerprint_bits_ = 0;
+    unsigned lower_bit_count_ = 0;
+    uint64_t bucket_count_ = 0;
+    std::span<const uint64_t> lower_bits_;
+    std::span<const uint64_t> upper_bits_;
+    std::span<const uint64_t> zero_samples_;
+    std::shared_ptr<const void> owner_;
+
+    bool contains_fingerprint(uint64_t fingerprint) const;
+    uint64_t lower_bits_at(size_t index) const;
+    bool upper_bit_at(uint64_t position) const;
+    uint64_t select_zero(uint64_t rank) const;
+};
+
+} // namespace lingua
+
+#endif // LINGUA_FINGERPRINT_SET_H
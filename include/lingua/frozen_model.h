@@ -0,0 +1,304 @@
+#ifndef LINGUA_FROZEN_MODEL_H
+#define LINGUA_FROZEN_MODEL_H
+
+#include "lingua/fingerprint_set.h"
+#include "lingua/language.h"
+#include "lingua/mapped_file.h"
+#include "lingua/model_kind.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace lingua {
+
+/**
+ * @brief Layout of the n-gram data in a frozen model block
+ */
+enum class FrozenModelLayout : uint8_t {
+    /**
+     * @brief Exact keys in an open-addressing hash index, with optional values
+     */
+    HASH_TABLE = 0,
+
+    /**
+     * @brief Elias-Fano coded n-gram fingerprints, see FingerprintSet
+     */
+    FINGERPRINTS = 1,
+
+    /**
+     * @brief 16-bit fingerprints of n-gram hashes in an open-addressing hash index,
+     * with optional values and no keys, see NgramHasher
+     */
+    HASHED_NGRAMS = 2
+};
+
+/**
+ * @brief Location of a section inside a frozen model block
+ */
+struct FrozenModelSection {
+    uint64_t offset;
+    uint64_t size;
+};
+
+/**
+ * @brief Header at the start of every frozen model block.
+ *
+ * A block is a single contiguous, 8-byte aligned allocation that refers to its
+ * sections by offset only, so it can be copied, written to disk or mapped at any
+ * address. All fields are in host byte order; byte_order tells readers whether
+ * the block was written on a machine with the same endianness.
+ *
+ * With the HASH_TABLE layout the sections are, in order:
+ *  - hash index: `uint64_t[slot_count]`, each slot holding the top 32 bits of the
+ *    key hash and the entry index + 1 (0 marks an empty slot), linearly probed
+ *  - key offsets: `uint32_t[ngram_count + 1]` into the key bytes
+ *  - key bytes: the UTF-8 n-grams, sorted and concatenated
+ *  - value indices: `uint16_t` or `uint32_t[ngram_count]` into the value table
+ *  - value table: the distinct probabilities as `double[value_count]`
+ *
+ * With the FINGERPRINTS layout the sections are the low bits, high bits and zero
+ * samples of a FingerprintSet, and slot_count holds its bucket count.
+ *
+ * With the HASHED_NGRAMS layout the n-gram hashes of NgramHasher index the slots
+ * directly and no key is stored. The sections are:
+ *  - slot fingerprints: `uint16_t[slot_count]`, each slot holding
+ *    hash_fingerprint() of the hash stored there (0 marks an empty slot), linearly probed
+ *  - two empty sections
+ *  - value indices: `uint16_t` or `uint32_t[slot_count]`, per slot, into the value table
+ *  - value table: the distinct probabilities as `double[value_count]`
+ */
+struct FrozenModelHeader {
+    static constexpr char MAGIC[8] = {'L', 'N', 'G', 'A', 'M', 'O', 'D', 'L'};
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    static constexpr uint32_t FORMAT_VERSION = 1;
+    static constexpr size_t SECTION_COUNT = 5;
+
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t format_version;
+    uint64_t total_size;
+    char iso_code[4];
+    uint8_t ngram_length;
+    uint8_t kind;
+    uint8_t layout;
+    uint8_t value_index_width;
+    uint32_t fingerprint_bits;
+    uint32_t lower_bit_count;
+    uint64_t ngram_count;
+    uint64_t slot_count;
+    uint64_t value_count;
+    FrozenModelSection sections[SECTION_COUNT];
+};
+
+static_assert(sizeof(FrozenModelHeader) % 8 == 0, "frozen model sections must stay 8-byte aligned");
+
+/**
+ * @brief Immutable, contiguous n-gram model.
+ *
+ * A FrozenModel is produced by ModelBuilder::freeze() or read from a block written
+ * by write_to(). It never changes after construction, so it can be shared between
+ * threads without locking. Copies share the same block.
+ */
+class FrozenModel {
+public:
+    /**
+     * @brief Wrap an existing block without copying it.
+     *
+     * The header and section bounds are checked here. The contents of the
+     * sections are not read, so that a mapped block stays unpaged, but lookups
+     * bound their probes and check every index and offset they read, so a
+     * corrupt block yields wrong answers rather than out-of-bounds reads or
+     * endless probing.
+     *
+     * @param bytes The block, 8-byte aligned
+     * @param owner Keeps the block alive for as long as the model or its copies exist
+     * @return FrozenModel The model
+     * @throws ModelLoadException if the block is malformed
+     */
+    static FrozenModel from_bytes(std::span<const std::byte> bytes, std::shared_ptr<const void> owner);
+
+    /**
+     * @brief Read a block written by write_to().
+     *
+     * @param file_path Path to the block file
+     * @param pages The page size policy of the memory the block is read into
+     * @return FrozenModel The model
+     * @throws ModelLoadException if the file cannot be read or is malformed
+     */
+    static FrozenModel read_from(const std::string& file_path, PagePolicy pages = PagePolicy::DEFAULT);
+
+    /**
+     * @brief Map a block written by write_to() without reading it.
+     *
+     * Only the header page is touched; the rest of the block is paged in as
+     * lookups reach it, and is shared with other processes mapping the same file.
+     *
+     * @param file_path Path to the block file
+     * @param options The page-fault profile of the mapping
+     * @return FrozenModel The model, which keeps the mapping alive
+     * @throws ModelLoadException if the file cannot be mapped or is malformed
+     */
+    static FrozenModel map_from(const std::string& file_path, const MappingOptions& options = {});
+
+    /**
+     * @brief Write the block to a file.
+     *
+     * @param file_path Path to the block file
+     * @throws ModelLoadException if the file cannot be written
+     */
+    void write_to(const std::string& file_path) const;
+
+    /**
+     * @brief Get the language this model represents
+     *
+     * @return Language The language
+     */
+    Language get_language() const;
+
+    /**
+     * @brief Get the length of the n-grams in this model
+     *
+     * @return size_t The n-gram length (1-5)
+     */
+    size_t get_ngram_length() const;
+
+    /**
+     * @brief Get the kind of data this model holds
+     *
+     * @return ModelKind The model kind
+     */
+    ModelKind get_kind() const;
+
+    /**
+     * @brief Get the layout of the n-gram data
+     *
+     * @return FrozenModelLayout The layout
+     */
+    FrozenModelLayout get_layout() const;
+
+    /**
+     * @brief Get the number of n-grams in the model
+     *
+     * @return size_t The count of n-grams
+     */
+    size_t size() const;
+
+    /**
+     * @brief Check if the model contains an n-gram
+     *
+     * @param ngram The UTF-8 bytes of the n-gram
+     * @return true if the n-gram exists in the model
+     * @return false if the n-gram does not exist in the model
+     */
+    bool contains(std::string_view ngram) const;
+
+    /**
+     * @brief Get the probability of an n-gram
+     *
+     * @param ngram The UTF-8 bytes of the n-gram
+     * @return double The probability, or 0.0 if not found or the model has no probabilities
+     */
+    double get_probability(std::string_view ngram) const;
+
+    /**
+     * @brief Check if a HASHED_NGRAMS model contains an n-gram, given its hash.
+     *
+     * A hash that is not in the model is reported as present when it probes a
+     * slot holding the same 16-bit fingerprint, see false_positive_rate().
+     *
+     * @param ngram_hash The n-gram hash, see NgramHasher
+     * @return true if the model has the layout HASHED_NGRAMS and the hash was found
+     */
+    bool contains_hash(uint64_t ngram_hash) const;
+
+    /**
+     * @brief Get the probability of an n-gram of a HASHED_NGRAMS model, given its hash.
+     *
+     * @param ngram_hash The n-gram hash, see NgramHasher
+     * @return double The probability, or 0.0 if not found, the model has no probabilities or another layout
+     */
+    double get_probability_by_hash(uint64_t ngram_hash) const;
+
+    /**
+     * @brief Get the fingerprint a HASHED_NGRAMS slot keeps of an n-gram hash.
+     *
+     * The fingerprint is taken from the top bits, and the slot from the low
+     * bits, so the two are independent.
+     *
+     * @param ngram_hash The n-gram hash
+     * @return uint16_t The fingerprint, never 0
+     */
+    static constexpr uint16_t hash_fingerprint(uint64_t ngram_hash) noexcept {
+        const auto fingerprint = static_cast<uint16_t>(ngram_hash >> 48);
+        return fingerprint == 0 ? 1 : fingerprint;
+    }
+
+    /**
+     * @brief Get the n-gram stored at an entry of a HASH_TABLE model.
+     *
+     * Entries are sorted by their UTF-8 bytes.
+     *
+     * @param index The entry index, less than size()
+     * @return std::string_view The n-gram
+     */
+    std::string_view ngram_at(size_t index) const;
+
+    /**
+     * @brief Get the probability stored at an entry of a HASH_TABLE model.
+     *
+     * @param index The entry index, less than size()
+     * @return double The probability, or 0.0 if the model has no probabilities
+     */
+    double probability_at(size_t index) const;
+
+    /**
+     * @brief Get the probability that a non-member n-gram is reported as present
+     *
+     * @return double The false-positive rate, 0.0 for HASH_TABLE models; for HASHED_NGRAMS models an
+     *         estimate from the load of the index
+     */
+    double false_positive_rate() const;
+
+    /**
+     * @brief Get the raw block
+     *
+     * @return std::span<const std::byte> The block bytes
+     */
+    std::span<const std::byte> bytes() const;
+
+    /**
+     * @brief Get the memory used by the model
+     *
+     * @return size_t The size of this object plus the size of its block in bytes
+     */
+    size_t memory_usage_bytes() const;
+
+private:
+    std::shared_ptr<const void> owner_;
+    std::span<const std::byte> bytes_;
+    const FrozenModelHeader* header_ = nullptr;
+    Language language_ = Language::ENGLISH;
+    const uint64_t* slots_ = nullptr;
+    const uint16_t* slot_fingerprints_ = nullptr;
+    uint64_t slot_mask_ = 0;
+    const uint32_t* key_offsets_ = nullptr;
+    const char* key_bytes_ = nullptr;
+    uint64_t key_byte_count_ = 0;
+    const std::byte* value_indices_ = nullptr;
+    const double* values_ = nullptr;
+    FingerprintSet fingerprints_;
+
+    FrozenModel() = default;
+
+    int64_t find_entry(std::string_view ngram) const;
+    int64_t find_hashed_slot(uint64_t ngram_hash) const;
+    uint32_t value_index_at(size_t index) const;
+    double value_at(size_t index) const;
+};
+
+} // namespace lingua
+
+#endif // LINGUA_FROZEN_MODEL_H
@@ -0,0 +1,80 @@
+#ifndef LINGUA_HASH_H
+#define LINGUA_HASH_H
+
+#include <cstdint>
+#include <string_view>
+
+namespace lingua {
+
+/**
+ * @brief Finalizes a 64-bit value so that every input bit affects every output bit.
+ *
+ * This is the splitmix64 finalizer. It is used on top of the byte hash below so that
+ * the high bits of the result are as well distributed as the low bits, which matters
+ * for fingerprints that keep only the top bits of a hash.
+ *
+ * @param value The value to mix
+ * @return uint64_t The mixed value
+ */
+constexpr uint64_t mix_hash(uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+/**
+ * @brief Computes a 64-bit hash of the UTF-8 bytes of an n-gram.
+ *
+ * The hash is stable across platforms and builds, so fingerprints derived from it
+ * may be persisted.
+ *
+ * @param bytes The bytes to hash
+ * @return uint64_t The hash value
+ */
+constexpr uint64_t hash_bytes(std::string_view bytes) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (char c : bytes) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return mix_hash(hash ^ bytes.size());
+}
+
+/**
+ * @brief Multiplier of the polynomial hash of n-gram code points
+ */
+inline constexpr uint64_t NGRAM_HASH_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+/**
+ * @brief Extends the polynomial hash of an n-gram by one code point.
+ *
+ * The polynomial hash of code points c1..cn is the sum of (ci + 1) * M^(n-i)
+ * modulo 2^64, so the hash of the n-gram ending at a code point follows from
+ * the hash of the (n-1)-gram ending at the one before. That gives the hashes of
+ * every 1- to 5-gram ending at each position of a text in constant time per
+ * position. Start from 0 for the empty n-gram.
+ *
+ * @param hash The polynomial hash of the n-gram so far
+ * @param code_point The next code point
+ * @return uint64_t The polynomial hash of the extended n-gram
+ */
+constexpr uint64_t extend_ngram_hash(uint64_t hash, char32_t code_point) {
+    return hash * NGRAM_HASH_MULTIPLIER + code_point + 1;
+}
+
+/**
+ * @brief Turns a polynomial n-gram hash into the n-gram hash models are keyed by.
+ *
+ * @param polynomial_hash The hash built by extend_ngram_hash()
+ * @return uint64_t The mixed hash, with well distributed low and high bits
+ */
+constexpr uint64_t finish_ngram_hash(uint64_t polynomial_hash) {
+    return mix_hash(polynomial_hash);
+}
+
+} // namespace lingua
+
+#endif // LINGUA_HASH_H
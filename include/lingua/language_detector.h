@@ -4,6 +4,7 @@
 #include "language.h"
 #include "detection_result.h"
 #include "exception.h"
+#include "model_loader.h"
 
 #include <optional>
 #include <string>
@@ -93,9 +94,29 @@ public:
     /**
      * @brief Clears all language models loaded by this LanguageDetector instance
      * and frees allocated memory previously consumed by the models.
+     *
+     * Pinned models stay loaded. Detections that are running, on this or any other
+     * detector sharing the models, are not blocked and finish with the models they
+     * started with; later detections load the models again.
      */
     void unload_language_models();
 
+    /**
+     * @brief Reports the memory used by the language models of this detector's languages
+     * that are currently loaded.
+     *
+     * @return ModelMemoryReport The per-model usage and totals
+     */
+    ModelMemoryReport memory_report() const;
+
+    /**
+     * @brief Reports how long preloading the language models took when this detector was built.
+     *
+     * @return The number, size and load times of the preloaded models, or std::nullopt if
+     * the detector was not built with preloaded language models
+     */
+    const std::optional<ModelPreloadReport>& preload_report() const;
+
 private:
     friend class LanguageDetectorBuilder;
     
@@ -103,12 +124,14 @@ private:
         std::unordered_set<Language> languages,
         double minimum_relative_distance,
         bool is_every_language_model_preloaded,
-        bool is_low_accuracy_mode_enabled);
+        bool is_low_accuracy_mode_enabled,
+        const ModelPreloadCallback& on_preload_progress = {});
 
     std::unordered_set<Language> languages_;
     double minimum_relative_distance_;
     bool is_low_accuracy_mode_enabled_;
     bool is_built_from_one_language_;
+    std::optional<ModelPreloadReport> preload_report_;
     // Language model storage would be added here
 };
 
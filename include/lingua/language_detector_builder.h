@@ -99,6 +99,14 @@ public:
      */
     LanguageDetectorBuilder& with_preloaded_language_models();
 
+    /** 
+     * @brief Configures LanguageDetectorBuilder to preload all language models when creating
+     * the instance of LanguageDetector, reporting the progress after each loaded model.
+     *
+     * @param on_progress Called from the model loader's threads, one call at a time
+     */
+    LanguageDetectorBuilder& with_preloaded_language_models(ModelPreloadCallback on_progress);
+
     /** 
      * @brief Disables the high accuracy mode in order to save memory and increase performance.
      */
@@ -115,6 +123,7 @@ private:
     std::unordered_set<Language> languages_;
     double minimum_relative_distance_ = 0.0;
     bool is_every_language_model_preloaded_ = false;
+    ModelPreloadCallback preload_progress_callback_;
     bool is_low_accuracy_mode_enabled_ = false;
 };
 
@@ -8,6 +8,10 @@
 #include "language_detector_builder.h"
 #include "text_processor.h"
 #include "ngram.h"
+#include "ngram_extractor.h"
+#include "ngram_hasher.h"
+#include "text_normalizer.h"
+#include "unicode.h"
 #include "alphabet.h"
 
 #endif // LINGUA_LINGUA_H_
\ No newline at end of file
@@ -0,0 +1,202 @@
+#ifndef LINGUA_MAPPED_FILE_H
+#define LINGUA_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace lingua {
+
+/**
+ * @brief Access pattern hint given to the kernel for a mapped file
+ */
+enum class MappingAdvice {
+    /**
+     * @brief Default read-ahead
+     */
+    NORMAL,
+
+    /**
+     * @brief MADV_RANDOM: no read-ahead, each fault reads a single page
+     */
+    RANDOM,
+
+    /**
+     * @brief MADV_WILLNEED: start reading the whole file in the background
+     */
+    WILLNEED
+};
+
+/**
+ * @brief Page size used for model memory
+ */
+enum class PagePolicy {
+    /**
+     * @brief Base pages (4 KiB on x86-64)
+     */
+    DEFAULT,
+
+    /**
+     * @brief Transparent huge pages (MADV_HUGEPAGE) on memory aligned to ModelMemory::HUGE_PAGE_SIZE.
+     *
+     * Random probes into a large table then miss the TLB far less often. Falls
+     * back to base pages for regions smaller than a huge page and where the
+     * kernel does not offer them; mapped files only get them on file systems
+     * that support it, such as tmpfs with huge=advise.
+     */
+    HUGE_PAGES
+};
+
+/**
+ * @brief Page-fault profile of a mapped file.
+ *
+ * The default maps lazily: pages are read on first access and shared with every
+ * other process mapping the same file.
+ */
+struct MappingOptions {
+    /**
+     * @brief Prefault the whole file when it is mapped (MAP_POPULATE)
+     */
+    bool populate = false;
+
+    /**
+     * @brief Access pattern hint (madvise)
+     */
+    MappingAdvice advice = MappingAdvice::NORMAL;
+
+    /**
+     * @brief Lock the pages in memory (mlock), subject to RLIMIT_MEMLOCK
+     */
+    bool lock = false;
+
+    /**
+     * @brief Page size of the mapping
+     */
+    PagePolicy pages = PagePolicy::DEFAULT;
+};
+
+/**
+ * @brief Read-only memory mapping of a whole file.
+ *
+ * On platforms without mmap the file is read into memory instead and the
+ * options are ignored.
+ */
+class MappedFile {
+public:
+    /**
+     * @brief Map a file read-only.
+     *
+     * @param file_path Path to the file
+     * @param options The page-fault profile
+     * @return std::shared_ptr<const MappedFile> The mapping, unmapped when the last owner is gone
+     * @throws ModelLoadException if the file cannot be opened, is empty, or cannot be mapped or locked
+     */
+    static std::shared_ptr<const MappedFile> open(const std::string& file_path, const MappingOptions& options = {});
+
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * @brief Get the mapped bytes, page-aligned
+     *
+     * @return std::span<const std::byte> The file contents
+     */
+    std::span<const std::byte> bytes() const;
+
+    /**
+     * @brief Get the number of mapped bytes currently resident in memory (mincore)
+     *
+     * @return size_t The resident bytes, rounded to whole pages
+     */
+    size_t resident_bytes() const;
+
+    /**
+     * @brief Check whether the kernel accepted huge pages for the mapping
+     *
+     * @return true if the mapping was advised with MADV_HUGEPAGE successfully
+     */
+    bool uses_huge_pages() const;
+
+private:
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+    bool locked_ = false;
+    bool huge_pages_ = false;
+    std::vector<uint64_t> fallback_;
+
+    MappedFile() = default;
+};
+
+/**
+ * @brief Zeroed, writable memory holding a frozen model block.
+ *
+ * Blocks are built or read into it and then only read, so it is allocated once
+ * at its final size. With PagePolicy::HUGE_PAGES, blocks of at least one huge
+ * page get an anonymous mapping aligned to HUGE_PAGE_SIZE and advised with
+ * MADV_HUGEPAGE; other blocks, and every block where that fails, live on the heap.
+ * Memory for a NUMA node is mapped and bound to the node (mbind) before its
+ * pages are first touched.
+ */
+class ModelMemory {
+public:
+    /**
+     * @brief Size and alignment of a transparent huge page on x86-64 and most AArch64 kernels
+     */
+    static constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+
+    /**
+     * @brief Allocate zeroed memory aligned to at least 8 bytes.
+     *
+     * @param size The number of bytes
+     * @param pages The page size policy
+     * @param numa_node The kernel id of the NUMA node to place the pages on, or -1 for no preference
+     * @return std::shared_ptr<ModelMemory> The memory, freed when the last owner is gone
+     */
+    static std::shared_ptr<ModelMemory> allocate(size_t size, PagePolicy pages = PagePolicy::DEFAULT,
+                                                 int numa_node = -1);
+
+    ~ModelMemory();
+
+    ModelMemory(const ModelMemory&) = delete;
+    ModelMemory& operator=(const ModelMemory&) = delete;
+
+    /**
+     * @brief Get the memory
+     *
+     * @return std::span<std::byte> The allocated bytes
+     */
+    std::span<std::byte> bytes() const;
+
+    /**
+     * @brief Check whether the kernel accepted huge pages for the memory
+     *
+     * @return true if the memory is an aligned mapping advised with MADV_HUGEPAGE successfully
+     */
+    bool uses_huge_pages() const;
+
+    /**
+     * @brief Check whether the memory is bound to the NUMA node it was allocated for
+     *
+     * @return true if the kernel accepted the node as the preferred one for the pages
+     */
+    bool is_bound_to_node() const;
+
+private:
+    std::byte* data_ = nullptr;
+    size_t size_ = 0;
+    size_t mapped_size_ = 0; // 0 if the memory is on the heap
+    bool huge_pages_ = false;
+    bool bound_to_node_ = false;
+    std::unique_ptr<uint64_t[]> heap_;
+
+    ModelMemory() = default;
+};
+
+} // namespace lingua
+
+#endif // LINGUA_MAPPED_FILE_H
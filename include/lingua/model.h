@@ -3,50 +3,43 @@
 
 #include "lingua/ngram.h"
 #include "lingua/language.h"
+#include "lingua/frozen_model.h"
+#include "lingua/model_kind.h"
+#include "lingua/numa.h"
+#include <memory>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <string_view>
 #include <cstdint>
+#include <vector>
 
 namespace lingua {
 
-/**
- * @brief Enum representing the type of n-gram model
- */
-enum class NgramModelType {
-    /**
-     * @brief Model containing unique n-grams for a language
-     */
-    UNIQUE,
-    
-    /**
-     * @brief Model containing most common n-grams for a language
-     */
-    MOST_COMMON
-};
-
-/**
- * @brief Converts NgramModelType to string representation
- * 
- * @param model_type The model type to convert
- * @return std::string The string representation
- */
-std::string to_string(NgramModelType model_type);
-
 /**
  * @brief Model for storing n-gram probabilities
  * 
  * This class represents a statistical language model based on n-gram probabilities.
- * It stores the probabilities of n-grams for a specific language.
+ * It is a read-only view of a FrozenModel; build models with ModelBuilder.
  */
 class NgramProbabilityModel {
 public:
     /**
      * @brief Constructs an NgramProbabilityModel
      * 
-     * @param language The language this model represents
+     * @param model The frozen probability model
+     * @throws std::invalid_argument if the model kind is not PROBABILITY
      */
-    explicit NgramProbabilityModel(Language language);
+    explicit NgramProbabilityModel(FrozenModel model);
+
+    /**
+     * @brief Constructs an NgramProbabilityModel with one replica of the model per NUMA node.
+     *
+     * Lookups read the replica of the node the calling thread runs on.
+     *
+     * @param replicas The replicas, indexed by node (see replicate_model())
+     * @param topology The nodes
+     * @throws std::invalid_argument if the replicas are not probability models or there is not one per node
+     */
+    NgramProbabilityModel(std::vector<FrozenModel> replicas, std::shared_ptr<const NumaTopology> topology);
     
     /**
      * @brief Get the language this model represents
@@ -62,14 +55,14 @@ public:
      * @return double The probability, or 0.0 if not found
      */
     double get_probability(const Ngram& ngram) const;
-    
+
     /**
-     * @brief Add or update the probability of an n-gram
+     * @brief Get the probability of an n-gram
      * 
-     * @param ngram The n-gram
-     * @param probability The probability value
+     * @param ngram The UTF-8 bytes of the n-gram to look up
+     * @return double The probability, or 0.0 if not found
      */
-    void set_probability(const Ngram& ngram, double probability);
+    double get_probability(std::string_view ngram) const;
     
     /**
      * @brief Check if the model contains a specific n-gram
@@ -79,6 +72,23 @@ public:
      * @return false if the n-gram does not exist in the model
      */
     bool contains(const Ngram& ngram) const;
+
+    /**
+     * @brief Check if the model contains a specific n-gram
+     * 
+     * @param ngram The UTF-8 bytes of the n-gram to check
+     * @return true if the n-gram exists in the model
+     * @return false if the n-gram does not exist in the model
+     */
+    bool contains(std::string_view ngram) const;
+
+    /**
+     * @brief Get the probability of an n-gram by its hash, without building the n-gram
+     * 
+     * @param ngram_hash The n-gram hash, see NgramHasher
+     * @return double The probability, or 0.0 if not found or the model is not frozen as hashed n-grams
+     */
+    double get_probability_by_hash(uint64_t ngram_hash) const;
     
     /**
      * @brief Get the number of n-grams in the model
@@ -87,26 +97,66 @@ public:
      */
     size_t size() const;
 
+    /**
+     * @brief Get the memory used by the model
+     * 
+     * @return size_t The size of this object plus its frozen blocks in bytes, counting every replica
+     */
+    size_t memory_usage_bytes() const;
+
+    /**
+     * @brief Get the number of copies of the model in memory
+     * 
+     * @return size_t 1, or the number of NUMA nodes if the model is replicated
+     */
+    size_t replica_count() const;
+
+    /**
+     * @brief Get the underlying frozen model
+     * 
+     * @return const FrozenModel& The frozen model, the replica of node 0 if the model is replicated
+     */
+    const FrozenModel& frozen_model() const;
+
 private:
-    Language language_;
-    std::unordered_map<std::string, double> ngrams_;
+    FrozenModel model_;
+    std::vector<FrozenModel> replicas_; // empty unless replicated
+    std::shared_ptr<const NumaTopology> topology_;
+
+    const FrozenModel& local_model() const;
 };
 
 /**
  * @brief Model for storing n-gram counts/sets
  * 
  * This class represents a language model based on sets of n-grams,
- * such as unique or most common n-grams for a language.
+ * such as unique or most common n-grams for a language. It is a read-only
+ * view of a FrozenModel; build models with ModelBuilder.
+ *
+ * A model is either exact, storing every n-gram in a hash table, or compact,
+ * storing only n-gram fingerprints. Compact models may report a non-member
+ * n-gram as present with the probability given by false_positive_rate().
  */
 class NgramCountModel {
 public:
     /**
      * @brief Constructs an NgramCountModel
      * 
-     * @param language The language this model represents
-     * @param model_type The type of model (UNIQUE or MOST_COMMON)
+     * @param model The frozen unique or most common n-gram set
+     * @throws std::invalid_argument if the model kind is PROBABILITY
      */
-    NgramCountModel(Language language, NgramModelType model_type);
+    explicit NgramCountModel(FrozenModel model);
+
+    /**
+     * @brief Constructs an NgramCountModel with one replica of the model per NUMA node.
+     *
+     * Lookups read the replica of the node the calling thread runs on.
+     *
+     * @param replicas The replicas, indexed by node (see replicate_model())
+     * @param topology The nodes
+     * @throws std::invalid_argument if the replicas are probability models or there is not one per node
+     */
+    NgramCountModel(std::vector<FrozenModel> replicas, std::shared_ptr<const NumaTopology> topology);
     
     /**
      * @brief Get the language this model represents
@@ -130,22 +180,23 @@ public:
      * @return false if the n-gram does not exist in the model
      */
     bool contains(const Ngram& ngram) const;
-    
+
     /**
-     * @brief Add an n-gram to the model
+     * @brief Check if the model contains a specific n-gram
      * 
-     * @param ngram The n-gram to add
+     * @param ngram The UTF-8 bytes of the n-gram to check
+     * @return true if the n-gram exists in the model
+     * @return false if the n-gram does not exist in the model
      */
-    void add_ngram(const Ngram& ngram);
-    
+    bool contains(std::string_view ngram) const;
+
     /**
-     * @brief Remove an n-gram from the model
+     * @brief Check if the model contains an n-gram by its hash, without building the n-gram
      * 
-     * @param ngram The n-gram to remove
-     * @return true if the n-gram was present and removed
-     * @return false if the n-gram was not present
+     * @param ngram_hash The n-gram hash, see NgramHasher
+     * @return true if the model is frozen as hashed n-grams and the hash was found
      */
-    bool remove_ngram(const Ngram& ngram);
+    bool contains_hash(uint64_t ngram_hash) const;
     
     /**
      * @brief Get the number of n-grams in the model
@@ -154,10 +205,48 @@ public:
      */
     size_t size() const;
 
+    /**
+     * @brief Check if the model stores fingerprints instead of n-grams
+     * 
+     * @return true if the model is compact
+     * @return false if the model stores every n-gram exactly
+     */
+    bool is_compact() const;
+
+    /**
+     * @brief Get the probability that a non-member n-gram is reported as present
+     * 
+     * @return double The false-positive rate, 0.0 for exact models
+     */
+    double false_positive_rate() const;
+
+    /**
+     * @brief Get the memory used by the model
+     * 
+     * @return size_t The size of this object plus its frozen blocks in bytes, counting every replica
+     */
+    size_t memory_usage_bytes() const;
+
+    /**
+     * @brief Get the number of copies of the model in memory
+     * 
+     * @return size_t 1, or the number of NUMA nodes if the model is replicated
+     */
+    size_t replica_count() const;
+
+    /**
+     * @brief Get the underlying frozen model
+     * 
+     * @return const FrozenModel& The frozen model, the replica of node 0 if the model is replicated
+     */
+    const FrozenModel& frozen_model() const;
+
 private:
-    Language language_;
-    NgramModelType model_type_;
-    std::unordered_set<std::string> ngrams_;
+    FrozenModel model_;
+    std::vector<FrozenModel> replicas_; // empty unless replicated
+    std::shared_ptr<const NumaTopology> topology_;
+
+    const FrozenModel& local_model() const;
 };
 
 } // namespace lingua
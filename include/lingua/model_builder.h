@@ -0,0 +1,190 @@
+#ifndef LINGUA_MODEL_BUILDER_H
+#define LINGUA_MODEL_BUILDER_H
+
+#include "lingua/frozen_model.h"
+#include "lingua/language.h"
+#include "lingua/model_kind.h"
+#include "lingua/thread_pool.h"
+#include <cstddef>
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lingua {
+
+/**
+ * @brief Mutable collection of n-grams that is frozen into a FrozenModel.
+ *
+ * N-gram bytes are copied once into an append-only arena, and a hash map indexes
+ * them for updates and removals. A builder is not thread-safe; freeze it and
+ * share the resulting FrozenModel instead.
+ */
+class ModelBuilder {
+public:
+    /**
+     * @brief Constructs an empty ModelBuilder
+     *
+     * @param language The language of the model
+     * @param ngram_length The length of the n-grams in the model (1-5)
+     * @param kind The kind of data the model holds
+     * @throws std::invalid_argument if ngram_length is not between 1 and 5
+     */
+    ModelBuilder(Language language, size_t ngram_length, ModelKind kind);
+
+    ModelBuilder(const ModelBuilder&) = delete;
+    ModelBuilder& operator=(const ModelBuilder&) = delete;
+    ModelBuilder(ModelBuilder&&) = default;
+    ModelBuilder& operator=(ModelBuilder&&) = default;
+
+    /**
+     * @brief Get the language of the model
+     *
+     * @return Language The language
+     */
+    Language get_language() const;
+
+    /**
+     * @brief Get the kind of data the model holds
+     *
+     * @return ModelKind The model kind
+     */
+    ModelKind get_kind() const;
+
+    /**
+     * @brief Add or update the probability of an n-gram
+     *
+     * @param ngram The UTF-8 bytes of the n-gram
+     * @param probability The probability value
+     * @throws std::logic_error if the model kind is not PROBABILITY
+     */
+    void set_probability(std::string_view ngram, double probability);
+
+    /**
+     * @brief Add an n-gram to a unique or most common n-gram set
+     *
+     * @param ngram The UTF-8 bytes of the n-gram
+     * @throws std::logic_error if the model kind is PROBABILITY
+     */
+    void add_ngram(std::string_view ngram);
+
+    /**
+     * @brief Remove an n-gram
+     *
+     * @param ngram The UTF-8 bytes of the n-gram
+     * @return true if the n-gram was present and removed
+     * @return false if the n-gram was not present
+     */
+    bool remove_ngram(std::string_view ngram);
+
+    /**
+     * @brief Check if the builder contains an n-gram
+     *
+     * @param ngram The UTF-8 bytes of the n-gram
+     * @return true if the n-gram exists
+     * @return false if the n-gram does not exist
+     */
+    bool contains(std::string_view ngram) const;
+
+    /**
+     * @brief Get the number of n-grams
+     *
+     * @return size_t The count of n-grams
+     */
+    size_t size() const;
+
+    /**
+     * @brief Reserve index space for a number of n-grams
+     *
+     * @param ngram_count The expected number of n-grams
+     */
+    void reserve(size_t ngram_count);
+
+    /**
+     * @brief Compact the n-grams into an exact, read-only hash table block
+     *
+     * @param pages The page size policy of the block's memory
+     * @return FrozenModel The frozen model
+     */
+    FrozenModel freeze(PagePolicy pages = PagePolicy::DEFAULT) const;
+
+    /**
+     * @brief Compact several builders of one model into a single exact hash table block.
+     *
+     * Each part is sorted on its own, on the pool if one is given, and the sorted
+     * parts are merged. An n-gram present in several parts keeps the probability
+     * of the last of them, as if the parts had been added to one builder in order.
+     * The result is identical to freezing a single builder holding every n-gram.
+     *
+     * @param parts The partial builders, all with the same language, n-gram length and kind
+     * @param pool The pool sorting the parts, or nullptr to sort them on the calling thread
+     * @param pages The page size policy of the block's memory
+     * @return FrozenModel The frozen model
+     * @throws std::invalid_argument if parts is empty or the parts describe different models
+     */
+    static FrozenModel freeze(std::span<const ModelBuilder> parts, ThreadPool* pool = nullptr,
+                              PagePolicy pages = PagePolicy::DEFAULT);
+
+    /**
+     * @brief Compact the n-grams into a read-only fingerprint block
+     *
+     * @param fingerprint_bits The fingerprint width in bits, see FingerprintSet
+     * @param pages The page size policy of the block's memory
+     * @return FrozenModel The frozen model
+     * @throws std::logic_error if the model kind is PROBABILITY
+     * @throws std::invalid_argument if fingerprint_bits is not between 8 and 64
+     */
+    FrozenModel freeze_fingerprints(unsigned fingerprint_bits, PagePolicy pages = PagePolicy::DEFAULT) const;
+
+    /**
+     * @brief Compact the n-grams into a read-only hashed n-gram block.
+     *
+     * The block keeps a 16-bit fingerprint of each n-gram's NgramHasher hash and
+     * the n-gram's probability, if any, but not the n-gram itself. It is looked
+     * up by hash, see FrozenModel::contains_hash().
+     *
+     * @param pages The page size policy of the block's memory
+     * @return FrozenModel The frozen model, with the layout HASHED_NGRAMS
+     * @throws std::invalid_argument if an n-gram is not valid UTF-8
+     */
+    FrozenModel freeze_hashed(PagePolicy pages = PagePolicy::DEFAULT) const;
+
+    /**
+     * @brief Re-freeze an exact hash table model as a hashed n-gram block.
+     *
+     * @param model The model, with the layout HASH_TABLE
+     * @param pages The page size policy of the block's memory
+     * @return FrozenModel The frozen model, with the layout HASHED_NGRAMS
+     * @throws std::invalid_argument if the model has another layout or an n-gram is not valid UTF-8
+     */
+    static FrozenModel freeze_hashed(const FrozenModel& model, PagePolicy pages = PagePolicy::DEFAULT);
+
+private:
+    // Size of each arena chunk; chunks are never reallocated, so views stay valid
+    static constexpr size_t ARENA_CHUNK_SIZE = 64 * 1024;
+
+    Language language_;
+    size_t ngram_length_;
+    ModelKind kind_;
+    std::deque<std::string> arena_;
+    std::unordered_map<std::string_view, double> ngrams_;
+
+    using Entry = std::pair<std::string_view, double>;
+
+    std::vector<Entry> sorted_entries() const;
+    static FrozenModel freeze_sorted(const std::vector<Entry>& entries, Language language, size_t ngram_length,
+                                     ModelKind kind, PagePolicy pages);
+    static FrozenModel freeze_hashed_entries(const std::vector<Entry>& entries, Language language, size_t ngram_length,
+                                             ModelKind kind, PagePolicy pages);
+
+    // Copies an n-gram into the arena; unstore drops the most recent copy again
+    std::string_view store(std::string_view ngram);
+    void unstore(std::string_view ngram);
+};
+
+} // namespace lingua
+
+#endif // LINGUA_MODEL_BUILDER_H
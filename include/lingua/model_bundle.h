@@ -0,0 +1,230 @@
+#ifndef LINGUA_MODEL_BUNDLE_H
+#define LINGUA_MODEL_BUNDLE_H
+
+#include "lingua/frozen_model.h"
+#include "lingua/language.h"
+#include "lingua/mapped_file.h"
+#include "lingua/model_kind.h"
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lingua {
+
+/**
+ * @brief How the models of a bundle are read
+ */
+enum class ModelBundleAccess {
+    /**
+     * @brief Map the whole bundle once; models are wrapped in place
+     */
+    MEMORY_MAP,
+
+    /**
+     * @brief Keep the bundle open and read each model with a single positioned read
+     */
+    PREAD
+};
+
+/**
+ * @brief Header at the start of a model bundle.
+ *
+ * A bundle is one file holding many frozen model blocks. The header points to
+ * an index of ModelBundleEntry records, written after the last block so that a
+ * bundle can be packed in one pass. All fields are in host byte order.
+ */
+struct ModelBundleHeader {
+    static constexpr char MAGIC[8] = {'L', 'N', 'G', 'A', 'B', 'N', 'D', 'L'};
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t format_version;
+    uint64_t entry_count;
+    uint64_t index_offset;
+    uint64_t total_size;
+};
+
+/**
+ * @brief Index record of one model in a bundle
+ */
+struct ModelBundleEntry {
+    char iso_code[4];
+    uint8_t ngram_length;
+    uint8_t kind;
+    uint8_t reserved[2];
+    uint64_t offset;
+    uint64_t size;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(ModelBundleHeader) % 8 == 0, "model blocks in a bundle must stay 8-byte aligned");
+static_assert(sizeof(ModelBundleEntry) == 32, "bundle index records are 32 bytes");
+
+/**
+ * @brief Read-only bundle of frozen models, opened once and shared.
+ *
+ * Every model is reached through the same file handle or mapping, so serving
+ * all models of a detector costs one open instead of one per model file.
+ */
+class ModelBundle {
+public:
+    /**
+     * @brief Open a bundle and read its index.
+     *
+     * @param bundle_path Path to the bundle
+     * @param access How models are read
+     * @param options The page-fault profile when access is MEMORY_MAP; only the page size policy, for
+     *                the memory models are read into, when access is PREAD
+     * @return std::shared_ptr<const ModelBundle> The bundle
+     * @throws ModelLoadException if the bundle cannot be opened or its header or index is invalid
+     */
+    static std::shared_ptr<const ModelBundle> open(
+        const std::string& bundle_path,
+        ModelBundleAccess access = ModelBundleAccess::MEMORY_MAP,
+        const MappingOptions& options = {}
+    );
+
+    ~ModelBundle();
+
+    ModelBundle(const ModelBundle&) = delete;
+    ModelBundle& operator=(const ModelBundle&) = delete;
+
+    /**
+     * @brief Get the index of the bundle
+     *
+     * @return std::span<const ModelBundleEntry> One record per model, in file order
+     */
+    std::span<const ModelBundleEntry> entries() const;
+
+    /**
+     * @brief Find the index record of a model
+     *
+     * @param language The language of the model
+     * @param ngram_length The length of n-grams in the model
+     * @param kind The kind of model
+     * @return const ModelBundleEntry* The record, or nullptr if the bundle does not hold the model
+     */
+    const ModelBundleEntry* find(Language language, size_t ngram_length, ModelKind kind) const;
+
+    /**
+     * @brief Load a model of the bundle.
+     *
+     * With MEMORY_MAP the model refers to the mapping, which stays alive for as
+     * long as the model does; verifying the checksum then reads the whole block.
+     *
+     * @param entry A record returned by entries() or find()
+     * @param verify_checksum Compare the block against the checksum in the index
+     * @return FrozenModel The model
+     * @throws ModelLoadException if the block cannot be read, is corrupt or fails the checksum
+     */
+    FrozenModel load(const ModelBundleEntry& entry, bool verify_checksum = true) const;
+
+    /**
+     * @brief Get how models are read
+     *
+     * @return ModelBundleAccess The access mode
+     */
+    ModelBundleAccess access() const;
+
+    /**
+     * @brief Get the path the bundle was opened from
+     *
+     * @return const std::string& The path
+     */
+    const std::string& path() const;
+
+    /**
+     * @brief Compute the checksum stored in the index for a block
+     *
+     * @param bytes The block, 8-byte aligned
+     * @return uint64_t The checksum
+     */
+    static uint64_t checksum(std::span<const std::byte> bytes);
+
+private:
+    struct File;
+
+    std::string path_;
+    ModelBundleAccess access_ = ModelBundleAccess::MEMORY_MAP;
+    std::shared_ptr<const MappedFile> mapping_;
+    std::unique_ptr<File> file_;
+    PagePolicy pages_ = PagePolicy::DEFAULT;
+    uint64_t size_ = 0;
+    std::vector<ModelBundleEntry> entries_;
+    std::unordered_map<uint64_t, size_t> entry_by_key_;
+
+    ModelBundle();
+
+    void read_at(uint64_t offset, void* destination, size_t size) const;
+};
+
+/**
+ * @brief Writes a model bundle in one pass.
+ *
+ * Blocks are appended to a temporary file next to the target; finish() writes
+ * the index and header and renames the file into place, so readers never see
+ * a partial bundle.
+ */
+class ModelBundleWriter {
+public:
+    /**
+     * @brief Start a bundle
+     *
+     * @param bundle_path Path of the bundle to create or replace
+     * @throws ModelLoadException if the temporary file cannot be created
+     */
+    explicit ModelBundleWriter(const std::string& bundle_path);
+
+    /**
+     * @brief Removes the temporary file unless finish() was called
+     */
+    ~ModelBundleWriter();
+
+    ModelBundleWriter(const ModelBundleWriter&) = delete;
+    ModelBundleWriter& operator=(const ModelBundleWriter&) = delete;
+
+    /**
+     * @brief Append a model
+     *
+     * @param model The model
+     * @throws std::invalid_argument if the bundle already holds a model of the same language, length and kind
+     * @throws ModelLoadException if the model cannot be written
+     */
+    void add(const FrozenModel& model);
+
+    /**
+     * @brief Get the number of models added so far
+     *
+     * @return size_t The model count
+     */
+    size_t size() const;
+
+    /**
+     * @brief Write the index and header and move the bundle into place
+     *
+     * @return uint64_t The size of the bundle in bytes
+     * @throws ModelLoadException if the bundle cannot be written
+     */
+    uint64_t finish();
+
+private:
+    std::string bundle_path_;
+    std::string temporary_path_;
+    std::ofstream file_;
+    uint64_t offset_ = 0;
+    std::vector<ModelBundleEntry> entries_;
+    bool finished_ = false;
+
+    void write(const void* data, size_t size);
+};
+
+} // namespace lingua
+
+#endif // LINGUA_MODEL_BUNDLE_H
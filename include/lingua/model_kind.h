@@ -0,0 +1,71 @@
+#ifndef LINGUA_MODEL_KIND_H
+#define LINGUA_MODEL_KIND_H
+
+#include <string>
+
+namespace lingua {
+
+/**
+ * @brief Enum representing the type of n-gram model
+ */
+enum class NgramModelType {
+    /**
+     * @brief Model containing unique n-grams for a language
+     */
+    UNIQUE,
+    
+    /**
+     * @brief Model containing most common n-grams for a language
+     */
+    MOST_COMMON
+};
+
+/**
+ * @brief Enum representing the kind of data a model file holds
+ */
+enum class ModelKind {
+    /**
+     * @brief N-grams with their probabilities
+     */
+    PROBABILITY,
+
+    /**
+     * @brief Set of unique n-grams
+     */
+    UNIQUE,
+
+    /**
+     * @brief Set of most common n-grams
+     */
+    MOST_COMMON
+};
+
+/**
+ * @brief Converts NgramModelType to string representation
+ * 
+ * @param model_type The model type to convert
+ * @return std::string The string representation
+ */
+std::string to_string(NgramModelType model_type);
+
+/**
+ * @brief Converts ModelKind to string representation
+ * 
+ * @param kind The model kind to convert
+ * @return std::string "probability", "unique" or "most_common"
+ */
+std::string to_string(ModelKind kind);
+
+/**
+ * @brief Get the model kind holding the n-gram sets of a model type
+ * 
+ * @param model_type The model type
+ * @return ModelKind The matching model kind
+ */
+constexpr ModelKind model_kind_of(NgramModelType model_type) {
+    return model_type == NgramModelType::UNIQUE ? ModelKind::UNIQUE : ModelKind::MOST_COMMON;
+}
+
+} // namespace lingua
+
+#endif // LINGUA_MODEL_KIND_H
@@ -2,19 +2,181 @@
 #define LINGUA_MODEL_LOADER_H
 
 #include "lingua/model.h"
+#include "lingua/model_builder.h"
+#include "lingua/model_bundle.h"
+#include "lingua/model_registry.h"
+#include "lingua/shared_model_store.h"
 #include "lingua/language.h"
+#include "lingua/thread_pool.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <map>
 #include <memory>
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <unordered_set>
 #include <shared_mutex>
+#include <vector>
 
 namespace lingua {
 
+/**
+ * @brief Memory used by one cached model.
+ */
+struct ModelMemoryUsage {
+    Language language;
+    size_t ngram_length;
+    std::string model_type; // "probability", "unique" or "most_common"
+    size_t ngram_count;
+    size_t bytes;
+};
+
+/**
+ * @brief Memory used by a set of cached models, broken down by language,
+ * n-gram length and model type.
+ */
+struct ModelMemoryReport {
+    std::vector<ModelMemoryUsage> models;
+    size_t total_bytes = 0;
+    std::map<Language, size_t> bytes_by_language;
+    std::map<size_t, size_t> bytes_by_ngram_length;
+    std::map<std::string, size_t> bytes_by_model_type;
+
+    /**
+     * @brief Add a model to the report and update the totals.
+     * 
+     * @param usage The memory used by the model
+     */
+    void add(ModelMemoryUsage usage);
+};
+
+/**
+ * @brief Progress of ModelLoader::prefetch() and preload_models(), reported after each loaded model.
+ */
+struct ModelPreloadProgress {
+    size_t loaded_count;
+    size_t total_count;
+    Language language;
+    size_t ngram_length;
+    ModelKind kind;
+    std::chrono::nanoseconds load_time; // Time spent loading this model
+};
+
+/**
+ * @brief Callback receiving the progress of ModelLoader::prefetch() and preload_models().
+ */
+using ModelPreloadCallback = std::function<void(const ModelPreloadProgress&)>;
+
+/**
+ * @brief Aggregate timing of ModelLoader::prefetch() and preload_models().
+ */
+struct ModelPreloadReport {
+    size_t model_count = 0;
+    size_t missing_count = 0; // Requested models without an embedded copy, bundle entry or file, which were skipped
+    size_t thread_count = 0;
+    size_t bytes = 0;
+    std::chrono::nanoseconds wall_time{0};
+    std::chrono::nanoseconds load_time{0}; // Sum of the load times of all models
+};
+
+/**
+ * @brief Where a model was loaded from.
+ */
+enum class ModelSource {
+    EMBEDDED,
+    BUNDLE,
+    BINARY_FILE,
+    JSON_FILE
+};
+
+/**
+ * @brief Get the name of a model source.
+ *
+ * @param source The model source
+ * @return std::string "embedded", "bundle", "binary" or "json"
+ */
+std::string to_string(ModelSource source);
+
+/**
+ * @brief Phase timings and sizes of one model load.
+ *
+ * Binary models, whether embedded, bundled or in files, only have a read phase,
+ * which includes mapping or checksum verification. Reading and decompressing a
+ * JSON model are interleaved chunk by chunk; each phase sums its own chunks.
+ */
+struct ModelLoadRecord {
+    Language language;
+    size_t ngram_length;
+    ModelKind kind;
+    ModelSource source;
+    std::chrono::nanoseconds read_time{0};
+    std::chrono::nanoseconds decompress_time{0};
+    std::chrono::nanoseconds parse_time{0};
+    std::chrono::nanoseconds freeze_time{0};
+    std::chrono::nanoseconds total_time{0};
+    size_t file_bytes = 0;         // The compressed JSON or the binary model as stored
+    size_t decompressed_bytes = 0; // The JSON, 0 for binary models
+    size_t ngram_count = 0;
+    size_t memory_bytes = 0;       // memory_usage_bytes() of the loaded model
+};
+
+/**
+ * @brief Model loads recorded by ModelLoader, with totals over all of them.
+ */
+struct ModelLoadStats {
+    /**
+     * @brief Most loads kept in `loads`; the totals include older loads too.
+     */
+    static constexpr size_t MAX_RECORDS = 4096;
+
+    std::vector<ModelLoadRecord> loads; // The most recent loads, oldest first
+    size_t load_count = 0;
+    std::chrono::nanoseconds read_time{0};
+    std::chrono::nanoseconds decompress_time{0};
+    std::chrono::nanoseconds parse_time{0};
+    std::chrono::nanoseconds freeze_time{0};
+    std::chrono::nanoseconds total_time{0};
+    size_t file_bytes = 0;
+    size_t decompressed_bytes = 0;
+    size_t ngram_count = 0;
+    size_t memory_bytes = 0;
+
+    /**
+     * @brief Add a load and update the totals, dropping the oldest record beyond MAX_RECORDS.
+     *
+     * @param record The load
+     */
+    void add(ModelLoadRecord record);
+};
+
 /**
  * @brief Thread-safe loader for language models with caching and brotli decompression.
  */
 class ModelLoader {
 public:
+    /**
+     * @brief Default false-positive rate of compact unique and most common n-gram models.
+     */
+    static constexpr double DEFAULT_COUNT_MODEL_FALSE_POSITIVE_RATE = 1e-6;
+
+    /**
+     * @brief File extension of the Brotli-compressed JSON models.
+     */
+    static constexpr const char* JSON_MODEL_EXTENSION = ".json.br";
+
+    /**
+     * @brief File extension of the precompiled binary models, see FrozenModel.
+     */
+    static constexpr const char* BINARY_MODEL_EXTENSION = ".lfm";
+
+    /**
+     * @brief File name prefix of the shared model stores, see set_shared_model_store().
+     */
+    static constexpr const char* SHARED_MODEL_STORE_PREFIX = "lingua-models-";
+
     /**
      * @brief Get the singleton instance of ModelLoader.
      * 
@@ -22,9 +184,23 @@ public:
      */
     static ModelLoader& get_instance();
 
+    /**
+     * @brief Get the path of a model file relative to the model root.
+     * 
+     * @param language The language of the model
+     * @param ngram_length The length of n-grams in the model (1-5)
+     * @param kind The kind of model
+     * @param extension JSON_MODEL_EXTENSION or BINARY_MODEL_EXTENSION
+     * @return std::string The path, e.g. "models/en/models/unique_trigrams.lfm"
+     */
+    static std::string model_file_path(Language language, size_t ngram_length, ModelKind kind, const std::string& extension);
+
     /**
      * @brief Load an n-gram probability model for a language.
      * 
+     * A precompiled binary model is used without any parsing when it exists;
+     * otherwise the JSON model is decompressed, parsed and frozen.
+     * 
      * @param language The language for which to load the model
      * @param ngram_length The length of n-grams in the model (1-5)
      * @return std::shared_ptr<const NgramProbabilityModel> Shared pointer to the loaded model
@@ -48,15 +224,442 @@ public:
         NgramModelType model_type
     );
 
+    /**
+     * @brief Parse a JSON model into a mutable builder, bypassing the cache and binary models.
+     *
+     * @param language The language of the model
+     * @param ngram_length The length of n-grams in the model (1-5)
+     * @param kind The kind of model
+     * @return ModelBuilder The parsed n-grams
+     * @throws std::invalid_argument if ngram_length is not between 1 and 5
+     * @throws std::runtime_error if the model file cannot be read
+     * @throws ModelLoadException if the model file is malformed
+     */
+    ModelBuilder parse_model(Language language, size_t ngram_length, ModelKind kind) const;
+
+    /**
+     * @brief Parse a JSON model and freeze it, bypassing the cache and binary models.
+     *
+     * Unique and most common n-gram models are frozen as fingerprints unless the
+     * count model false-positive rate is 0.0. This is what the model converter
+     * writes to binary model files. Large probability models are parsed in parts
+     * on the loader's thread pool, see set_thread_count().
+     *
+     * @param language The language of the model
+     * @param ngram_length The length of n-grams in the model (1-5)
+     * @param kind The kind of model
+     * @return FrozenModel The frozen model
+     * @throws std::invalid_argument if ngram_length is not between 1 and 5
+     * @throws std::runtime_error if the model file cannot be read
+     */
+    FrozenModel compile_model(Language language, size_t ngram_length, ModelKind kind) const;
+
+    /**
+     * @brief Set the false-positive rate of count models loaded from now on.
+     *
+     * Unique and most common n-gram models are only queried for membership, so by
+     * default they are loaded as compact fingerprint sets (see FingerprintSet), which
+     * take a few bytes per n-gram. A lookup of an n-gram that is not in such a model
+     * returns true with probability `rate`; the fingerprint width is chosen as
+     * `ceil(log2(size / rate))` bits. A rate of 0.0 loads exact hash tables instead.
+     * Binary count models are only used if their own false-positive rate does not
+     * exceed `rate`. Models that are already cached keep their representation until
+     * clear_cache().
+     *
+     * @param rate The false-positive rate, 0.0 for exact models
+     * @throws std::invalid_argument if rate is not in [0, 1)
+     */
+    void set_count_model_false_positive_rate(double rate);
+
+    /**
+     * @brief Get the false-positive rate of count models loaded from now on.
+     *
+     * @return double The false-positive rate, 0.0 for exact models
+     */
+    double get_count_model_false_positive_rate() const;
+
+    /**
+     * @brief Load every model of some languages in parallel and cache it.
+     *
+     * Waits for prefetch() of the probability, unique and most common n-gram
+     * models. Must not be called from a task of the loader's thread pool.
+     *
+     * @param languages The languages to load
+     * @param ngram_lengths The n-gram lengths to load (1-5)
+     * @param on_progress Called after each model, serialized, from a pool thread
+     * @return ModelPreloadReport The number, size and load times of the models
+     * @throws std::invalid_argument if an n-gram length is not between 1 and 5
+     * @throws ModelLoadException or std::runtime_error for the first model that
+     *         failed to load, after all other models have been attempted
+     */
+    ModelPreloadReport preload_models(
+        const std::unordered_set<Language>& languages,
+        const std::vector<size_t>& ngram_lengths,
+        const ModelPreloadCallback& on_progress = {}
+    );
+
+    /**
+     * @brief Start loading models of some languages in the background.
+     *
+     * The models are loaded and cached on the loader's thread pool, largest model
+     * file first, so that a long model does not start last. Models without an
+     * embedded copy, bundle entry or file are skipped and counted in the report's
+     * missing_count, and logged when load logging is enabled. Models that are
+     * already cached cost nothing, and models that another thread is loading,
+     * such as a detector being built, are waited for instead of loaded twice;
+     * likewise, loads started while the prefetch runs join its loads. Wait for
+     * the result with a timeout through std::future::wait_for().
+     *
+     * @param languages The languages to load
+     * @param ngram_lengths The n-gram lengths to load (1-5)
+     * @param kinds The kinds of models to load
+     * @param on_progress Called after each model, serialized, from a pool thread
+     * @return std::future<ModelPreloadReport> Ready once every model was attempted,
+     *         with the number, size and load times of the models, or the first
+     *         exception a model load or on_progress threw
+     * @throws std::invalid_argument if an n-gram length is not between 1 and 5
+     */
+    std::future<ModelPreloadReport> prefetch(
+        const std::unordered_set<Language>& languages,
+        const std::vector<size_t>& ngram_lengths,
+        const std::vector<ModelKind>& kinds = {ModelKind::PROBABILITY, ModelKind::UNIQUE, ModelKind::MOST_COMMON},
+        const ModelPreloadCallback& on_progress = {}
+    );
+
+    /**
+     * @brief Load new versions of the cached models of some languages in the background.
+     *
+     * Each model is loaded again from its current source, typically an updated
+     * binary model file, and published atomically in place of the cached version.
+     * Lookups are never blocked and return the new version once it is published;
+     * threads that already hold the old version keep using it, and it is freed
+     * once the last of them releases it. Models that are not cached, or that are evicted or
+     * unloaded before their new version is ready, are not loaded. A bundle keeps
+     * serving the file it was opened from; call set_model_bundle() again to pick
+     * up a new bundle first.
+     *
+     * @param languages The languages whose cached models to reload
+     * @param on_progress Called after each model, serialized, from a pool thread
+     * @return std::future<ModelPreloadReport> Ready once every model was attempted,
+     *         or the first exception; models that failed to load keep their old version
+     */
+    std::future<ModelPreloadReport> reload_models(
+        const std::unordered_set<Language>& languages,
+        const ModelPreloadCallback& on_progress = {}
+    );
+
+    /**
+     * @brief Load new versions of all cached models in the background, see reload_models().
+     *
+     * @param on_progress Called after each model, serialized, from a pool thread
+     * @return std::future<ModelPreloadReport> Ready once every model was attempted
+     */
+    std::future<ModelPreloadReport> reload_models(const ModelPreloadCallback& on_progress = {});
+
+    /**
+     * @brief Drop the cached models of some languages, except pinned ones.
+     *
+     * Never blocks: detections that are running keep the models they hold, which
+     * are freed once the last of them finishes. Loads of these models still in
+     * flight finish for their callers but are not cached. Later lookups load the
+     * models again.
+     *
+     * @param languages The languages whose models to drop
+     * @return size_t The memory_usage_bytes() of the dropped models
+     */
+    size_t unload_models(const std::unordered_set<Language>& languages);
+
+    /**
+     * @brief Set the number of threads used to load models.
+     *
+     * Tasks already queued on the current pool still complete.
+     *
+     * @param thread_count The number of threads, at least 1
+     * @throws std::invalid_argument if thread_count is 0
+     */
+    void set_thread_count(size_t thread_count);
+
+    /**
+     * @brief Get the number of threads used to load models.
+     *
+     * @return size_t The thread count, by default the number of hardware threads
+     */
+    size_t get_thread_count() const;
+
+    /**
+     * @brief Map binary models into memory instead of reading them, for models loaded from now on.
+     *
+     * Mapped models are paged in lazily as they are probed, so rarely used
+     * languages and n-gram lengths cost little resident memory, and their pages
+     * are shared by all processes on the host that map the same files. The
+     * options trade load time for first-query latency: `populate` and
+     * MappingAdvice::WILLNEED fault pages in up front, MappingAdvice::RANDOM
+     * disables read-ahead, and `lock` pins the pages in memory. JSON models are
+     * unaffected. Memory reports count the full size of mapped models. The
+     * options' page size policy replaces the one set with set_page_policy().
+     *
+     * @param enabled Whether to map binary models
+     * @param options The page-fault profile of the mappings
+     */
+    void set_memory_mapping(bool enabled, MappingOptions options = {});
+
+    /**
+     * @brief Check whether binary models are mapped instead of read.
+     *
+     * @return true if binary models loaded from now on are mapped
+     */
+    bool is_memory_mapping_enabled() const;
+
+    /**
+     * @brief Set the page size of the memory that models loaded from now on occupy.
+     *
+     * PagePolicy::HUGE_PAGES backs the blocks of models that are read, compiled
+     * from JSON or read from a bundle with huge pages, and advises mapped models
+     * and bundles to use them, which cuts the TLB misses of lookups into large
+     * models. Embedded models keep the pages of the executable. Cached models
+     * keep their pages until they are loaded again.
+     *
+     * @param pages The page size policy
+     */
+    void set_page_policy(PagePolicy pages);
+
+    /**
+     * @brief Get the page size policy of models loaded from now on.
+     *
+     * @return PagePolicy The policy
+     */
+    PagePolicy get_page_policy() const;
+
+    /**
+     * @brief Keep one replica of each model loaded from now on per NUMA node, within a memory limit.
+     *
+     * Lookups then read the replica in the memory of the node the calling thread
+     * runs on instead of crossing the interconnect. Each replicated model costs
+     * its size once more for every node beyond the first; models loaded while the
+     * replicas would outgrow replica_budget keep a single copy shared by all
+     * nodes. Replicas are private copies, so mapped models lose their sharing
+     * across processes. Nothing is replicated on a host with a single node.
+     *
+     * @param replica_budget The memory the extra replicas may take in bytes, 0 to keep a single copy of every model
+     * @param topology The nodes, nullptr for the host's (NumaTopology::system())
+     */
+    void set_numa_replication(size_t replica_budget, std::shared_ptr<const NumaTopology> topology = nullptr);
+
+    /**
+     * @brief Get the memory the extra NUMA replicas may take.
+     *
+     * @return size_t The budget in bytes, 0 if models are not replicated
+     */
+    size_t get_numa_replication_budget() const;
+
+    /**
+     * @brief Get the memory the extra NUMA replicas of live models take.
+     *
+     * Replicas are counted until the last reference to their model is gone.
+     *
+     * @return size_t The size of every replica beyond the first of each model, in bytes
+     */
+    size_t numa_replica_bytes() const;
+
+    /**
+     * @brief Set the directory that contains models/, for models loaded from now on.
+     *
+     * Model file paths, see model_file_path(), are resolved against this directory
+     * instead of the working directory. Cached models are kept until clear_cache().
+     *
+     * @param model_root The directory, or an empty string for the working directory
+     */
+    void set_model_root(const std::string& model_root);
+
+    /**
+     * @brief Get the directory that contains models/.
+     *
+     * @return std::string The directory, empty for the working directory
+     */
+    std::string get_model_root() const;
+
+    /**
+     * @brief Serve models from a bundle written by lingua_pack_models, for models loaded from now on.
+     *
+     * All models in the bundle are read through the bundle's single mapping or
+     * file handle; models missing from it are still loaded from their files.
+     * Embedded models take precedence over the bundle. Count models are only
+     * used if their false-positive rate does not exceed the configured one.
+     * Replaces any shared model store, see set_shared_model_store().
+     *
+     * @param bundle_path Path to the bundle, relative to the model root unless absolute; empty to stop using a bundle
+     * @param access MEMORY_MAP maps the bundle with the memory mapping options, PREAD reads each model with one positioned read
+     * @param verify_checksums Check every model against its checksum when it is loaded
+     * @throws ModelLoadException if the bundle cannot be opened or its index is invalid
+     */
+    void set_model_bundle(
+        const std::string& bundle_path,
+        ModelBundleAccess access = ModelBundleAccess::MEMORY_MAP,
+        bool verify_checksums = true
+    );
+
+    /**
+     * @brief Get the bundle models are served from.
+     *
+     * @return std::shared_ptr<const ModelBundle> The bundle, or nullptr if none is set
+     */
+    std::shared_ptr<const ModelBundle> get_model_bundle() const;
+
+    /**
+     * @brief Limit the memory used by cached models.
+     *
+     * When a load takes the cached models over the budget, the least recently
+     * used models are evicted until they fit again; larger models go first among
+     * models last used between the same two loads. Pinned models and the model
+     * just returned are never evicted, so they alone can exceed the budget.
+     * Evicted models are loaded again on their next use, so detectors keep
+     * working. Models count with their memory_usage_bytes(). Lowering the budget
+     * evicts immediately.
+     *
+     * @param bytes The budget in bytes, 0 for no limit (the default)
+     */
+    void set_memory_budget(size_t bytes);
+
+    /**
+     * @brief Get the memory budget of cached models.
+     *
+     * @return size_t The budget in bytes, 0 if unlimited
+     */
+    size_t get_memory_budget() const;
+
+    /**
+     * @brief Keep a model resident: it is never evicted, see set_memory_budget().
+     *
+     * The model is not loaded by pinning it. Pins are counted and survive clear_cache().
+     *
+     * @param language The language of the model
+     * @param ngram_length The length of n-grams in the model (1-5)
+     * @param kind The kind of model
+     * @throws std::invalid_argument if ngram_length is not between 1 and 5
+     */
+    void pin_model(Language language, size_t ngram_length, ModelKind kind);
+
+    /**
+     * @brief Release a pin taken with pin_model().
+     *
+     * @param language The language of the model
+     * @param ngram_length The length of n-grams in the model (1-5)
+     * @param kind The kind of model
+     * @return true if the model was pinned
+     * @throws std::invalid_argument if ngram_length is not between 1 and 5
+     */
+    bool unpin_model(Language language, size_t ngram_length, ModelKind kind);
+
+    /**
+     * @brief Get the counters of the model cache.
+     *
+     * @return ModelCacheStats The cached, pinned and resident models, the budget,
+     *         and the loads, reloads of evicted models and evictions so far
+     */
+    ModelCacheStats cache_stats() const;
+
+    /**
+     * @brief Get the loads recorded since startup or reset_load_stats().
+     *
+     * Only loads into the cache are recorded, not parse_model() or compile_model().
+     *
+     * @return ModelLoadStats A snapshot of the records and totals
+     */
+    ModelLoadStats load_stats() const;
+
+    /**
+     * @brief Forget the recorded loads.
+     */
+    void reset_load_stats();
+
+    /**
+     * @brief Log every model load as an spdlog event at info level on the default logger.
+     *
+     * @param enabled Whether to log loads; off by default
+     */
+    void set_load_logging(bool enabled);
+
+    /**
+     * @brief Serve the models of some languages from a store shared by all processes on the host.
+     *
+     * The first process builds the frozen models of the languages into one bundle
+     * file in `directory` and publishes it by renaming it into place; every other
+     * process, including ones that start while it builds, maps the same file
+     * read-only, so model memory per host does not grow with the number of
+     * processes. The file name carries a version derived from the languages, the
+     * model files (path, size and modification time), the count model
+     * false-positive rate and the file formats, so updated models or settings
+     * publish a new store. Stores of earlier versions are deleted once no process
+     * maps them anymore. Embedded models are not stored; they are shared through
+     * the executable already. Replaces any bundle set with set_model_bundle(); call
+     * clear_cache() or reload_models() for cached models to move to the store.
+     *
+     * @param languages The languages whose models to store
+     * @param directory A directory on a RAM-backed file system, by default /dev/shm
+     * @return std::shared_ptr<const SharedModelStore> The store
+     * @throws ModelLoadException if the store cannot be built, locked or mapped
+     */
+    std::shared_ptr<const SharedModelStore> set_shared_model_store(
+        const std::unordered_set<Language>& languages,
+        const std::string& directory = SharedModelStore::DEFAULT_DIRECTORY
+    );
+
+    /**
+     * @brief Get the shared model store models are served from.
+     *
+     * @return std::shared_ptr<const SharedModelStore> The store, or nullptr if none is set
+     */
+    std::shared_ptr<const SharedModelStore> get_shared_model_store() const;
+
+    /**
+     * @brief Report the memory used by all cached models.
+     * 
+     * @return ModelMemoryReport The per-model usage and totals
+     */
+    ModelMemoryReport memory_report() const;
+
+    /**
+     * @brief Report the memory used by the cached models of some languages.
+     * 
+     * @param languages The languages to report
+     * @return ModelMemoryReport The per-model usage and totals
+     */
+    ModelMemoryReport memory_report(const std::unordered_set<Language>& languages) const;
+
     /**
      * @brief Clear all cached models.
+     *
+     * Like unload_models(), this never invalidates models held by running detections.
      */
     void clear_cache();
 
 private:
-    mutable std::shared_mutex cache_mutex_;
-    std::unordered_map<std::string, std::shared_ptr<const NgramProbabilityModel>> probability_model_cache_;
-    std::unordered_map<std::string, std::shared_ptr<const NgramCountModel>> count_model_cache_;
+    static constexpr size_t LANGUAGE_COUNT = static_cast<size_t>(Language::ZULU) + 1;
+    static constexpr size_t MODEL_SLOT_COUNT = LANGUAGE_COUNT * 5 * 3;
+
+    mutable std::shared_mutex settings_mutex_;
+    std::atomic<double> count_model_false_positive_rate_{DEFAULT_COUNT_MODEL_FALSE_POSITIVE_RATE};
+    bool memory_mapping_enabled_ = false;
+    MappingOptions mapping_options_;
+    std::string model_root_;
+    std::shared_ptr<const ModelBundle> bundle_;
+    bool verify_bundle_checksums_ = true;
+    std::shared_ptr<const SharedModelStore> shared_store_;
+    size_t numa_replica_budget_ = 0;
+    std::shared_ptr<const NumaTopology> numa_topology_;
+    // Shared with the replicas, which give their bytes back when they are freed
+    std::shared_ptr<std::atomic<size_t>> numa_replica_bytes_ = std::make_shared<std::atomic<size_t>>(0);
+    mutable std::mutex pool_mutex_;
+    size_t thread_count_ = ThreadPool::default_thread_count();
+    mutable std::shared_ptr<ThreadPool> pool_;
+    std::atomic<uint64_t> access_clock_{0};
+    ModelRegistry<NgramProbabilityModel> probability_models_{MODEL_SLOT_COUNT, &access_clock_};
+    ModelRegistry<NgramCountModel> count_models_{MODEL_SLOT_COUNT, &access_clock_};
+    std::atomic<size_t> memory_budget_{0};
+    std::mutex eviction_mutex_;
+    mutable std::mutex load_stats_mutex_;
+    ModelLoadStats load_stats_;
+    std::atomic<bool> load_logging_enabled_{false};
 
     ModelLoader() = default;
     ~ModelLoader() = default;
@@ -66,48 +669,205 @@ private:
     ModelLoader& operator=(const ModelLoader&) = delete;
 
     /**
-     * @brief Generate a cache key for a model.
+     * @brief Get the registry slot of a model.
+     * 
+     * @param language The language
+     * @param ngram_length The n-gram length (1-5)
+     * @param kind The model kind
+     * @return size_t The slot, less than MODEL_SLOT_COUNT
+     */
+    static size_t model_slot(Language language, size_t ngram_length, ModelKind kind);
+
+    /**
+     * @brief Evict least recently used models until the cached models fit the budget.
+     * 
+     * @param kept_kind The kind of the model that must stay
+     * @param kept_slot The slot of the model that must stay
+     */
+    void enforce_memory_budget(ModelKind kept_kind, size_t kept_slot);
+
+    /**
+     * @brief Get the loader's thread pool, creating it on first use.
+     * 
+     * @return std::shared_ptr<ThreadPool> The pool, kept alive by the caller
+     */
+    std::shared_ptr<ThreadPool> thread_pool() const;
+
+    /**
+     * @brief Resolve a path relative to the model root.
+     * 
+     * @param relative_path A path returned by model_file_path()
+     * @return std::string The path to open
+     */
+    std::string resolve_model_path(const std::string& relative_path) const;
+
+    /**
+     * @brief Load a model from the embedded models, the bundle, its binary file or its JSON file, taking the first that exists and matches.
+     * 
+     * @param language The language
+     * @param ngram_length The n-gram length
+     * @param kind The model kind
+     * @param record Receives the source, phase times and sizes of the load
+     * @return FrozenModel The frozen model
+     */
+    FrozenModel load_frozen_model(Language language, size_t ngram_length, ModelKind kind, ModelLoadRecord& record) const;
+
+    /**
+     * @brief A model to load on the pool, see run_load_tasks().
+     */
+    struct ModelLoadTask {
+        Language language;
+        size_t ngram_length;
+        ModelKind kind;
+        uintmax_t size; // Stored or in-memory size; larger models are loaded first
+    };
+
+    /**
+     * @brief Load models on the loader's thread pool, largest first.
+     * 
+     * @param tasks The models
+     * @param on_progress Called after each model, serialized, from a pool thread
+     * @param reload Whether to replace cached models with new versions instead of loading missing ones
+     * @param missing_count The number of requested models that were skipped, for the report
+     * @return std::future<ModelPreloadReport> Ready once every model was attempted, or the first exception
+     */
+    std::future<ModelPreloadReport> run_load_tasks(
+        std::vector<ModelLoadTask> tasks,
+        const ModelPreloadCallback& on_progress,
+        bool reload,
+        size_t missing_count = 0
+    );
+
+    /**
+     * @brief Get a model from the cache, loading it on a miss.
+     * 
+     * @param language The language
+     * @param ngram_length The n-gram length
+     * @param kind The model kind
+     * @return size_t The memory used by the model
+     */
+    size_t load_model(Language language, size_t ngram_length, ModelKind kind);
+
+    /**
+     * @brief Load a new version of a model and publish it if the model is still cached.
+     * 
+     * @param language The language
+     * @param ngram_length The n-gram length
+     * @param kind The model kind
+     * @return size_t The memory used by the new version
+     */
+    size_t reload_model(Language language, size_t ngram_length, ModelKind kind);
+
+    /**
+     * @brief Load a model for the cache and record the load.
+     * 
+     * @tparam Model NgramProbabilityModel or NgramCountModel
+     * @param language The language
+     * @param ngram_length The n-gram length
+     * @param kind The model kind
+     * @return std::shared_ptr<const Model> The model
+     */
+    template <typename Model>
+    std::shared_ptr<const Model> load_and_record(Language language, size_t ngram_length, ModelKind kind);
+
+    /**
+     * @brief Replicate a model onto every NUMA node if replication is enabled and the budget allows it.
+     *
+     * @param model The model
+     * @param topology Set to the nodes of the replicas
+     * @return std::vector<FrozenModel> One replica per node, or none to keep the model as it is
+     */
+    std::vector<FrozenModel> replicate_for_numa(const FrozenModel& model,
+                                                std::shared_ptr<const NumaTopology>& topology) const;
+
+    /**
+     * @brief Record a finished load and log it if enabled.
+     * 
+     * @param record The load
+     */
+    void record_load(const ModelLoadRecord& record);
+
+    /**
+     * @brief compile_model(), timing its phases.
      * 
      * @param language The language
      * @param ngram_length The n-gram length
-     * @param model_type The model type (for count models)
-     * @return std::string The cache key
+     * @param kind The model kind
+     * @param record Receives the phase times and sizes, or nullptr
+     * @return FrozenModel The frozen model
      */
-    std::string generate_cache_key(Language language, size_t ngram_length, const std::string& model_type) const;
+    FrozenModel compile_model(Language language, size_t ngram_length, ModelKind kind, ModelLoadRecord* record) const;
 
     /**
      * @brief Load and decompress a model file.
      * 
+     * The file is read and decoded in chunks into a buffer owned by the calling
+     * thread and reused by its later loads, so no intermediate copies are made.
+     * The buffer is padded for simdjson, which can parse it in place.
+     * 
      * @param file_path Path to the compressed model file
-     * @return std::string Decompressed JSON content
+     * @param record Receives the read and decompression times and sizes, or nullptr
+     * @return std::string_view Decompressed JSON content, valid until the next call on this thread
      */
-    std::string load_and_decompress_model(const std::string& file_path) const;
+    std::string_view load_and_decompress_model(const std::string& file_path, ModelLoadRecord* record = nullptr) const;
 
     /**
-     * @brief Parse a probability model from JSON.
+     * @brief Parse a JSON model into a builder on the calling thread.
      * 
-     * @param json_content The JSON content
+     * @param json_content The JSON content, followed by simdjson padding
      * @param language The language
-     * @return std::shared_ptr<const NgramProbabilityModel> Shared pointer to the parsed model
+     * @param ngram_length The n-gram length
+     * @param kind The model kind
+     * @return ModelBuilder The parsed n-grams
+     * @throws ModelLoadException if a fraction is malformed
      */
-    std::shared_ptr<const NgramProbabilityModel> parse_probability_model(
-        const std::string& json_content, 
-        Language language
-    ) const;
+    static ModelBuilder parse_json_model(
+        std::string_view json_content,
+        Language language,
+        size_t ngram_length,
+        ModelKind kind
+    );
 
     /**
-     * @brief Parse a count model from JSON.
+     * @brief Parse a probability model from JSON.
+     * 
+     * @param json_content The JSON content, followed by simdjson padding
+     * @param builder The builder receiving the n-grams
+     * @throws ModelLoadException if the JSON or a fraction is malformed
+     */
+    static void parse_probability_model(std::string_view json_content, ModelBuilder& builder);
+
+    /**
+     * @brief Parse a probability model from JSON on the loader's thread pool.
+     *
+     * The fraction groups are split into contiguous parts of about equal size, each
+     * part is indexed by its own builder, and the partial builders are merged when
+     * frozen.
      * 
-     * @param json_content The JSON content
+     * @param json_content The JSON content, followed by simdjson padding
      * @param language The language
-     * @param model_type The model type
-     * @return std::shared_ptr<const NgramCountModel> Shared pointer to the parsed model
+     * @param ngram_length The n-gram length
+     * @param part_count The number of parts, at most the pool's thread count
+     * @param record Receives the parse and freeze times, or nullptr
+     * @return FrozenModel The frozen model, identical to the one parsed on one thread
+     * @throws ModelLoadException if a fraction is malformed
      */
-    std::shared_ptr<const NgramCountModel> parse_count_model(
-        const std::string& json_content, 
+    FrozenModel parse_probability_model_in_parallel(
+        std::string_view json_content,
         Language language,
-        NgramModelType model_type
+        size_t ngram_length,
+        size_t part_count,
+        ModelLoadRecord* record
     ) const;
+
+    /**
+     * @brief Parse a count model from JSON.
+     * 
+     * @param json_content The JSON content, followed by simdjson padding
+     * @param builder The builder receiving the n-grams
+     * @throws ModelLoadException if the JSON is malformed
+     */
+    static void parse_count_model(std::string_view json_content, ModelBuilder& builder);
 };
 
 } // namespace lingua
@@ -0,0 +1,386 @@
+#ifndef LINGUA_MODEL_REGISTRY_H
+#define LINGUA_MODEL_REGISTRY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lingua {
+
+/**
+ * @brief A cached model that may be evicted, see ModelRegistry::evictable_models().
+ */
+struct EvictableModel {
+    size_t slot;
+    uint64_t last_used; // Access clock value of the last lookup
+    size_t bytes;
+};
+
+/**
+ * @brief Counters of a model cache.
+ */
+struct ModelCacheStats {
+    size_t model_count = 0;
+    size_t pinned_count = 0;
+    size_t resident_bytes = 0;
+    size_t memory_budget = 0; // 0 if unlimited
+    uint64_t load_count = 0;
+    uint64_t reload_count = 0; // Loads of models that had been evicted
+    uint64_t eviction_count = 0;
+    uint64_t replace_count = 0; // New versions published over cached models
+};
+
+/**
+ * @brief Fixed array of model slots with lock-free lookups and single-flight loading.
+ *
+ * Each slot holds an atomic shared pointer, so a cache hit is one atomic load
+ * without locks, hashing or key building. The first thread that misses a slot
+ * loads the model; threads that miss the same slot meanwhile wait for that load
+ * instead of loading the model again, and receive its exception if it fails.
+ *
+ * Lookups stamp their slot with an access clock that only advances when a model
+ * is published, so hits rarely write and the stamps order the models by their
+ * last use between loads. Registries sharing a clock can be evicted from as one
+ * least recently used cache.
+ *
+ * @tparam Model The model type, providing memory_usage_bytes()
+ */
+template <typename Model>
+class ModelRegistry {
+public:
+    using Pointer = std::shared_ptr<const Model>;
+
+    /**
+     * @brief Create empty slots
+     *
+     * @param slot_count The number of slots
+     * @param clock The access clock, shared with other registries; nullptr for a clock of its own
+     */
+    explicit ModelRegistry(size_t slot_count, std::atomic<uint64_t>* clock = nullptr)
+        : slots_(std::make_unique<Slot[]>(slot_count)),
+          slot_count_(slot_count),
+          clock_(clock ? clock : &own_clock_) {}
+
+    ModelRegistry(const ModelRegistry&) = delete;
+    ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+    /**
+     * @brief Get the number of slots
+     *
+     * @return size_t The slot count
+     */
+    size_t slot_count() const {
+        return slot_count_;
+    }
+
+    /**
+     * @brief Get the model of a slot without loading it, and mark it as used
+     *
+     * @param slot The slot, less than slot_count()
+     * @return Pointer The model, or nullptr if the slot is empty
+     */
+    Pointer find(size_t slot) const {
+        Slot& entry = slots_[slot];
+        Pointer model = entry.model.load(std::memory_order_acquire);
+        if (model) {
+            const uint64_t now = clock_->load(std::memory_order_relaxed);
+            if (entry.last_used.load(std::memory_order_relaxed) != now) {
+                entry.last_used.store(now, std::memory_order_relaxed);
+            }
+        }
+        return model;
+    }
+
+    /**
+     * @brief Get the model of a slot without loading it or marking it as used
+     *
+     * @param slot The slot, less than slot_count()
+     * @return Pointer The model, or nullptr if the slot is empty
+     */
+    Pointer peek(size_t slot) const {
+        return slots_[slot].model.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Get the model of a slot, loading it on a miss
+     *
+     * @param slot The slot, less than slot_count()
+     * @param load A callable returning the model as a Pointer; called at most once per miss across all threads
+     * @return Pointer The model
+     * @throws Whatever load threw, to the loading thread and every thread that waited for it
+     */
+    template <typename Load>
+    Pointer get_or_load(size_t slot, Load&& load) {
+        if (Pointer model = find(slot)) {
+            return model;
+        }
+
+        std::promise<Pointer> promise;
+        std::shared_future<Pointer> pending;
+        uint64_t generation;
+        uint64_t epoch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // Published between the lookup and the lock
+            if (Pointer model = find(slot)) {
+                return model;
+            }
+            generation = generation_;
+            epoch = slots_[slot].epoch;
+            auto it = in_flight_.find(slot);
+            if (it != in_flight_.end()) {
+                pending = it->second;
+            } else {
+                in_flight_.emplace(slot, promise.get_future().share());
+            }
+        }
+        if (pending.valid()) {
+            return pending.get();
+        }
+
+        Pointer model;
+        try {
+            model = std::forward<Load>(load)();
+        } catch (...) {
+            finish(slot, generation, epoch, nullptr);
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        finish(slot, generation, epoch, model);
+        promise.set_value(model);
+        return model;
+    }
+
+    /**
+     * @brief Keep the model of a slot from being evicted, including a model loaded later.
+     *
+     * Pins are counted; the slot is evictable again once every pin is released.
+     *
+     * @param slot The slot, less than slot_count()
+     */
+    void pin(size_t slot) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++slots_[slot].pin_count;
+    }
+
+    /**
+     * @brief Release a pin taken with pin()
+     *
+     * @param slot The slot, less than slot_count()
+     * @return true if the slot was pinned
+     */
+    bool unpin(size_t slot) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (slots_[slot].pin_count == 0) {
+            return false;
+        }
+        --slots_[slot].pin_count;
+        return true;
+    }
+
+    /**
+     * @brief List the cached models that are not pinned
+     *
+     * @param models Receives one record per model
+     */
+    void evictable_models(std::vector<EvictableModel>& models) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t slot = 0; slot < slot_count_; ++slot) {
+            const Slot& entry = slots_[slot];
+            if (entry.bytes != 0 && entry.pin_count == 0) {
+                models.push_back({slot, entry.last_used.load(std::memory_order_relaxed), entry.bytes});
+            }
+        }
+    }
+
+    /**
+     * @brief Drop the model of a slot unless it is pinned.
+     *
+     * Threads still holding the model keep it alive; the next lookup loads it again.
+     *
+     * @param slot The slot, less than slot_count()
+     * @return size_t The bytes released, 0 if the slot was empty or pinned
+     */
+    size_t evict(size_t slot) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot& entry = slots_[slot];
+        if (entry.bytes == 0 || entry.pin_count != 0) {
+            return 0;
+        }
+        const size_t bytes = entry.bytes;
+        entry.model.store(nullptr, std::memory_order_release);
+        entry.bytes = 0;
+        entry.evicted = true;
+        resident_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        ++eviction_count_;
+        return bytes;
+    }
+
+    /**
+     * @brief Publish a new version of a cached model.
+     *
+     * Lookups return the new version from now on; threads holding the previous
+     * version keep using it, and it is freed when the last of them releases it.
+     * A load of the slot still in flight completes for the threads waiting on it,
+     * but its possibly older version is not published.
+     *
+     * @param slot The slot, less than slot_count()
+     * @param model The new version
+     * @return true if the slot held a model and now holds the new version, false if it was empty
+     */
+    bool replace(size_t slot, Pointer model) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot& entry = slots_[slot];
+        cancel_load(slot);
+        if (entry.bytes == 0) {
+            return false;
+        }
+        const size_t bytes = std::max<size_t>(model->memory_usage_bytes(), 1);
+        resident_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        resident_bytes_.fetch_sub(entry.bytes, std::memory_order_relaxed);
+        entry.bytes = bytes;
+        entry.model.store(std::move(model), std::memory_order_release);
+        ++replace_count_;
+        return true;
+    }
+
+    /**
+     * @brief Drop the model of a slot unless it is pinned, without counting an eviction.
+     *
+     * Threads still holding the model keep it alive; the next lookup loads it again.
+     * A load of an unpinned slot still in flight completes for the threads waiting
+     * on it, but its model is not published, so the slot stays empty.
+     *
+     * @param slot The slot, less than slot_count()
+     * @return size_t The bytes released, 0 if the slot was empty or pinned
+     */
+    size_t remove(size_t slot) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Slot& entry = slots_[slot];
+        if (entry.pin_count != 0) {
+            return 0;
+        }
+        cancel_load(slot);
+        if (entry.bytes == 0) {
+            return 0;
+        }
+        const size_t bytes = entry.bytes;
+        entry.model.store(nullptr, std::memory_order_release);
+        entry.bytes = 0;
+        resident_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+        return bytes;
+    }
+
+    /**
+     * @brief Get the memory used by the cached models
+     *
+     * @return size_t The sum of their memory_usage_bytes()
+     */
+    size_t resident_bytes() const {
+        return resident_bytes_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the counters of the registry
+     *
+     * @return ModelCacheStats The counters, without a memory budget
+     */
+    ModelCacheStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ModelCacheStats stats;
+        for (size_t slot = 0; slot < slot_count_; ++slot) {
+            stats.model_count += slots_[slot].bytes != 0;
+            stats.pinned_count += slots_[slot].pin_count != 0;
+        }
+        stats.resident_bytes = resident_bytes();
+        stats.load_count = load_count_;
+        stats.reload_count = reload_count_;
+        stats.eviction_count = eviction_count_;
+        stats.replace_count = replace_count_;
+        return stats;
+    }
+
+    /**
+     * @brief Empty every slot.
+     *
+     * Loads still in flight complete for the threads waiting on them, but their
+     * models are not published, and later misses start new loads. Pins and
+     * counters are kept.
+     */
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++generation_;
+        in_flight_.clear();
+        for (size_t slot = 0; slot < slot_count_; ++slot) {
+            slots_[slot].model.store(nullptr, std::memory_order_release);
+            slots_[slot].bytes = 0;
+            slots_[slot].evicted = false;
+        }
+        resident_bytes_.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    struct Slot {
+        std::atomic<Pointer> model;
+        mutable std::atomic<uint64_t> last_used{0};
+        // Guarded by mutex_; bytes is 0 while the slot is empty
+        size_t bytes = 0;
+        size_t pin_count = 0;
+        // Advanced by remove() and replace() so that loads started before are not published
+        uint64_t epoch = 0;
+        bool evicted = false;
+    };
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t slot_count_;
+    std::atomic<uint64_t> own_clock_{0};
+    std::atomic<uint64_t>* clock_;
+    std::atomic<size_t> resident_bytes_{0};
+    mutable std::mutex mutex_;
+    uint64_t generation_ = 0;
+    uint64_t load_count_ = 0;
+    uint64_t reload_count_ = 0;
+    uint64_t eviction_count_ = 0;
+    uint64_t replace_count_ = 0;
+    std::unordered_map<size_t, std::shared_future<Pointer>> in_flight_;
+
+    // Requires mutex_ to be held
+    void cancel_load(size_t slot) {
+        ++slots_[slot].epoch;
+        in_flight_.erase(slot);
+    }
+
+    void finish(size_t slot, uint64_t generation, uint64_t epoch, Pointer model) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // After clear(), remove() or replace() the slot may be in flight again for a newer load
+        if (generation != generation_ || epoch != slots_[slot].epoch) {
+            return;
+        }
+        if (model) {
+            Slot& entry = slots_[slot];
+            // At least 1, so that an empty model still counts as cached
+            entry.bytes = std::max<size_t>(model->memory_usage_bytes(), 1);
+            entry.last_used.store(clock_->fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            entry.model.store(std::move(model), std::memory_order_release);
+            resident_bytes_.fetch_add(entry.bytes, std::memory_order_relaxed);
+            ++load_count_;
+            if (entry.evicted) {
+                entry.evicted = false;
+                ++reload_count_;
+            }
+        }
+        in_flight_.erase(slot);
+    }
+};
+
+} // namespace lingua
+
+#endif // LINGUA_MODEL_REGISTRY_H
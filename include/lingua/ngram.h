@@ -1,54 +1,234 @@
 #ifndef LINGUA_NGRAM_H
 #define LINGUA_NGRAM_H
 
+#include <array>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <optional>
 #include <string>
 #include <string_view>
-#include <stdexcept>
-#include <iterator>
 
 namespace lingua {
 
 /**
- * @brief Class for storing n-gram strings with validation.
- * 
- * This class represents an n-gram as an owned string with validation
- * to ensure the length is between 1 and 5 characters.
+ * @brief An n-gram of 1 to 5 Unicode code points, stored inline.
+ *
+ * The code points are packed 21 bits each into 128 bits, first code point in
+ * the most significant bits, with the code point count in the lowest 3 bits.
+ * An Ngram never allocates, compares and hashes as two integers, and orders
+ * lexicographically by code point. Lengths are counted in code points, not
+ * bytes, so "привет" is six characters long and "東京都庁前" is five.
  */
 class Ngram {
 public:
     /**
-     * @brief Constructs an Ngram from a string.
-     * 
-     * @param value The string value for the n-gram
-     * @throws std::invalid_argument if the string length is not between 1 and 5
+     * @brief The largest number of code points in an n-gram
+     */
+    static constexpr size_t MAX_CHAR_COUNT = 5;
+
+    /**
+     * @brief The largest number of UTF-8 bytes of an n-gram
+     */
+    static constexpr size_t MAX_UTF8_BYTES = 4 * MAX_CHAR_COUNT;
+
+    /**
+     * @brief Buffer that to_utf8() encodes into
+     */
+    using Utf8Buffer = std::array<char, MAX_UTF8_BYTES>;
+
+    /**
+     * @brief Constructs an empty n-gram, which equals no valid n-gram
+     */
+    constexpr Ngram() noexcept = default;
+
+    /**
+     * @brief Constructs an Ngram from UTF-8 text.
+     *
+     * @param value The UTF-8 text of the n-gram
+     * @throws std::invalid_argument if the text is not valid UTF-8 or its length is not between 1 and 5 code points
+     */
+    explicit Ngram(std::string_view value);
+
+    /**
+     * @brief Create an Ngram from UTF-8 text without throwing.
+     *
+     * @param value The UTF-8 text of the n-gram
+     * @return std::optional<Ngram> The n-gram, or nullopt if the text is not valid UTF-8 or its length is not between 1 and 5 code points
+     */
+    static constexpr std::optional<Ngram> from_utf8(std::string_view value) noexcept {
+        Ngram ngram;
+        size_t count = 0;
+        for (size_t offset = 0; offset < value.size();) {
+            char32_t code_point = 0;
+            const size_t length = decode_utf8(value, offset, code_point);
+            if (length == 0 || count == MAX_CHAR_COUNT) {
+                return std::nullopt;
+            }
+            ngram.put(code_point, count++);
+            offset += length;
+        }
+        if (count == 0) {
+            return std::nullopt;
+        }
+        ngram.low_ |= count;
+        return ngram;
+    }
+
+    /**
+     * @brief Create an Ngram from code points without throwing.
+     *
+     * @param code_points The code points of the n-gram
+     * @return std::optional<Ngram> The n-gram, or nullopt if a code point is not a Unicode scalar value or there are not between 1 and 5
+     */
+    static constexpr std::optional<Ngram> from_code_points(std::u32string_view code_points) noexcept {
+        if (code_points.empty() || code_points.size() > MAX_CHAR_COUNT) {
+            return std::nullopt;
+        }
+        Ngram ngram;
+        for (size_t index = 0; index < code_points.size(); ++index) {
+            if (!is_scalar_value(code_points[index])) {
+                return std::nullopt;
+            }
+            ngram.put(code_points[index], index);
+        }
+        ngram.low_ |= code_points.size();
+        return ngram;
+    }
+
+    /**
+     * @brief Create an Ngram from its packed representation, without validation.
+     *
+     * @param high_bits The upper 64 bits, see high_bits()
+     * @param low_bits The lower 64 bits, see low_bits()
+     * @return Ngram The n-gram
      */
-    explicit Ngram(const std::string& value);
+    static constexpr Ngram from_bits(uint64_t high_bits, uint64_t low_bits) noexcept {
+        Ngram ngram;
+        ngram.high_ = high_bits;
+        ngram.low_ = low_bits;
+        return ngram;
+    }
 
     /**
-     * @brief Constructs an Ngram from a C-string.
-     * 
-     * @param value The C-string value for the n-gram
-     * @throws std::invalid_argument if the string length is not between 1 and 5
+     * @brief Get the upper 64 bits of the packed n-gram: the first three code points and the top bit of the fourth.
+     *
+     * @return uint64_t The bits
      */
-    explicit Ngram(const char* value);
+    constexpr uint64_t high_bits() const noexcept {
+        return high_;
+    }
 
     /**
-     * @brief Get the string value of the n-gram.
-     * 
-     * @return const std::string& The n-gram value
+     * @brief Get the lower 64 bits of the packed n-gram: the rest of the code points and the code point count.
+     *
+     * @return uint64_t The bits
      */
-    const std::string& get_value() const;
+    constexpr uint64_t low_bits() const noexcept {
+        return low_;
+    }
 
     /**
      * @brief Get the character count of the n-gram.
-     * 
-     * @return size_t The number of characters in the n-gram
+     *
+     * @return size_t The number of code points in the n-gram, 0 for an empty n-gram
+     */
+    constexpr size_t char_count() const noexcept {
+        return static_cast<size_t>(low_ & COUNT_MASK);
+    }
+
+    /**
+     * @brief Get a code point of the n-gram.
+     *
+     * @param index The position of the code point, less than char_count()
+     * @return char32_t The code point
+     */
+    constexpr char32_t code_point(size_t index) const noexcept {
+        const size_t shift = FIRST_SHIFT - CODE_POINT_BITS * index;
+        uint64_t bits = 0;
+        if (shift >= 64) {
+            bits = high_ >> (shift - 64);
+        } else {
+            bits = low_ >> shift;
+            if (shift + CODE_POINT_BITS > 64) {
+                bits |= high_ << (64 - shift);
+            }
+        }
+        return static_cast<char32_t>(bits & CODE_POINT_MASK);
+    }
+
+    /**
+     * @brief Get the n-gram made of the first code points of this one.
+     *
+     * @param char_count The number of code points to keep
+     * @return Ngram The prefix, this n-gram if char_count is not less than its length
+     */
+    constexpr Ngram prefix(size_t char_count) const noexcept {
+        if (char_count >= this->char_count()) {
+            return *this;
+        }
+        Ngram ngram;
+        for (size_t index = 0; index < char_count; ++index) {
+            ngram.put(code_point(index), index);
+        }
+        ngram.low_ |= char_count;
+        return ngram;
+    }
+
+    /**
+     * @brief Get the n-gram with a code point appended to this one.
+     *
+     * @param code_point A Unicode scalar value
+     * @return Ngram The longer n-gram; the last code point is replaced if this n-gram is 5 code points long
      */
-    size_t char_count() const;
+    constexpr Ngram extend(char32_t code_point) const noexcept {
+        const size_t count = char_count() < MAX_CHAR_COUNT ? char_count() : MAX_CHAR_COUNT - 1;
+        Ngram ngram = prefix(count);
+        ngram.low_ &= ~COUNT_MASK;
+        ngram.put(code_point, count);
+        ngram.low_ |= count + 1;
+        return ngram;
+    }
+
+    /**
+     * @brief Encode the n-gram as UTF-8.
+     *
+     * @param buffer The buffer to encode into
+     * @return std::string_view The UTF-8 bytes, a view of buffer
+     */
+    constexpr std::string_view to_utf8(Utf8Buffer& buffer) const noexcept {
+        size_t size = 0;
+        for (size_t index = 0; index < char_count(); ++index) {
+            size += encode_utf8(code_point(index), buffer.data() + size);
+        }
+        return {buffer.data(), size};
+    }
+
+    /**
+     * @brief Get the UTF-8 text of the n-gram.
+     *
+     * @return std::string The n-gram value
+     */
+    std::string get_value() const;
+
+    /**
+     * @brief Hash the n-gram.
+     *
+     * @return uint64_t The hash, equal for equal n-grams
+     */
+    constexpr uint64_t hash() const noexcept {
+        uint64_t hash = (high_ * 0x9E3779B97F4A7C15ULL) ^ low_;
+        hash ^= hash >> 32;
+        hash *= 0xD6E8FEB86659FD93ULL;
+        hash ^= hash >> 32;
+        return hash;
+    }
 
     /**
      * @brief Get the name of an n-gram based on its length.
-     * 
+     *
      * @param ngram_length The length of the n-gram (1-5)
      * @return const char* The name ("unigram", "bigram", etc.)
      * @throws std::invalid_argument if ngram_length is not between 1 and 5
@@ -57,142 +237,266 @@ public:
 
     /**
      * @brief Equality operator.
-     * 
+     *
      * @param other The other Ngram to compare with
-     * @return true if the n-grams are equal
-     * @return false if the n-grams are not equal
+     * @return true if the n-grams have the same code points
      */
-    bool operator==(const Ngram& other) const;
+    constexpr bool operator==(const Ngram& other) const noexcept = default;
 
     /**
-     * @brief Inequality operator.
-     * 
+     * @brief Lexicographic order by code point, shorter n-grams before their extensions.
+     *
      * @param other The other Ngram to compare with
-     * @return true if the n-grams are not equal
-     * @return false if the n-grams are equal
+     * @return std::strong_ordering The order of the n-grams
+     */
+    constexpr std::strong_ordering operator<=>(const Ngram& other) const noexcept = default;
+
+    /**
+     * @brief Check whether a code point is a Unicode scalar value, which UTF-8 can encode.
+     *
+     * @param code_point The code point
+     * @return true if the code point is at most U+10FFFF and not a surrogate
      */
-    bool operator!=(const Ngram& other) const;
+    static constexpr bool is_scalar_value(char32_t code_point) noexcept {
+        return code_point <= 0x10FFFF && (code_point < 0xD800 || code_point > 0xDFFF);
+    }
+
+    /**
+     * @brief Decode one code point of UTF-8 text.
+     *
+     * Overlong forms, surrogates, code points above U+10FFFF and truncated
+     * sequences are invalid.
+     *
+     * @param text The text
+     * @param offset The offset of the code point's first byte, less than text.size()
+     * @param code_point Set to the code point
+     * @return size_t The number of bytes of the code point, 0 if they are not valid UTF-8
+     */
+    static constexpr size_t decode_utf8(std::string_view text, size_t offset, char32_t& code_point) noexcept {
+        const auto lead = static_cast<unsigned char>(text[offset]);
+        if (lead < 0x80) {
+            code_point = lead;
+            return 1;
+        }
+        size_t length = 0;
+        char32_t minimum = 0;
+        if ((lead & 0xE0) == 0xC0) {
+            length = 2;
+            minimum = 0x80;
+            code_point = lead & 0x1F;
+        } else if ((lead & 0xF0) == 0xE0) {
+            length = 3;
+            minimum = 0x800;
+            code_point = lead & 0x0F;
+        } else if ((lead & 0xF8) == 0xF0) {
+            length = 4;
+            minimum = 0x10000;
+            code_point = lead & 0x07;
+        } else {
+            return 0;
+        }
+        if (text.size() - offset < length) {
+            return 0;
+        }
+        for (size_t index = 1; index < length; ++index) {
+            const auto byte = static_cast<unsigned char>(text[offset + index]);
+            if ((byte & 0xC0) != 0x80) {
+                return 0;
+            }
+            code_point = (code_point << 6) | (byte & 0x3F);
+        }
+        return code_point >= minimum && is_scalar_value(code_point) ? length : 0;
+    }
+
+    /**
+     * @brief Encode a Unicode scalar value as UTF-8.
+     *
+     * @param code_point The code point
+     * @param out The destination, with room for 4 bytes
+     * @return size_t The number of bytes written
+     */
+    static constexpr size_t encode_utf8(char32_t code_point, char* out) noexcept {
+        if (code_point < 0x80) {
+            out[0] = static_cast<char>(code_point);
+            return 1;
+        }
+        if (code_point < 0x800) {
+            out[0] = static_cast<char>(0xC0 | (code_point >> 6));
+            out[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+            return 2;
+        }
+        if (code_point < 0x10000) {
+            out[0] = static_cast<char>(0xE0 | (code_point >> 12));
+            out[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            out[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+            return 3;
+        }
+        out[0] = static_cast<char>(0xF0 | (code_point >> 18));
+        out[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        out[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+        return 4;
+    }
 
 private:
-    std::string value_;
-    size_t char_count_;
+    static constexpr size_t CODE_POINT_BITS = 21;
+    static constexpr uint64_t CODE_POINT_MASK = (uint64_t{1} << CODE_POINT_BITS) - 1;
+    static constexpr uint64_t COUNT_MASK = 0x7;
+    // Bit position of the first code point in the 128-bit value; the last one ends above the count
+    static constexpr size_t FIRST_SHIFT = 128 - CODE_POINT_BITS;
+
+    // Declared high bits first, so that the defaulted comparisons order by code point
+    uint64_t high_ = 0;
+    uint64_t low_ = 0;
 
-    void validate_length(size_t length) const;
+    constexpr void put(char32_t code_point, size_t index) noexcept {
+        const size_t shift = FIRST_SHIFT - CODE_POINT_BITS * index;
+        const uint64_t bits = code_point;
+        if (shift >= 64) {
+            high_ |= bits << (shift - 64);
+        } else {
+            low_ |= bits << shift;
+            if (shift + CODE_POINT_BITS > 64) {
+                high_ |= bits >> (64 - shift);
+            }
+        }
+    }
 };
 
+static_assert(sizeof(Ngram) == 16, "An Ngram packs into 128 bits");
+
 /**
  * @brief Class for efficient string references to n-grams.
- * 
- * This class represents an n-gram as a string view with validation
- * to ensure the length is between 1 and 5 characters.
+ *
+ * This class represents an n-gram as a view of valid UTF-8 text of 1 to 5
+ * code points.
  */
 class NgramRef {
 public:
     /**
      * @brief Constructs an NgramRef from a string view.
-     * 
+     *
      * @param value The string view for the n-gram
-     * @throws std::invalid_argument if the string length is not between 1 and 5
+     * @throws std::invalid_argument if the text is not valid UTF-8 or its length is not between 1 and 5 code points
      */
     explicit NgramRef(std::string_view value);
 
     /**
-     * @brief Constructs an NgramRef from a C-string.
-     * 
-     * @param value The C-string for the n-gram
-     * @throws std::invalid_argument if the string length is not between 1 and 5
+     * @brief Create an NgramRef without throwing.
+     *
+     * @param value The string view for the n-gram
+     * @return std::optional<NgramRef> The reference, or nullopt if the text is not valid UTF-8 or its length is not between 1 and 5 code points
      */
-    explicit NgramRef(const char* value);
+    static constexpr std::optional<NgramRef> from_utf8(std::string_view value) noexcept {
+        const std::optional<Ngram> ngram = Ngram::from_utf8(value);
+        if (!ngram) {
+            return std::nullopt;
+        }
+        return NgramRef(value, ngram->char_count());
+    }
 
     /**
      * @brief Get the string view of the n-gram.
-     * 
+     *
      * @return std::string_view The n-gram value
      */
-    std::string_view get_value() const;
+    constexpr std::string_view get_value() const noexcept {
+        return value_;
+    }
 
     /**
      * @brief Get the character count of the n-gram.
-     * 
-     * @return size_t The number of characters in the n-gram
+     *
+     * @return size_t The number of code points in the n-gram
      */
-    size_t char_count() const;
+    constexpr size_t char_count() const noexcept {
+        return char_count_;
+    }
 
     /**
-     * @brief Equality operator.
-     * 
-     * @param other The other NgramRef to compare with
-     * @return true if the n-grams are equal
-     * @return false if the n-grams are not equal
+     * @brief Copy the n-gram into an inline value.
+     *
+     * @return Ngram The n-gram
      */
-    bool operator==(const NgramRef& other) const;
+    constexpr Ngram to_ngram() const noexcept {
+        return Ngram::from_utf8(value_).value_or(Ngram());
+    }
 
     /**
-     * @brief Inequality operator.
-     * 
+     * @brief Equality operator.
+     *
      * @param other The other NgramRef to compare with
-     * @return true if the n-grams are not equal
-     * @return false if the n-grams are equal
+     * @return true if the n-grams are equal
+     * @return false if the n-grams are not equal
      */
-    bool operator!=(const NgramRef& other) const;
+    constexpr bool operator==(const NgramRef& other) const noexcept {
+        return value_ == other.value_;
+    }
 
     /**
      * @brief Range of lower order n-grams.
-     * 
+     *
      * Returns an iterator that yields this n-gram and all its lower-order n-grams.
      * For example, for "abcde", it yields "abcde", "abcd", "abc", "ab", "a".
-     * 
+     *
      * @return A range object for iterating over lower-order n-grams
      */
-    class Range {
-    public:
-        class Iterator {
-        public:
-            using iterator_category = std::forward_iterator_tag;
-            using value_type = NgramRef;
-            using difference_type = std::ptrdiff_t;
-            using pointer = const NgramRef*;
-            using reference = const NgramRef&;
-
-            Iterator(std::string_view value, size_t char_count, bool is_end = false);
-            
-            reference operator*() const;
-            pointer operator->() const;
-            Iterator& operator++();
-            Iterator operator++(int);
-            bool operator==(const Iterator& other) const;
-            bool operator!=(const Iterator& other) const;
-
-        private:
-            std::string_view value_;
-            size_t char_count_;
-            bool is_end_;
-            
-            void update_to_prefix();
-        };
-
-        explicit Range(std::string_view start_value, size_t start_char_count);
-
-        Iterator begin() const;
-        Iterator end() const;
-
-    private:
-        std::string_view start_value_;
-        size_t start_char_count_;
-    };
+    class Range;
 
     Range range_of_lower_order_ngrams() const;
 
 private:
     std::string_view value_;
-    size_t char_count_;
+    size_t char_count_ = 0;
+
+    constexpr NgramRef(std::string_view value, size_t char_count) noexcept : value_(value), char_count_(char_count) {}
 
-    void validate_length(size_t length) const;
-    
     // Helper function to get a prefix of an n-gram
     static std::string_view get_prefix(std::string_view str, size_t char_count);
 };
 
+/**
+ * @brief This n-gram and its lower order n-grams, longest first
+ */
+class NgramRef::Range {
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = NgramRef;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const NgramRef*;
+        using reference = const NgramRef&;
+
+        Iterator(NgramRef current, bool is_end = false);
+
+        reference operator*() const;
+        pointer operator->() const;
+        Iterator& operator++();
+        Iterator operator++(int);
+        bool operator==(const Iterator& other) const;
+
+    private:
+        NgramRef current_;
+        bool is_end_;
+    };
+
+    explicit Range(NgramRef start);
+
+    Iterator begin() const;
+    Iterator end() const;
+
+private:
+    NgramRef start_;
+};
+
 } // namespace lingua
 
-#endif // LINGUA_NGRAM_H
\ No newline at end of file
+template <>
+struct std::hash<lingua::Ngram> {
+    constexpr size_t operator()(const lingua::Ngram& ngram) const noexcept {
+        return static_cast<size_t>(ngram.hash());
+    }
+};
+
+#endif // LINGUA_NGRAM_H
@@ -0,0 +1,74 @@
+#ifndef LINGUA_NGRAM_EXTRACTOR_H
+#define LINGUA_NGRAM_EXTRACTOR_H
+
+#include "lingua/ngram.h"
+#include <array>
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace lingua {
+
+/**
+ * @brief Extracts the 1- to 5-character n-grams of every word of a text in one pass.
+ *
+ * Words are maximal runs of code points other than Unicode white space. The
+ * text is decoded once, in chunks, by decode_utf8(); each code point extends
+ * the n-grams that end at the previous one, and the n-grams of every order are
+ * appended to a flat buffer per order. Invalid UTF-8, like U+FFFD itself, ends
+ * the current word. The buffers
+ * only grow, to one n-gram per byte of the longest text so far, so an extractor
+ * reused for texts of similar size stops allocating after the first ones.
+ *
+ * The text is taken as it is; lowercase and clean it first where needed.
+ */
+class NgramExtractor {
+public:
+    /**
+     * @brief Extract the n-grams of a text, replacing those of the previous one.
+     *
+     * @param text The UTF-8 text
+     */
+    void extract(std::string_view text);
+
+    /**
+     * @brief Get the n-grams of one order, in text order.
+     *
+     * @param order The n-gram length (1-5)
+     * @return std::span<const Ngram> The n-grams, with duplicates, valid until the next extract()
+     * @throws std::invalid_argument if order is not between 1 and 5
+     */
+    std::span<const Ngram> ngrams(size_t order) const;
+
+    /**
+     * @brief Get the number of words of the last text.
+     *
+     * @return size_t The word count
+     */
+    size_t word_count() const;
+
+    /**
+     * @brief Check whether a code point separates words.
+     *
+     * @param code_point The code point
+     * @return true if the code point has the Unicode White_Space property
+     */
+    static constexpr bool is_word_separator(char32_t code_point) noexcept {
+        if (code_point < 0x80) {
+            return code_point == ' ' || (code_point >= '\t' && code_point <= '\r');
+        }
+        return code_point == 0x85 || code_point == 0xA0 || code_point == 0x1680
+               || (code_point >= 0x2000 && code_point <= 0x200A) || code_point == 0x2028 || code_point == 0x2029
+               || code_point == 0x202F || code_point == 0x205F || code_point == 0x3000;
+    }
+
+private:
+    std::array<std::vector<Ngram>, Ngram::MAX_CHAR_COUNT> ngrams_;
+    std::array<size_t, Ngram::MAX_CHAR_COUNT> counts_ {};
+    size_t word_count_ = 0;
+};
+
+} // namespace lingua
+
+#endif // LINGUA_NGRAM_EXTRACTOR_H
@@ -0,0 +1,74 @@
+#ifndef LINGUA_NGRAM_HASHER_H
+#define LINGUA_NGRAM_HASHER_H
+
+#include "lingua/ngram.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace lingua {
+
+/**
+ * @brief Computes the hashes of the 1- to 5-character n-grams of every word of a text in one pass.
+ *
+ * This is the hashed counterpart of NgramExtractor: words and n-grams are the
+ * same, but instead of the n-grams themselves it produces the 64-bit hashes
+ * that models frozen with the HASHED_NGRAMS layout are keyed by. The hashes
+ * are rolling polynomial hashes over code points (see extend_ngram_hash()), so
+ * the five hashes ending at a code point cost five multiply-adds on the hashes
+ * ending at the previous one, and no n-gram is ever built.
+ */
+class NgramHasher {
+public:
+    /**
+     * @brief Hash the n-grams of a text, replacing those of the previous one.
+     *
+     * @param text The UTF-8 text
+     */
+    void extract(std::string_view text);
+
+    /**
+     * @brief Get the n-gram hashes of one order, in text order.
+     *
+     * @param order The n-gram length (1-5)
+     * @return std::span<const uint64_t> The hashes, with duplicates, valid until the next extract()
+     * @throws std::invalid_argument if order is not between 1 and 5
+     */
+    std::span<const uint64_t> hashes(size_t order) const;
+
+    /**
+     * @brief Get the number of words of the last text.
+     *
+     * @return size_t The word count
+     */
+    size_t word_count() const;
+
+    /**
+     * @brief Get the hash of an n-gram, as extract() computes it.
+     *
+     * @param ngram The n-gram
+     * @return uint64_t The n-gram hash
+     */
+    static uint64_t hash_of(const Ngram& ngram) noexcept;
+
+    /**
+     * @brief Get the hash of the n-gram spelled by UTF-8 text.
+     *
+     * @param ngram The UTF-8 bytes of the n-gram
+     * @return std::optional<uint64_t> The n-gram hash, or std::nullopt if the text is empty or not valid UTF-8
+     */
+    static std::optional<uint64_t> hash_of_utf8(std::string_view ngram) noexcept;
+
+private:
+    std::array<std::vector<uint64_t>, Ngram::MAX_CHAR_COUNT> hashes_;
+    std::array<size_t, Ngram::MAX_CHAR_COUNT> counts_ {};
+    size_t word_count_ = 0;
+};
+
+} // namespace lingua
+
+#endif // LINGUA_NGRAM_HASHER_H
@@ -0,0 +1,123 @@
+#ifndef LINGUA_NUMA_H
+#define LINGUA_NUMA_H
+
+#include "lingua/frozen_model.h"
+#include "lingua/mapped_file.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lingua {
+
+/**
+ * @brief NUMA nodes of a host and the CPUs of each.
+ *
+ * Nodes are numbered densely from 0 in the order of their kernel node ids. A
+ * host without NUMA information in sysfs, and every platform other than Linux,
+ * has a single node holding every CPU.
+ */
+class NumaTopology {
+public:
+    /**
+     * @brief Directory holding the node<N>/cpulist files of the host
+     */
+    static constexpr const char* DEFAULT_NODE_DIRECTORY = "/sys/devices/system/node";
+
+    /**
+     * @brief Constructs a topology with a single node
+     */
+    NumaTopology();
+
+    /**
+     * @brief Read the nodes and their CPUs from sysfs.
+     *
+     * @param node_directory The directory holding node<N>/cpulist files
+     * @return NumaTopology The nodes with at least one CPU, or a single node if there are none
+     */
+    static NumaTopology detect(const std::string& node_directory = DEFAULT_NODE_DIRECTORY);
+
+    /**
+     * @brief Get the topology of the host, detected on first use
+     *
+     * @return std::shared_ptr<const NumaTopology> The topology
+     */
+    static std::shared_ptr<const NumaTopology> system();
+
+    /**
+     * @brief Parse a sysfs CPU list such as "0-3,8-11"
+     *
+     * @param list The list
+     * @return std::vector<unsigned> The CPUs in ascending order
+     * @throws std::invalid_argument if the list is malformed
+     */
+    static std::vector<unsigned> parse_cpu_list(std::string_view list);
+
+    /**
+     * @brief Get the number of nodes
+     *
+     * @return size_t The node count, at least 1
+     */
+    size_t node_count() const;
+
+    /**
+     * @brief Get the kernel id of a node, as used by mbind
+     *
+     * @param node The node, less than node_count()
+     * @return int The id, or -1 for the single node of a host without NUMA information
+     */
+    int kernel_node_id(size_t node) const;
+
+    /**
+     * @brief Get the CPUs of a node
+     *
+     * @param node The node, less than node_count()
+     * @return const std::vector<unsigned>& The CPUs, empty for the single node of a host without NUMA information
+     */
+    const std::vector<unsigned>& node_cpus(size_t node) const;
+
+    /**
+     * @brief Get the node of a CPU
+     *
+     * @param cpu The CPU
+     * @return size_t The node, 0 for CPUs of no known node
+     */
+    size_t node_of_cpu(unsigned cpu) const;
+
+    /**
+     * @brief Get the node of the CPU the calling thread runs on.
+     *
+     * The CPU is looked up again every CPU_REFRESH_INTERVAL calls, so a thread
+     * that migrates to another node follows within a few hundred lookups.
+     *
+     * @return size_t The node
+     */
+    size_t current_node() const;
+
+private:
+    static constexpr unsigned CPU_REFRESH_INTERVAL = 256;
+
+    std::vector<int> kernel_node_ids_;
+    std::vector<std::vector<unsigned>> node_cpus_;
+    std::vector<uint32_t> cpu_nodes_;
+};
+
+/**
+ * @brief Copy a frozen model into the memory of every NUMA node.
+ *
+ * Where memory cannot be bound to a node, the replica is still a valid copy,
+ * placed wherever the kernel chose.
+ *
+ * @param model The model
+ * @param topology The nodes
+ * @param pages The page size policy of the replicas
+ * @return std::vector<FrozenModel> One replica per node, indexed by node
+ */
+std::vector<FrozenModel> replicate_model(const FrozenModel& model, const NumaTopology& topology,
+                                         PagePolicy pages = PagePolicy::DEFAULT);
+
+} // namespace lingua
+
+#endif // LINGUA_NUMA_H
@@ -0,0 +1,109 @@
+#ifndef LINGUA_SHARED_MODEL_STORE_H
+#define LINGUA_SHARED_MODEL_STORE_H
+
+#include "lingua/mapped_file.h"
+#include "lingua/model_bundle.h"
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace lingua {
+
+/**
+ * @brief A model bundle shared by all processes on a host.
+ *
+ * The first process to open a store builds the bundle and publishes it by
+ * renaming it into place; processes that open it meanwhile wait for the build,
+ * and later ones map the published file right away. Every process maps the same
+ * file read-only, so the models take the same memory however many processes use
+ * them. A store lives on a RAM-backed file system such as /dev/shm by default.
+ *
+ * Each open store holds a shared lock on its file, which serves as a reader
+ * reference count kept by the kernel: it drops when a reader exits, even by a
+ * crash, and remove_unused() only deletes files whose count is zero. A reader
+ * that locked a file remove_unused() deleted meanwhile opens the store again.
+ * Stores are versioned by name, so a new version is a new file next to the old
+ * one. remove_unused() deletes the empty .lock file that serializes the builds
+ * of a version together with it; builds waiting on a deleted lock file lock a
+ * new one. Without POSIX file locks (Windows), neither builds nor readers are coordinated.
+ */
+class SharedModelStore {
+public:
+    /**
+     * @brief Directory of stores unless another one is given
+     */
+    static constexpr const char* DEFAULT_DIRECTORY = "/dev/shm";
+
+    /**
+     * @brief Writes the models of a store that does not exist yet
+     */
+    using Builder = std::function<void(ModelBundleWriter&)>;
+
+    /**
+     * @brief Open a store, building it first if no process has published it yet.
+     *
+     * @param directory The directory of the store, created if missing
+     * @param file_name The file name of the store, which names its version
+     * @param build Called with a writer for the store's bundle if it must be built
+     * @param options The page-fault profile of the mapping
+     * @return std::shared_ptr<const SharedModelStore> The store, holding a reader reference until destroyed
+     * @throws ModelLoadException if the store cannot be built, locked or opened
+     */
+    static std::shared_ptr<const SharedModelStore> open(
+        const std::string& directory,
+        const std::string& file_name,
+        const Builder& build,
+        const MappingOptions& options = {}
+    );
+
+    /**
+     * @brief Delete the stores in a directory that no process has open.
+     *
+     * @param directory The directory of the stores
+     * @param file_name_prefix Only files whose names start with this prefix and end in .lfb are considered
+     * @return size_t The number of deleted stores
+     */
+    static size_t remove_unused(const std::string& directory, const std::string& file_name_prefix);
+
+    /**
+     * @brief Releases the reader reference
+     */
+    ~SharedModelStore();
+
+    SharedModelStore(const SharedModelStore&) = delete;
+    SharedModelStore& operator=(const SharedModelStore&) = delete;
+
+    /**
+     * @brief Get the bundle of the store, mapped read-only
+     *
+     * @return const std::shared_ptr<const ModelBundle>& The bundle
+     */
+    const std::shared_ptr<const ModelBundle>& bundle() const;
+
+    /**
+     * @brief Get the path of the store
+     *
+     * @return const std::string& The path
+     */
+    const std::string& path() const;
+
+    /**
+     * @brief Check whether this process built the store
+     *
+     * @return true if the store was built by open(), false if another process had published it
+     */
+    bool was_built() const;
+
+private:
+    std::string path_;
+    std::shared_ptr<const ModelBundle> bundle_;
+    int reader_lock_fd_ = -1;
+    bool was_built_ = false;
+
+    SharedModelStore() = default;
+};
+
+} // namespace lingua
+
+#endif // LINGUA_SHARED_MODEL_STORE_H
@@ -0,0 +1,64 @@
+#ifndef LINGUA_TEXT_NORMALIZER_H
+#define LINGUA_TEXT_NORMALIZER_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lingua {
+
+/**
+ * @brief Normalizes a text for detection in one forward pass.
+ *
+ * This does what the TextProcessor chain of to_lowercase(),
+ * remove_punctuation(), remove_numbers(), remove_extra_whitespace() and
+ * tokenize() does, but Unicode-aware and without a copy per step: the text is
+ * decoded once, letters and marks (is_letter()) are case-folded (fold_case())
+ * into a buffer that is kept across calls, whitespace ends a word and every
+ * other code point (digits, punctuation, symbols, invalid UTF-8) is dropped.
+ *
+ * The words are views into the buffer, which holds them separated by single
+ * spaces, so text() can be passed straight to NgramExtractor::extract() or
+ * NgramHasher::extract().
+ */
+class TextNormalizer {
+public:
+    /**
+     * @brief Normalize a text, replacing the words of the previous one.
+     *
+     * @param text The UTF-8 text
+     * @return std::span<const std::string_view> The words, valid until the next normalize()
+     */
+    std::span<const std::string_view> normalize(std::string_view text);
+
+    /**
+     * @brief Get the words of the last text.
+     *
+     * @return std::span<const std::string_view> The words, valid until the next normalize()
+     */
+    std::span<const std::string_view> words() const;
+
+    /**
+     * @brief Get the words of the last text separated by single spaces.
+     *
+     * @return std::string_view The normalized text, valid until the next normalize()
+     */
+    std::string_view text() const;
+
+    /**
+     * @brief Get the number of words of the last text.
+     *
+     * @return size_t The word count
+     */
+    size_t word_count() const;
+
+private:
+    std::string buffer_;
+    std::vector<std::string_view> words_;
+};
+
+} // namespace lingua
+
+#endif // LINGUA_TEXT_NORMALIZER_H
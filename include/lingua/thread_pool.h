@@ -0,0 +1,96 @@
+#ifndef LINGUA_THREAD_POOL_H
+#define LINGUA_THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lingua {
+
+/**
+ * @brief Fixed-size pool of worker threads running tasks in submission order.
+ *
+ * Tasks must not block on the futures of other tasks of the same pool, or the
+ * pool can run out of workers.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Starts the worker threads
+     *
+     * @param thread_count The number of worker threads, at least 1
+     * @throws std::invalid_argument if thread_count is 0
+     */
+    explicit ThreadPool(size_t thread_count);
+
+    /**
+     * @brief Runs the remaining queued tasks and joins the worker threads
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Get the number of worker threads
+     *
+     * @return size_t The thread count
+     */
+    size_t thread_count() const;
+
+    /**
+     * @brief Queue a task
+     *
+     * @param task A callable taking no arguments
+     * @return std::future The task's result, or the exception it threw
+     */
+    template <typename Task>
+    std::future<std::invoke_result_t<std::decay_t<Task>>> submit(Task&& task) {
+        using Result = std::invoke_result_t<std::decay_t<Task>>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+        std::future<Result> result = packaged->get_future();
+        enqueue([packaged] { (*packaged)(); });
+        return result;
+    }
+
+    /**
+     * @brief Run body(i) for every i in [0, count) on the workers and the calling thread
+     *
+     * The calling thread claims iterations too and only waits for iterations that are
+     * already running, so this may be called from a task of the same pool.
+     *
+     * @param count The number of iterations
+     * @param body The iteration, called with its index
+     * @throws The first exception thrown by body, once every iteration has run
+     */
+    void parallel_for(size_t count, const std::function<void(size_t)>& body);
+
+    /**
+     * @brief Get the default number of worker threads
+     *
+     * @return size_t The number of hardware threads, or 1 if unknown
+     */
+    static size_t default_thread_count();
+
+private:
+    std::vector<std::thread> threads_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable task_available_;
+    bool stopping_ = false;
+
+    void enqueue(std::function<void()> task);
+    void run();
+};
+
+} // namespace lingua
+
+#endif // LINGUA_THREAD_POOL_H
@@ -0,0 +1,125 @@
+#ifndef LINGUA_UNICODE_H
+#define LINGUA_UNICODE_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace lingua {
+
+/**
+ * @brief The code point that stands in for an invalid UTF-8 sequence
+ */
+inline constexpr char32_t REPLACEMENT_CHARACTER = U'\uFFFD';
+
+/**
+ * @brief Progress of a call to decode_utf8().
+ */
+struct Utf8DecodeResult {
+    /**
+     * @brief Bytes of the text consumed, always at a sequence boundary
+     */
+    size_t bytes_read = 0;
+
+    /**
+     * @brief Code points written to the output
+     */
+    size_t code_points_written = 0;
+
+    /**
+     * @brief Invalid sequences among them, each written as REPLACEMENT_CHARACTER
+     */
+    size_t invalid_sequences = 0;
+};
+
+/**
+ * @brief Check whether a byte continues a UTF-8 sequence rather than starting one.
+ *
+ * @param byte The byte
+ * @return true if the byte has the form 10xxxxxx
+ */
+constexpr bool is_utf8_continuation(char byte) noexcept {
+    return (static_cast<unsigned char>(byte) & 0xC0) == 0x80;
+}
+
+/**
+ * @brief Decode UTF-8 text into code points.
+ *
+ * Runs of ASCII are widened 32 bytes per step with SSE2, AVX2 or NEON,
+ * whichever the build targets, and 8 bytes per step elsewhere; other
+ * sequences are decoded and validated one at a time. Each maximal invalid
+ * subpart (an overlong, surrogate or out-of-range sequence, a stray
+ * continuation byte, or a sequence cut short) becomes one
+ * REPLACEMENT_CHARACTER, as the WHATWG decoder does. Decoding stops at the
+ * end of the text or when the output is full, so a long text is decoded in
+ * chunks by calling again with the rest of it.
+ *
+ * @param text The UTF-8 text
+ * @param out Where to write the code points
+ * @return Utf8DecodeResult How much of the text was decoded
+ */
+Utf8DecodeResult decode_utf8(std::string_view text, std::span<char32_t> out) noexcept;
+
+/**
+ * @brief Decode a whole UTF-8 text into code points.
+ *
+ * @param text The UTF-8 text
+ * @return std::u32string The code points, with invalid sequences replaced as by decode_utf8()
+ */
+std::u32string to_utf32(std::string_view text);
+
+/**
+ * @brief Check whether a text is valid UTF-8.
+ *
+ * @param text The text
+ * @return true if every sequence is a well-formed encoding of a Unicode scalar value
+ */
+bool is_valid_utf8(std::string_view text) noexcept;
+
+/**
+ * @brief Get the length of the leading run of ASCII bytes of a text.
+ *
+ * @param text The text
+ * @return size_t The offset of the first byte above 0x7F, or the text size if there is none
+ */
+size_t ascii_prefix_length(std::string_view text) noexcept;
+
+/**
+ * @brief Map a code point to its simple case folding.
+ *
+ * Case folding makes texts that differ only in case equal: uppercase and
+ * titlecase letters map to lowercase, and a few lowercase variants to their
+ * usual form, such as U+03C2 GREEK SMALL LETTER FINAL SIGMA to U+03C3. Only
+ * one-to-one mappings apply, so U+00DF LATIN SMALL LETTER SHARP S stays as it is.
+ * The tables follow the Unicode 14.0 character database.
+ *
+ * @param code_point The code point
+ * @return char32_t The folded code point, or the code point itself if it has no folding
+ */
+char32_t fold_case(char32_t code_point) noexcept;
+
+/**
+ * @brief Check whether a code point belongs to a word.
+ *
+ * Letters (general category L) and the marks that combine with them
+ * (category M) belong to words; digits, punctuation, symbols, separators and
+ * control characters do not. The tables follow the Unicode 14.0 character
+ * database; unassigned code points between letters count as letters.
+ *
+ * @param code_point The code point
+ * @return true if the code point is a letter or a mark
+ */
+bool is_letter(char32_t code_point) noexcept;
+
+/**
+ * @brief Append the UTF-8 encoding of a code point.
+ *
+ * @param code_point A Unicode scalar value
+ * @param out The string to append to
+ */
+void append_utf8(char32_t code_point, std::string& out);
+
+} // namespace lingua
+
+#endif // LINGUA_UNICODE_H
@@ -1,6 +1,7 @@
 #include "lingua/alphabet.h"
 #include "lingua/language.h"
-#include <utf8.h>
+#include "lingua/unicode.h"
+#include <array>
 #include <stdexcept>
 #include <algorithm>
 #include <cstdint>
@@ -99,18 +100,19 @@ void CharSet::initialize_from_char_classes(const std::vector<std::string>& char_
 }
 
 bool CharSet::is_match(const std::string& text) const {
-  // Convert UTF-8 string to UTF-32 for character-by-character processing
-  std::vector<char32_t> utf32_chars;
-  try {
-    utf8::utf8to32(text.begin(), text.end(), std::back_inserter(utf32_chars));
-  } catch (const utf8::invalid_utf8&) {
-    return false;
-  }
-  
-  for (char32_t ch : utf32_chars) {
-    if (!is_char_match(ch)) {
+  // Decode in chunks into a buffer on the stack
+  std::array<char32_t, 64> code_points;
+  for (std::string_view rest = text; !rest.empty();) {
+    const Utf8DecodeResult decoded = decode_utf8(rest, code_points);
+    if (decoded.invalid_sequences > 0) {
       return false;
     }
+    for (size_t i = 0; i < decoded.code_points_written; ++i) {
+      if (!is_char_match(code_points[i])) {
+        return false;
+      }
+    }
+    rest.remove_prefix(decoded.bytes_read);
   }
   return true;
 }
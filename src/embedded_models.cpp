@@ -0,0 +1,42 @@
+#include "lingua/embedded_models.h"
+#include <string>
+
+// embedded_models.inc is generated by lingua_embed_models() in cmake/EmbedModels.cmake
+// and lists LINGUA_EMBEDDED_MODEL(iso_code, ngram_length, kind) for every model; the
+// assembly file generated next to it defines a start and an end symbol for each block
+#ifdef LINGUA_EMBED_MODELS
+#define LINGUA_EMBEDDED_MODEL(iso_code, ngram_length, kind) \
+    extern "C" const std::byte lingua_model_##iso_code##_##ngram_length##_##kind[]; \
+    extern "C" const std::byte lingua_model_##iso_code##_##ngram_length##_##kind##_end[];
+#include "embedded_models.inc"
+#undef LINGUA_EMBEDDED_MODEL
+#endif
+
+namespace lingua {
+
+std::span<const EmbeddedModel> embedded_models() {
+#ifdef LINGUA_EMBED_MODELS
+#define LINGUA_EMBEDDED_MODEL(iso_code, ngram_length, kind) \
+    {#iso_code, ngram_length, ModelKind::kind, \
+     lingua_model_##iso_code##_##ngram_length##_##kind, lingua_model_##iso_code##_##ngram_length##_##kind##_end},
+    static const EmbeddedModel models[] = {
+#include "embedded_models.inc"
+    };
+#undef LINGUA_EMBEDDED_MODEL
+    return models;
+#else
+    return {};
+#endif
+}
+
+const EmbeddedModel* find_embedded_model(Language language, size_t ngram_length, ModelKind kind) {
+    const std::string iso_code = iso_code_639_1(language);
+    for (const EmbeddedModel& model : embedded_models()) {
+        if (model.ngram_length == ngram_length && model.kind == kind && iso_code == model.iso_code) {
+            return &model;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace lingua
@@ -0,0 +1,245 @@
+#include "lingua/fingerprint_set.h"
+#include "lingua/hash.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace lingua {
+
+namespace {
+    // Position of the rank-th set bit (0-based) of a word that has more than rank set bits
+    unsigned select_in_word(uint64_t word, unsigned rank) {
+        unsigned base = 0;
+        for (;;) {
+            const auto count = static_cast<unsigned>(std::popcount(word & 0xFF));
+            if (rank < count) {
+                break;
+            }
+            rank -= count;
+            word >>= 8;
+            base += 8;
+        }
+        for (unsigned i = 0; i < rank; ++i) {
+            word &= word - 1;
+        }
+        return base + std::countr_zero(word);
+    }
+}
+
+FingerprintSet::FingerprintSet(const std::vector<std::string_view>& ngrams, unsigned fingerprint_bits)
+    : fingerprint_bits_(fingerprint_bits) {
+    if (fingerprint_bits < MIN_FINGERPRINT_BITS || fingerprint_bits > MAX_FINGERPRINT_BITS) {
+        throw std::invalid_argument("fingerprint width " + std::to_string(fingerprint_bits) + " is not in range 8..64");
+    }
+
+    std::vector<uint64_t> fingerprints;
+    fingerprints.reserve(ngrams.size());
+    for (std::string_view ngram : ngrams) {
+        fingerprints.push_back(fingerprint(ngram, fingerprint_bits));
+    }
+    std::sort(fingerprints.begin(), fingerprints.end());
+    fingerprints.erase(std::unique(fingerprints.begin(), fingerprints.end()), fingerprints.end());
+
+    size_ = fingerprints.size();
+    if (size_ == 0) {
+        return;
+    }
+
+    // Split each fingerprint so that there are between size and 2 * size buckets of high bits;
+    // at least one bit is always high, so the low part is at most 63 bits wide
+    const unsigned high_bit_count = std::min<unsigned>(fingerprint_bits, std::bit_width(size_));
+    lower_bit_count_ = fingerprint_bits - high_bit_count;
+    bucket_count_ = uint64_t{1} << high_bit_count;
+
+    const uint64_t upper_length = size_ + bucket_count_;
+    const size_t upper_word_count = (upper_length + 63) / 64;
+    const size_t lower_word_count = (size_ * lower_bit_count_ + 63) / 64 + 1;
+    std::vector<uint64_t> upper_bits(upper_word_count, 0);
+    std::vector<uint64_t> lower_bits(lower_word_count, 0);
+
+    const uint64_t lower_mask = (uint64_t{1} << lower_bit_count_) - 1;
+    for (size_t i = 0; i < size_; ++i) {
+        const uint64_t high = fingerprints[i] >> lower_bit_count_;
+        const uint64_t position = high + i;
+        upper_bits[position / 64] |= uint64_t{1} << (position % 64);
+
+        if (lower_bit_count_ > 0) {
+            const uint64_t low = fingerprints[i] & lower_mask;
+            const uint64_t bit_position = static_cast<uint64_t>(i) * lower_bit_count_;
+            const unsigned offset = bit_position % 64;
+            lower_bits[bit_position / 64] |= low << offset;
+            if (offset + lower_bit_count_ > 64) {
+                lower_bits[bit_position / 64 + 1] |= low >> (64 - offset);
+            }
+        }
+    }
+
+    std::vector<uint64_t> zero_samples;
+    uint64_t zero_rank = 0;
+    for (uint64_t position = 0; position < upper_length; ++position) {
+        if (((upper_bits[position / 64] >> (position % 64)) & 1) == 0) {
+            if (zero_rank % SELECT_SAMPLE_RATE == 0) {
+                zero_samples.push_back(position);
+            }
+            ++zero_rank;
+        }
+    }
+
+    // Keep the three arrays in one shared allocation: [lower | upper | samples]
+    auto words = std::make_shared<std::vector<uint64_t>>();
+    words->reserve(lower_bits.size() + upper_bits.size() + zero_samples.size());
+    words->insert(words->end(), lower_bits.begin(), lower_bits.end());
+    words->insert(words->end(), upper_bits.begin(), upper_bits.end());
+    words->insert(words->end(), zero_samples.begin(), zero_samples.end());
+    const std::span<const uint64_t> all_words(*words);
+    lower_bits_ = all_words.subspan(0, lower_bits.size());
+    upper_bits_ = all_words.subspan(lower_bits.size(), upper_bits.size());
+    zero_samples_ = all_words.subspan(lower_bits.size() + upper_bits.size());
+    owner_ = std::move(words);
+}
+
+FingerprintSet FingerprintSet::from_parts(
+    size_t size,
+    unsigned fingerprint_bits,
+    unsigned lower_bit_count,
+    uint64_t bucket_count,
+    std::span<const uint64_t> lower_bits,
+    std::span<const uint64_t> upper_bits,
+    std::span<const uint64_t> zero_samples,
+    std::shared_ptr<const void> owner
+) {
+    FingerprintSet set;
+    set.size_ = size;
+    set.fingerprint_bits_ = fingerprint_bits;
+    set.lower_bit_count_ = lower_bit_count;
+    set.bucket_count_ = bucket_count;
+    set.lower_bits_ = lower_bits;
+    set.upper_bits_ = upper_bits;
+    set.zero_samples_ = zero_samples;
+    set.owner_ = std::move(owner);
+    return set;
+}
+
+unsigned FingerprintSet::fingerprint_bits_for(size_t ngram_count, double false_positive_rate) {
+    if (!(false_positive_rate > 0.0 && false_positive_rate < 1.0)) {
+        throw std::invalid_argument("false-positive rate must lie in between 0.0 and 1.0 exclusively");
+    }
+    const double bits = std::ceil(std::log2(static_cast<double>(std::max<size_t>(ngram_count, 1)) / false_positive_rate));
+    return static_cast<unsigned>(std::clamp(bits, double{MIN_FINGERPRINT_BITS}, double{MAX_FINGERPRINT_BITS}));
+}
+
+uint64_t FingerprintSet::fingerprint(std::string_view ngram, unsigned fingerprint_bits) {
+    return hash_bytes(ngram) >> (64 - fingerprint_bits);
+}
+
+bool FingerprintSet::contains(std::string_view ngram) const {
+    if (size_ == 0) {
+        return false;
+    }
+    return contains_fingerprint(fingerprint(ngram, fingerprint_bits_));
+}
+
+size_t FingerprintSet::size() const {
+    return size_;
+}
+
+unsigned FingerprintSet::fingerprint_bits() const {
+    return fingerprint_bits_;
+}
+
+double FingerprintSet::false_positive_rate() const {
+    if (size_ == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(size_) / std::exp2(static_cast<double>(fingerprint_bits_));
+}
+
+size_t FingerprintSet::memory_usage_bytes() const {
+    return sizeof(FingerprintSet) + lower_bits_.size_bytes() + upper_bits_.size_bytes() + zero_samples_.size_bytes();
+}
+
+unsigned FingerprintSet::lower_bit_count() const {
+    return lower_bit_count_;
+}
+
+uint64_t FingerprintSet::bucket_count() const {
+    return bucket_count_;
+}
+
+std::span<const uint64_t> FingerprintSet::lower_bits() const {
+    return lower_bits_;
+}
+
+std::span<const uint64_t> FingerprintSet::upper_bits() const {
+    return upper_bits_;
+}
+
+std::span<const uint64_t> FingerprintSet::zero_samples() const {
+    return zero_samples_;
+}
+
+bool FingerprintSet::contains_fingerprint(uint64_t fingerprint) const {
+    const uint64_t high = fingerprint >> lower_bit_count_;
+    const uint64_t low = fingerprint & ((uint64_t{1} << lower_bit_count_) - 1);
+    if (high >= bucket_count_) {
+        return false;
+    }
+
+    // Bucket `high` starts right after the high-th zero and ends at the next zero;
+    // its elements are the ones in between, stored in ascending order of low bits.
+    uint64_t position = high == 0 ? 0 : select_zero(high - 1) + 1;
+    for (; upper_bit_at(position); ++position) {
+        const uint64_t candidate = lower_bits_at(position - high);
+        if (candidate == low) {
+            return true;
+        }
+        if (candidate > low) {
+            return false;
+        }
+    }
+    return false;
+}
+
+uint64_t FingerprintSet::lower_bits_at(size_t index) const {
+    if (lower_bit_count_ == 0) {
+        return 0;
+    }
+    const uint64_t bit_position = static_cast<uint64_t>(index) * lower_bit_count_;
+    const unsigned offset = bit_position % 64;
+    uint64_t value = lower_bits_[bit_position / 64] >> offset;
+    if (offset + lower_bit_count_ > 64) {
+        value |= lower_bits_[bit_position / 64 + 1] << (64 - offset);
+    }
+    return value & ((uint64_t{1} << lower_bit_count_) - 1);
+}
+
+bool FingerprintSet::upper_bit_at(uint64_t position) const {
+    return (upper_bits_[position / 64] >> (position % 64)) & 1;
+}
+
+uint64_t FingerprintSet::select_zero(uint64_t rank) const {
+    uint64_t position = zero_samples_[rank / SELECT_SAMPLE_RATE];
+    uint64_t remaining = rank % SELECT_SAMPLE_RATE;
+    if (remaining == 0) {
+        return position;
+    }
+
+    // Skip the sampled zero itself, then count zeros word by word
+    ++position;
+    size_t word_index = position / 64;
+    uint64_t zeros = ~upper_bits_[word_index] & (~uint64_t{0} << (position % 64));
+    --remaining;
+    for (;;) {
+        const auto count = static_cast<uint64_t>(std::popcount(zeros));
+        if (remaining < count) {
+            return word_index * 64 + select_in_word(zeros, static_cast<unsigned>(remaining));
+        }
+        remaining -= count;
+        zeros = ~upper_bits_[++word_index];
+    }
+}
+
+} // namespace lingua
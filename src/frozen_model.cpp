@@ -0,0 +1,306 @@
+#include "lingua/frozen_model.h"
+#include "lingua/exception.h"
+#include "lingua/hash.h"
+#include "lingua/ngram_hasher.h"
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+namespace lingua {
+
+namespace {
+    enum HashTableSection { SLOTS = 0, KEY_OFFSETS = 1, KEY_BYTES = 2, VALUE_INDICES = 3, VALUES = 4 };
+    enum FingerprintSection { LOWER_BITS = 0, UPPER_BITS = 1, ZERO_SAMPLES = 2 };
+
+    template <typename T>
+    const T* section_data(std::span<const std::byte> bytes, const FrozenModelSection& section) {
+        return reinterpret_cast<const T*>(bytes.data() + section.offset);
+    }
+
+    template <typename T>
+    std::span<const T> section_span(std::span<const std::byte> bytes, const FrozenModelSection& section) {
+        return {section_data<T>(bytes, section), section.size / sizeof(T)};
+    }
+}
+
+FrozenModel FrozenModel::from_bytes(std::span<const std::byte> bytes, std::shared_ptr<const void> owner) {
+    if (bytes.size() < sizeof(FrozenModelHeader)) {
+        throw ModelLoadException("Frozen model block is too small");
+    }
+    if (reinterpret_cast<uintptr_t>(bytes.data()) % 8 != 0) {
+        throw ModelLoadException("Frozen model block is not 8-byte aligned");
+    }
+
+    const auto* header = reinterpret_cast<const FrozenModelHeader*>(bytes.data());
+    if (std::memcmp(header->magic, FrozenModelHeader::MAGIC, sizeof(header->magic)) != 0) {
+        throw ModelLoadException("Frozen model block has no valid magic number");
+    }
+    if (header->byte_order != FrozenModelHeader::BYTE_ORDER_MARK) {
+        throw ModelLoadException("Frozen model block was written with a different byte order");
+    }
+    if (header->format_version != FrozenModelHeader::FORMAT_VERSION) {
+        throw ModelLoadException("Unsupported frozen model format version " + std::to_string(header->format_version));
+    }
+    if (header->total_size > bytes.size()) {
+        throw ModelLoadException("Frozen model block is truncated");
+    }
+    if (header->ngram_length < 1 || header->ngram_length > 5 || header->kind > static_cast<uint8_t>(ModelKind::MOST_COMMON)) {
+        throw ModelLoadException("Frozen model block has an invalid n-gram length or kind");
+    }
+    for (const auto& section : header->sections) {
+        if (section.offset % 8 != 0 || section.offset > header->total_size || section.size > header->total_size - section.offset) {
+            throw ModelLoadException("Frozen model block has a section out of bounds");
+        }
+    }
+
+    FrozenModel model;
+    model.owner_ = std::move(owner);
+    model.bytes_ = bytes.first(header->total_size);
+    model.header_ = header;
+    try {
+        model.language_ = from_iso_code_639_1(std::string(header->iso_code, strnlen(header->iso_code, sizeof(header->iso_code))));
+    } catch (const std::exception&) {
+        throw ModelLoadException("Frozen model block has an unknown language");
+    }
+
+    const auto& sections = header->sections;
+    if (header->layout == static_cast<uint8_t>(FrozenModelLayout::HASH_TABLE)) {
+        const bool has_values = header->kind == static_cast<uint8_t>(ModelKind::PROBABILITY);
+        const uint64_t slot_count = header->slot_count;
+        if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0 || slot_count <= header->ngram_count
+            || sections[SLOTS].size != slot_count * sizeof(uint64_t)
+            || sections[KEY_OFFSETS].size != (header->ngram_count + 1) * sizeof(uint32_t)
+            || (has_values && header->value_index_width != 2 && header->value_index_width != 4)
+            || (has_values && sections[VALUE_INDICES].size != header->ngram_count * header->value_index_width)
+            || (has_values && sections[VALUES].size != header->value_count * sizeof(double))) {
+            throw ModelLoadException("Frozen model block has an inconsistent hash table");
+        }
+        model.slots_ = section_data<uint64_t>(model.bytes_, sections[SLOTS]);
+        model.slot_mask_ = slot_count - 1;
+        model.key_offsets_ = section_data<uint32_t>(model.bytes_, sections[KEY_OFFSETS]);
+        model.key_bytes_ = section_data<char>(model.bytes_, sections[KEY_BYTES]);
+        model.key_byte_count_ = sections[KEY_BYTES].size;
+        if (model.key_offsets_[header->ngram_count] > sections[KEY_BYTES].size) {
+            throw ModelLoadException("Frozen model block has key offsets out of bounds");
+        }
+        if (has_values) {
+            model.value_indices_ = section_data<std::byte>(model.bytes_, sections[VALUE_INDICES]);
+            model.values_ = section_data<double>(model.bytes_, sections[VALUES]);
+        }
+    } else if (header->layout == static_cast<uint8_t>(FrozenModelLayout::FINGERPRINTS)) {
+        if (header->fingerprint_bits < FingerprintSet::MIN_FINGERPRINT_BITS
+            || header->fingerprint_bits > FingerprintSet::MAX_FINGERPRINT_BITS
+            || header->lower_bit_count >= header->fingerprint_bits) {
+            throw ModelLoadException("Frozen model block has invalid fingerprint parameters");
+        }
+        model.fingerprints_ = FingerprintSet::from_parts(
+            header->ngram_count,
+            header->fingerprint_bits,
+            header->lower_bit_count,
+            header->slot_count,
+            section_span<uint64_t>(model.bytes_, sections[LOWER_BITS]),
+            section_span<uint64_t>(model.bytes_, sections[UPPER_BITS]),
+            section_span<uint64_t>(model.bytes_, sections[ZERO_SAMPLES]),
+            model.owner_
+        );
+    } else if (header->layout == static_cast<uint8_t>(FrozenModelLayout::HASHED_NGRAMS)) {
+        const bool has_values = header->kind == static_cast<uint8_t>(ModelKind::PROBABILITY);
+        const uint64_t slot_count = header->slot_count;
+        if (slot_count == 0 || (slot_count & (slot_count - 1)) != 0 || slot_count <= header->ngram_count
+            || sections[SLOTS].size != slot_count * sizeof(uint16_t)
+            || (has_values && header->value_index_width != 2 && header->value_index_width != 4)
+            || (has_values && sections[VALUE_INDICES].size != slot_count * header->value_index_width)
+            || (has_values && sections[VALUES].size != header->value_count * sizeof(double))) {
+            throw ModelLoadException("Frozen model block has an inconsistent hashed n-gram index");
+        }
+        model.slot_fingerprints_ = section_data<uint16_t>(model.bytes_, sections[SLOTS]);
+        model.slot_mask_ = slot_count - 1;
+        if (has_values) {
+            model.value_indices_ = section_data<std::byte>(model.bytes_, sections[VALUE_INDICES]);
+            model.values_ = section_data<double>(model.bytes_, sections[VALUES]);
+        }
+    } else {
+        throw ModelLoadException("Frozen model block has an unknown layout");
+    }
+
+    return model;
+}
+
+FrozenModel FrozenModel::read_from(const std::string& file_path, PagePolicy pages) {
+    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw ModelLoadException("Cannot open model file: " + file_path);
+    }
+    const auto size = static_cast<size_t>(file.tellg());
+    file.seekg(0);
+
+    auto storage = ModelMemory::allocate(size, pages);
+    if (!file.read(reinterpret_cast<char*>(storage->bytes().data()), static_cast<std::streamsize>(size))) {
+        throw ModelLoadException("Cannot read model file: " + file_path);
+    }
+    const std::span<const std::byte> bytes = storage->bytes();
+    return from_bytes(bytes, std::move(storage));
+}
+
+FrozenModel FrozenModel::map_from(const std::string& file_path, const MappingOptions& options) {
+    auto file = MappedFile::open(file_path, options);
+    const std::span<const std::byte> bytes = file->bytes();
+    return from_bytes(bytes, std::move(file));
+}
+
+void FrozenModel::write_to(const std::string& file_path) const {
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        throw ModelLoadException("Cannot create model file: " + file_path);
+    }
+    if (!file.write(reinterpret_cast<const char*>(bytes_.data()), static_cast<std::streamsize>(bytes_.size()))) {
+        throw ModelLoadException("Cannot write model file: " + file_path);
+    }
+}
+
+Language FrozenModel::get_language() const {
+    return language_;
+}
+
+size_t FrozenModel::get_ngram_length() const {
+    return header_->ngram_length;
+}
+
+ModelKind FrozenModel::get_kind() const {
+    return static_cast<ModelKind>(header_->kind);
+}
+
+FrozenModelLayout FrozenModel::get_layout() const {
+    return static_cast<FrozenModelLayout>(header_->layout);
+}
+
+size_t FrozenModel::size() const {
+    return header_->ngram_count;
+}
+
+bool FrozenModel::contains(std::string_view ngram) const {
+    if (slot_fingerprints_ != nullptr) {
+        const auto ngram_hash = NgramHasher::hash_of_utf8(ngram);
+        return ngram_hash && contains_hash(*ngram_hash);
+    }
+    if (slots_ == nullptr) {
+        return fingerprints_.contains(ngram);
+    }
+    return find_entry(ngram) >= 0;
+}
+
+double FrozenModel::get_probability(std::string_view ngram) const {
+    if (values_ == nullptr) {
+        return 0.0;
+    }
+    if (slot_fingerprints_ != nullptr) {
+        const auto ngram_hash = NgramHasher::hash_of_utf8(ngram);
+        return ngram_hash ? get_probability_by_hash(*ngram_hash) : 0.0;
+    }
+    const int64_t entry = find_entry(ngram);
+    return entry < 0 ? 0.0 : value_at(static_cast<size_t>(entry));
+}
+
+bool FrozenModel::contains_hash(uint64_t ngram_hash) const {
+    return slot_fingerprints_ != nullptr && find_hashed_slot(ngram_hash) >= 0;
+}
+
+double FrozenModel::get_probability_by_hash(uint64_t ngram_hash) const {
+    if (slot_fingerprints_ == nullptr || values_ == nullptr) {
+        return 0.0;
+    }
+    const int64_t slot = find_hashed_slot(ngram_hash);
+    return slot < 0 ? 0.0 : value_at(static_cast<size_t>(slot));
+}
+
+std::string_view FrozenModel::ngram_at(size_t index) const {
+    const uint32_t begin = key_offsets_[index];
+    const uint32_t end = key_offsets_[index + 1];
+    if (begin > end || end > key_byte_count_) {
+        return {};
+    }
+    return {key_bytes_ + begin, end - begin};
+}
+
+double FrozenModel::probability_at(size_t index) const {
+    return values_ == nullptr ? 0.0 : value_at(index);
+}
+
+double FrozenModel::false_positive_rate() const {
+    if (slot_fingerprints_ != nullptr) {
+        // A missing hash is compared with the fingerprints of the occupied slots it probes,
+        // of which linear probing visits (1 + 1 / (1 - load)^2) / 2 - 1 on average
+        const double load = static_cast<double>(header_->ngram_count) / static_cast<double>(header_->slot_count);
+        const double occupied_probes = (1.0 + 1.0 / ((1.0 - load) * (1.0 - load))) / 2.0 - 1.0;
+        return occupied_probes / 65535.0;
+    }
+    return slots_ == nullptr ? fingerprints_.false_positive_rate() : 0.0;
+}
+
+std::span<const std::byte> FrozenModel::bytes() const {
+    return bytes_;
+}
+
+size_t FrozenModel::memory_usage_bytes() const {
+    return sizeof(FrozenModel) + bytes_.size();
+}
+
+int64_t FrozenModel::find_entry(std::string_view ngram) const {
+    const uint64_t hash = hash_bytes(ngram);
+    const uint64_t tag = hash >> 32;
+    // Bounded by the slot count in case a corrupt table has no empty slot
+    uint64_t slot = hash & slot_mask_;
+    for (uint64_t probe = 0; probe <= slot_mask_; ++probe, slot = (slot + 1) & slot_mask_) {
+        const uint64_t value = slots_[slot];
+        if (value == 0) {
+            return -1;
+        }
+        if ((value >> 32) == tag) {
+            // An entry of 0 wraps around to an index that is out of range as well
+            const uint32_t entry = static_cast<uint32_t>(value) - 1;
+            if (entry >= header_->ngram_count) {
+                return -1;
+            }
+            const std::string_view key = ngram_at(entry);
+            if (key.size() == ngram.size() && std::memcmp(key.data(), ngram.data(), ngram.size()) == 0) {
+                return entry;
+            }
+        }
+    }
+    return -1;
+}
+
+int64_t FrozenModel::find_hashed_slot(uint64_t ngram_hash) const {
+    const uint16_t fingerprint = hash_fingerprint(ngram_hash);
+    // Bounded by the slot count in case a corrupt index has no empty slot
+    uint64_t slot = ngram_hash & slot_mask_;
+    for (uint64_t probe = 0; probe <= slot_mask_; ++probe, slot = (slot + 1) & slot_mask_) {
+        const uint16_t stored = slot_fingerprints_[slot];
+        if (stored == 0) {
+            return -1;
+        }
+        if (stored == fingerprint) {
+            return static_cast<int64_t>(slot);
+        }
+    }
+    return -1;
+}
+
+uint32_t FrozenModel::value_index_at(size_t index) const {
+    if (header_->value_index_width == 2) {
+        uint16_t value_index;
+        std::memcpy(&value_index, value_indices_ + index * 2, sizeof(value_index));
+        return value_index;
+    }
+    uint32_t value_index;
+    std::memcpy(&value_index, value_indices_ + index * 4, sizeof(value_index));
+    return value_index;
+}
+
+double FrozenModel::value_at(size_t index) const {
+    const uint32_t value_index = value_index_at(index);
+    return value_index < header_->value_count ? values_[value_index] : 0.0;
+}
+
+} // namespace lingua
@@ -13,14 +13,19 @@ LanguageDetector::LanguageDetector(
     std::unordered_set<Language> languages,
     double minimum_relative_distance,
     bool is_every_language_model_preloaded,
-    bool is_low_accuracy_mode_enabled)
+    bool is_low_accuracy_mode_enabled,
+    const ModelPreloadCallback& on_preload_progress)
     : languages_(std::move(languages)),
       minimum_relative_distance_(minimum_relative_distance),
       is_low_accuracy_mode_enabled_(is_low_accuracy_mode_enabled),
       is_built_from_one_language_(languages_.size() == 1) {
-    // In a full implementation, we would load language models here
-    // Unused parameter, but kept for API consistency:
-    (void)is_every_language_model_preloaded;
+    if (is_every_language_model_preloaded) {
+        // Low accuracy mode only uses trigrams
+        const std::vector<size_t> ngram_lengths = is_low_accuracy_mode_enabled_
+            ? std::vector<size_t>{3}
+            : std::vector<size_t>{1, 2, 3, 4, 5};
+        preload_report_ = ModelLoader::get_instance().preload_models(languages_, ngram_lengths, on_preload_progress);
+    }
 }
 
 std::optional<Language> LanguageDetector::detect_language_of(const std::string& text) const {
@@ -238,7 +243,15 @@ std::vector<double> LanguageDetector::compute_language_confidence_of(
 }
 
 void LanguageDetector::unload_language_models() {
-    // In a full implementation, this would unload language models and free memory
+    ModelLoader::get_instance().unload_models(languages_);
+}
+
+ModelMemoryReport LanguageDetector::memory_report() const {
+    return ModelLoader::get_instance().memory_report(languages_);
+}
+
+const std::optional<ModelPreloadReport>& LanguageDetector::preload_report() const {
+    return preload_report_;
 }
 
 } // namespace lingua
\ No newline at end of file
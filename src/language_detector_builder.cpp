@@ -110,6 +110,12 @@ LanguageDetectorBuilder& LanguageDetectorBuilder::with_preloaded_language_models
     return *this;
 }
 
+LanguageDetectorBuilder& LanguageDetectorBuilder::with_preloaded_language_models(ModelPreloadCallback on_progress) {
+    is_every_language_model_preloaded_ = true;
+    preload_progress_callback_ = std::move(on_progress);
+    return *this;
+}
+
 LanguageDetectorBuilder& LanguageDetectorBuilder::with_low_accuracy_mode() {
     is_low_accuracy_mode_enabled_ = true;
     return *this;
@@ -124,7 +130,8 @@ LanguageDetector LanguageDetectorBuilder::build() {
         languages_,
         minimum_relative_distance_,
         is_every_language_model_preloaded_,
-        is_low_accuracy_mode_enabled_
+        is_low_accuracy_mode_enabled_,
+        preload_progress_callback_
     );
 }
 
@@ -0,0 +1,273 @@
+#include "lingua/mapped_file.h"
+#include "lingua/exception.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#include <vector>
+#endif
+
+namespace lingua {
+
+#ifndef _WIN32
+
+namespace {
+    // Closes the descriptor on every exit path; the mapping stays valid after close
+    struct FileDescriptor {
+        int fd;
+        ~FileDescriptor() {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+    };
+
+    std::string errno_message() {
+        return std::strerror(errno);
+    }
+
+    size_t page_size() {
+        return static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    }
+
+    size_t round_up(size_t size, size_t alignment) {
+        return (size + alignment - 1) / alignment * alignment;
+    }
+
+    // Reserves whole pages for size bytes starting at a huge page boundary, or returns nullptr
+    void* map_aligned(size_t size, int protection) {
+        const size_t padded_size = size + ModelMemory::HUGE_PAGE_SIZE;
+        void* padded = ::mmap(nullptr, padded_size, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (padded == MAP_FAILED) {
+            return nullptr;
+        }
+        const auto start = reinterpret_cast<uintptr_t>(padded);
+        const uintptr_t aligned = round_up(start, ModelMemory::HUGE_PAGE_SIZE);
+        const uintptr_t end = aligned + round_up(size, page_size());
+        if (aligned != start) {
+            ::munmap(padded, aligned - start);
+        }
+        if (end != start + padded_size) {
+            ::munmap(reinterpret_cast<void*>(end), start + padded_size - end);
+        }
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    bool advise_huge_pages([[maybe_unused]] void* address, [[maybe_unused]] size_t size) {
+#ifdef MADV_HUGEPAGE
+        return ::madvise(address, size, MADV_HUGEPAGE) == 0;
+#else
+        return false;
+#endif
+    }
+
+    // Makes node the preferred node of the pages, which must not have been touched yet
+    bool bind_to_node([[maybe_unused]] void* address, [[maybe_unused]] size_t size, [[maybe_unused]] int node) {
+#if defined(__linux__) && defined(SYS_mbind)
+        constexpr size_t bits = 8 * sizeof(unsigned long);
+        std::vector<unsigned long> mask(static_cast<size_t>(node) / bits + 1, 0);
+        mask.back() |= 1UL << (static_cast<size_t>(node) % bits);
+        // The kernel reads maxnode - 1 bits of the mask
+        return ::syscall(SYS_mbind, address, size, MPOL_PREFERRED, mask.data(), mask.size() * bits + 1, 0) == 0;
+#else
+        return false;
+#endif
+    }
+}
+
+std::shared_ptr<const MappedFile> MappedFile::open(const std::string& file_path, const MappingOptions& options) {
+    FileDescriptor file{::open(file_path.c_str(), O_RDONLY | O_CLOEXEC)};
+    if (file.fd < 0) {
+        throw ModelLoadException("Cannot open model file: " + file_path + ": " + errno_message());
+    }
+    struct stat status {};
+    if (::fstat(file.fd, &status) != 0) {
+        throw ModelLoadException("Cannot stat model file: " + file_path + ": " + errno_message());
+    }
+    if (status.st_size == 0) {
+        throw ModelLoadException("Model file is empty: " + file_path);
+    }
+
+    const auto size = static_cast<size_t>(status.st_size);
+    // Huge pages need an aligned address, and must be advised before the pages are faulted in
+    const bool huge_pages = options.pages == PagePolicy::HUGE_PAGES && size >= ModelMemory::HUGE_PAGE_SIZE;
+    void* address = huge_pages ? map_aligned(size, PROT_NONE) : nullptr;
+    int flags = MAP_PRIVATE;
+    if (address != nullptr) {
+        flags |= MAP_FIXED;
+    }
+#ifdef MAP_POPULATE
+    if (options.populate && !huge_pages) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    void* mapping = ::mmap(address, size, PROT_READ, flags, file.fd, 0);
+    if (mapping == MAP_FAILED) {
+        const std::string message = errno_message();
+        if (address != nullptr) {
+            ::munmap(address, size);
+        }
+        throw ModelLoadException("Cannot map model file: " + file_path + ": " + message);
+    }
+    address = mapping;
+
+    std::shared_ptr<MappedFile> mapped(new MappedFile());
+    mapped->data_ = static_cast<const std::byte*>(address);
+    mapped->size_ = size;
+    if (huge_pages) {
+        mapped->huge_pages_ = advise_huge_pages(address, size);
+        if (options.populate) {
+            // A volatile read of one byte per page faults it in
+            for (size_t offset = 0; offset < size; offset += page_size()) {
+                static_cast<void>(*static_cast<const volatile std::byte*>(mapped->data_ + offset));
+            }
+        }
+    }
+
+    // Advice is only a hint, so failures are ignored
+    if (options.advice == MappingAdvice::RANDOM) {
+        ::madvise(address, size, MADV_RANDOM);
+    } else if (options.advice == MappingAdvice::WILLNEED) {
+        ::madvise(address, size, MADV_WILLNEED);
+    }
+
+    if (options.lock) {
+        if (::mlock(address, size) != 0) {
+            throw ModelLoadException("Cannot lock model file in memory (see RLIMIT_MEMLOCK): " + file_path + ": " + errno_message());
+        }
+        mapped->locked_ = true;
+    }
+    return mapped;
+}
+
+MappedFile::~MappedFile() {
+    if (fallback_.empty() && data_ != nullptr) {
+        void* address = const_cast<std::byte*>(data_);
+        if (locked_) {
+            ::munlock(address, size_);
+        }
+        ::munmap(address, size_);
+    }
+}
+
+size_t MappedFile::resident_bytes() const {
+    if (!fallback_.empty()) {
+        return size_;
+    }
+    std::vector<unsigned char> pages((size_ + page_size() - 1) / page_size());
+    if (::mincore(const_cast<std::byte*>(data_), size_, pages.data()) != 0) {
+        return 0;
+    }
+    size_t resident = 0;
+    for (unsigned char page : pages) {
+        resident += (page & 1) * page_size();
+    }
+    return resident;
+}
+
+std::shared_ptr<ModelMemory> ModelMemory::allocate(size_t size, PagePolicy pages, int numa_node) {
+    std::shared_ptr<ModelMemory> memory(new ModelMemory());
+    memory->size_ = size;
+    const bool huge_pages = pages == PagePolicy::HUGE_PAGES && size >= HUGE_PAGE_SIZE;
+    if (huge_pages || numa_node >= 0) {
+        // Anonymous mappings are zeroed already
+        const size_t mapped_size = round_up(std::max<size_t>(size, 1), page_size());
+        void* address = huge_pages ? map_aligned(size, PROT_READ | PROT_WRITE)
+                                   : ::mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (address != nullptr && address != MAP_FAILED) {
+            memory->data_ = static_cast<std::byte*>(address);
+            memory->mapped_size_ = mapped_size;
+            if (numa_node >= 0) {
+                memory->bound_to_node_ = bind_to_node(address, mapped_size, numa_node);
+            }
+            if (huge_pages) {
+                memory->huge_pages_ = advise_huge_pages(address, mapped_size);
+            }
+            return memory;
+        }
+    }
+    memory->heap_.reset(new uint64_t[(size + 7) / 8]());
+    memory->data_ = reinterpret_cast<std::byte*>(memory->heap_.get());
+    return memory;
+}
+
+ModelMemory::~ModelMemory() {
+    if (mapped_size_ != 0) {
+        ::munmap(data_, mapped_size_);
+    }
+}
+
+#else
+
+std::shared_ptr<const MappedFile> MappedFile::open(const std::string& file_path, const MappingOptions&) {
+    std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        throw ModelLoadException("Cannot open model file: " + file_path);
+    }
+    const auto size = static_cast<size_t>(file.tellg());
+    if (size == 0) {
+        throw ModelLoadException("Model file is empty: " + file_path);
+    }
+    file.seekg(0);
+
+    std::shared_ptr<MappedFile> mapped(new MappedFile());
+    mapped->fallback_.resize((size + 7) / 8);
+    if (!file.read(reinterpret_cast<char*>(mapped->fallback_.data()), static_cast<std::streamsize>(size))) {
+        throw ModelLoadException("Cannot read model file: " + file_path);
+    }
+    mapped->data_ = reinterpret_cast<const std::byte*>(mapped->fallback_.data());
+    mapped->size_ = size;
+    return mapped;
+}
+
+MappedFile::~MappedFile() = default;
+
+size_t MappedFile::resident_bytes() const {
+    return size_;
+}
+
+std::shared_ptr<ModelMemory> ModelMemory::allocate(size_t size, PagePolicy, int) {
+    std::shared_ptr<ModelMemory> memory(new ModelMemory());
+    memory->size_ = size;
+    memory->heap_.reset(new uint64_t[(size + 7) / 8]());
+    memory->data_ = reinterpret_cast<std::byte*>(memory->heap_.get());
+    return memory;
+}
+
+ModelMemory::~ModelMemory() = default;
+
+#endif
+
+std::span<const std::byte> MappedFile::bytes() const {
+    return {data_, size_};
+}
+
+bool MappedFile::uses_huge_pages() const {
+    return huge_pages_;
+}
+
+std::span<std::byte> ModelMemory::bytes() const {
+    return {data_, size_};
+}
+
+bool ModelMemory::uses_huge_pages() const {
+    return huge_pages_;
+}
+
+bool ModelMemory::is_bound_to_node() const {
+    return bound_to_node_;
+}
+
+} // namespace lingua
@@ -1,8 +1,22 @@
 #include "lingua/model.h"
+#include "lingua/ngram_hasher.h"
+#include <numeric>
 #include <stdexcept>
+#include <utility>
 
 namespace lingua {
 
+namespace {
+    // The replica of node 0, once there is one replica per node
+    const FrozenModel& first_replica(const std::vector<FrozenModel>& replicas,
+                                     const std::shared_ptr<const NumaTopology>& topology, const char* model_name) {
+        if (!topology || replicas.empty() || replicas.size() != topology->node_count()) {
+            throw std::invalid_argument(std::string(model_name) + " requires one replica per NUMA node");
+        }
+        return replicas.front();
+    }
+}
+
 std::string to_string(NgramModelType model_type) {
     switch (model_type) {
         case NgramModelType::UNIQUE:
@@ -14,66 +28,171 @@ std::string to_string(NgramModelType model_type) {
     }
 }
 
+std::string to_string(ModelKind kind) {
+    switch (kind) {
+        case ModelKind::PROBABILITY:
+            return "probability";
+        case ModelKind::UNIQUE:
+            return "unique";
+        case ModelKind::MOST_COMMON:
+            return "most_common";
+        default:
+            throw std::invalid_argument("Unknown ModelKind");
+    }
+}
+
 // NgramProbabilityModel implementation
 
-NgramProbabilityModel::NgramProbabilityModel(Language language) : language_(language) {}
+NgramProbabilityModel::NgramProbabilityModel(FrozenModel model) : model_(std::move(model)) {
+    if (model_.get_kind() != ModelKind::PROBABILITY) {
+        throw std::invalid_argument("NgramProbabilityModel requires a probability model, got " + to_string(model_.get_kind()));
+    }
+}
+
+NgramProbabilityModel::NgramProbabilityModel(std::vector<FrozenModel> replicas,
+                                             std::shared_ptr<const NumaTopology> topology)
+    : NgramProbabilityModel(first_replica(replicas, topology, "NgramProbabilityModel")) {
+    for (const FrozenModel& replica : replicas) {
+        if (replica.get_kind() != ModelKind::PROBABILITY) {
+            throw std::invalid_argument("NgramProbabilityModel requires probability model replicas");
+        }
+    }
+    replicas_ = std::move(replicas);
+    topology_ = std::move(topology);
+}
+
+const FrozenModel& NgramProbabilityModel::local_model() const {
+    return replicas_.empty() ? model_ : replicas_[topology_->current_node()];
+}
 
 Language NgramProbabilityModel::get_language() const {
-    return language_;
+    return model_.get_language();
 }
 
 double NgramProbabilityModel::get_probability(const Ngram& ngram) const {
-    auto it = ngrams_.find(ngram.get_value());
-    if (it != ngrams_.end()) {
-        return it->second;
+    const FrozenModel& model = local_model();
+    if (model.get_layout() == FrozenModelLayout::HASHED_NGRAMS) {
+        return model.get_probability_by_hash(NgramHasher::hash_of(ngram));
     }
-    return 0.0;
+    Ngram::Utf8Buffer buffer;
+    return model.get_probability(ngram.to_utf8(buffer));
 }
 
-void NgramProbabilityModel::set_probability(const Ngram& ngram, double probability) {
-    ngrams_[ngram.get_value()] = probability;
+double NgramProbabilityModel::get_probability(std::string_view ngram) const {
+    return local_model().get_probability(ngram);
 }
 
 bool NgramProbabilityModel::contains(const Ngram& ngram) const {
-    return ngrams_.find(ngram.get_value()) != ngrams_.end();
+    const FrozenModel& model = local_model();
+    if (model.get_layout() == FrozenModelLayout::HASHED_NGRAMS) {
+        return model.contains_hash(NgramHasher::hash_of(ngram));
+    }
+    Ngram::Utf8Buffer buffer;
+    return model.contains(ngram.to_utf8(buffer));
+}
+
+bool NgramProbabilityModel::contains(std::string_view ngram) const {
+    return local_model().contains(ngram);
+}
+
+double NgramProbabilityModel::get_probability_by_hash(uint64_t ngram_hash) const {
+    return local_model().get_probability_by_hash(ngram_hash);
 }
 
 size_t NgramProbabilityModel::size() const {
-    return ngrams_.size();
+    return model_.size();
+}
+
+size_t NgramProbabilityModel::memory_usage_bytes() const {
+    if (replicas_.empty()) {
+        return sizeof(NgramProbabilityModel) - sizeof(FrozenModel) + model_.memory_usage_bytes();
+    }
+    return std::accumulate(replicas_.begin(), replicas_.end(), sizeof(NgramProbabilityModel) - sizeof(FrozenModel),
+                           [](size_t total, const FrozenModel& replica) { return total + replica.memory_usage_bytes(); });
+}
+
+size_t NgramProbabilityModel::replica_count() const {
+    return replicas_.empty() ? 1 : replicas_.size();
+}
+
+const FrozenModel& NgramProbabilityModel::frozen_model() const {
+    return model_;
 }
 
 // NgramCountModel implementation
 
-NgramCountModel::NgramCountModel(Language language, NgramModelType model_type) 
-    : language_(language), model_type_(model_type) {}
+NgramCountModel::NgramCountModel(FrozenModel model) : model_(std::move(model)) {
+    if (model_.get_kind() == ModelKind::PROBABILITY) {
+        throw std::invalid_argument("NgramCountModel requires a unique or most common n-gram set");
+    }
+}
+
+NgramCountModel::NgramCountModel(std::vector<FrozenModel> replicas, std::shared_ptr<const NumaTopology> topology)
+    : NgramCountModel(first_replica(replicas, topology, "NgramCountModel")) {
+    for (const FrozenModel& replica : replicas) {
+        if (replica.get_kind() == ModelKind::PROBABILITY) {
+            throw std::invalid_argument("NgramCountModel requires unique or most common n-gram set replicas");
+        }
+    }
+    replicas_ = std::move(replicas);
+    topology_ = std::move(topology);
+}
+
+const FrozenModel& NgramCountModel::local_model() const {
+    return replicas_.empty() ? model_ : replicas_[topology_->current_node()];
+}
 
 Language NgramCountModel::get_language() const {
-    return language_;
+    return model_.get_language();
 }
 
 NgramModelType NgramCountModel::get_model_type() const {
-    return model_type_;
+    return model_.get_kind() == ModelKind::UNIQUE ? NgramModelType::UNIQUE : NgramModelType::MOST_COMMON;
 }
 
 bool NgramCountModel::contains(const Ngram& ngram) const {
-    return ngrams_.find(ngram.get_value()) != ngrams_.end();
+    const FrozenModel& model = local_model();
+    if (model.get_layout() == FrozenModelLayout::HASHED_NGRAMS) {
+        return model.contains_hash(NgramHasher::hash_of(ngram));
+    }
+    Ngram::Utf8Buffer buffer;
+    return model.contains(ngram.to_utf8(buffer));
 }
 
-void NgramCountModel::add_ngram(const Ngram& ngram) {
-    ngrams_.insert(ngram.get_value());
+bool NgramCountModel::contains(std::string_view ngram) const {
+    return local_model().contains(ngram);
 }
 
-bool NgramCountModel::remove_ngram(const Ngram& ngram) {
-    auto it = ngrams_.find(ngram.get_value());
-    if (it != ngrams_.end()) {
-        ngrams_.erase(it);
-        return true;
-    }
-    return false;
+bool NgramCountModel::contains_hash(uint64_t ngram_hash) const {
+    return local_model().contains_hash(ngram_hash);
 }
 
 size_t NgramCountModel::size() const {
-    return ngrams_.size();
+    return model_.size();
+}
+
+bool NgramCountModel::is_compact() const {
+    return model_.get_layout() != FrozenModelLayout::HASH_TABLE;
+}
+
+double NgramCountModel::false_positive_rate() const {
+    return model_.false_positive_rate();
+}
+
+size_t NgramCountModel::memory_usage_bytes() const {
+    if (replicas_.empty()) {
+        return sizeof(NgramCountModel) - sizeof(FrozenModel) + model_.memory_usage_bytes();
+    }
+    return std::accumulate(replicas_.begin(), replicas_.end(), sizeof(NgramCountModel) - sizeof(FrozenModel),
+                           [](size_t total, const FrozenModel& replica) { return total + replica.memory_usage_bytes(); });
+}
+
+size_t NgramCountModel::replica_count() const {
+    return replicas_.empty() ? 1 : replicas_.size();
+}
+
+const FrozenModel& NgramCountModel::frozen_model() const {
+    return model_;
 }
 
-} // namespace lingua
\ No newline at end of file
+} // namespace lingua
@@ -0,0 +1,375 @@
+#include "lingua/model_builder.h"
+#include "lingua/hash.h"
+#include "lingua/ngram_hasher.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace lingua {
+
+namespace {
+    // Keeps the hash index at most 70% full
+    uint64_t slot_count_for(size_t ngram_count) {
+        return std::bit_ceil(static_cast<uint64_t>(ngram_count) * 10 / 7 + 1);
+    }
+
+    constexpr uint64_t align_to_8(uint64_t offset) {
+        return (offset + 7) & ~uint64_t{7};
+    }
+
+    // Allocates a zeroed, 8-byte aligned block and places sections in it one after another
+    class BlockWriter {
+    public:
+        BlockWriter(const std::vector<uint64_t>& section_sizes, PagePolicy pages) {
+            uint64_t offset = align_to_8(sizeof(FrozenModelHeader));
+            for (size_t i = 0; i < section_sizes.size(); ++i) {
+                sections_[i] = {offset, section_sizes[i]};
+                offset = align_to_8(offset + section_sizes[i]);
+            }
+            storage_ = ModelMemory::allocate(offset, pages);
+        }
+
+        FrozenModelHeader& header() {
+            return *reinterpret_cast<FrozenModelHeader*>(storage_->bytes().data());
+        }
+
+        template <typename T>
+        T* section(size_t index) {
+            return reinterpret_cast<T*>(storage_->bytes().data() + sections_[index].offset);
+        }
+
+        FrozenModel finish(Language language, size_t ngram_length, ModelKind kind, FrozenModelLayout layout) {
+            FrozenModelHeader& block_header = header();
+            std::memcpy(block_header.magic, FrozenModelHeader::MAGIC, sizeof(block_header.magic));
+            block_header.byte_order = FrozenModelHeader::BYTE_ORDER_MARK;
+            block_header.format_version = FrozenModelHeader::FORMAT_VERSION;
+            block_header.total_size = storage_->bytes().size();
+            const std::string iso_code = iso_code_639_1(language);
+            std::memcpy(block_header.iso_code, iso_code.data(), std::min(iso_code.size(), sizeof(block_header.iso_code)));
+            block_header.ngram_length = static_cast<uint8_t>(ngram_length);
+            block_header.kind = static_cast<uint8_t>(kind);
+            block_header.layout = static_cast<uint8_t>(layout);
+            std::copy(std::begin(sections_), std::end(sections_), std::begin(block_header.sections));
+
+            const std::span<const std::byte> bytes = storage_->bytes();
+            return FrozenModel::from_bytes(bytes, std::move(storage_));
+        }
+
+    private:
+        FrozenModelSection sections_[FrozenModelHeader::SECTION_COUNT] = {};
+        std::shared_ptr<ModelMemory> storage_;
+    };
+}
+
+ModelBuilder::ModelBuilder(Language language, size_t ngram_length, ModelKind kind)
+    : language_(language), ngram_length_(ngram_length), kind_(kind) {
+    if (ngram_length < 1 || ngram_length > 5) {
+        throw std::invalid_argument("n-gram length must be between 1 and 5");
+    }
+}
+
+Language ModelBuilder::get_language() const {
+    return language_;
+}
+
+ModelKind ModelBuilder::get_kind() const {
+    return kind_;
+}
+
+void ModelBuilder::set_probability(std::string_view ngram, double probability) {
+    if (kind_ != ModelKind::PROBABILITY) {
+        throw std::logic_error("Cannot set probabilities in a " + to_string(kind_) + " n-gram set");
+    }
+    const auto [it, inserted] = ngrams_.try_emplace(store(ngram), probability);
+    if (!inserted) {
+        unstore(ngram);
+        it->second = probability;
+    }
+}
+
+void ModelBuilder::add_ngram(std::string_view ngram) {
+    if (kind_ == ModelKind::PROBABILITY) {
+        throw std::logic_error("Cannot add n-grams without probability to a probability model");
+    }
+    if (!ngrams_.try_emplace(store(ngram), 0.0).second) {
+        unstore(ngram);
+    }
+}
+
+bool ModelBuilder::remove_ngram(std::string_view ngram) {
+    return ngrams_.erase(ngram) > 0;
+}
+
+bool ModelBuilder::contains(std::string_view ngram) const {
+    return ngrams_.find(ngram) != ngrams_.end();
+}
+
+size_t ModelBuilder::size() const {
+    return ngrams_.size();
+}
+
+void ModelBuilder::reserve(size_t ngram_count) {
+    ngrams_.reserve(ngram_count);
+}
+
+FrozenModel ModelBuilder::freeze(PagePolicy pages) const {
+    return freeze_sorted(sorted_entries(), language_, ngram_length_, kind_, pages);
+}
+
+FrozenModel ModelBuilder::freeze(std::span<const ModelBuilder> parts, ThreadPool* pool, PagePolicy pages) {
+    if (parts.empty()) {
+        throw std::invalid_argument("Cannot freeze an empty list of model builders");
+    }
+    const ModelBuilder& first = parts.front();
+    for (const ModelBuilder& part : parts) {
+        if (part.language_ != first.language_ || part.ngram_length_ != first.ngram_length_ || part.kind_ != first.kind_) {
+            throw std::invalid_argument("Cannot freeze model builders of different models together");
+        }
+    }
+
+    std::vector<std::vector<Entry>> sorted_parts(parts.size());
+    const auto sort_part = [&](size_t i) { sorted_parts[i] = parts[i].sorted_entries(); };
+    if (pool != nullptr) {
+        pool->parallel_for(parts.size(), sort_part);
+    } else {
+        for (size_t i = 0; i < parts.size(); ++i) {
+            sort_part(i);
+        }
+    }
+
+    // Concatenate in part order, then merge neighbouring runs pairwise; the stable
+    // merge keeps equal n-grams in part order, so the last of each run wins below
+    size_t entry_count = 0;
+    for (const auto& part : sorted_parts) {
+        entry_count += part.size();
+    }
+    std::vector<Entry> entries;
+    entries.reserve(entry_count);
+    std::vector<size_t> run_starts;
+    for (auto& part : sorted_parts) {
+        run_starts.push_back(entries.size());
+        entries.insert(entries.end(), part.begin(), part.end());
+        std::vector<Entry>().swap(part);
+    }
+    run_starts.push_back(entries.size());
+
+    const auto by_ngram = [](const Entry& a, const Entry& b) { return a.first < b.first; };
+    while (run_starts.size() > 2) {
+        std::vector<size_t> merged_starts;
+        for (size_t i = 0; i + 1 < run_starts.size(); i += 2) {
+            merged_starts.push_back(run_starts[i]);
+            if (i + 2 < run_starts.size()) {
+                std::inplace_merge(entries.begin() + run_starts[i], entries.begin() + run_starts[i + 1],
+                                   entries.begin() + run_starts[i + 2], by_ngram);
+            }
+        }
+        merged_starts.push_back(run_starts.back());
+        run_starts = std::move(merged_starts);
+    }
+
+    size_t kept = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        if (i + 1 < entries.size() && entries[i + 1].first == entries[i].first) {
+            continue;
+        }
+        entries[kept++] = entries[i];
+    }
+    entries.resize(kept);
+    return freeze_sorted(entries, first.language_, first.ngram_length_, first.kind_, pages);
+}
+
+FrozenModel ModelBuilder::freeze_hashed(PagePolicy pages) const {
+    return freeze_hashed_entries(sorted_entries(), language_, ngram_length_, kind_, pages);
+}
+
+FrozenModel ModelBuilder::freeze_hashed(const FrozenModel& model, PagePolicy pages) {
+    if (model.get_layout() != FrozenModelLayout::HASH_TABLE) {
+        throw std::invalid_argument("Only hash table models can be frozen as hashed n-grams");
+    }
+    std::vector<Entry> entries;
+    entries.reserve(model.size());
+    for (size_t index = 0; index < model.size(); ++index) {
+        entries.emplace_back(model.ngram_at(index), model.probability_at(index));
+    }
+    return freeze_hashed_entries(entries, model.get_language(), model.get_ngram_length(), model.get_kind(), pages);
+}
+
+std::vector<ModelBuilder::Entry> ModelBuilder::sorted_entries() const {
+    std::vector<Entry> entries(ngrams_.begin(), ngrams_.end());
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.first < b.first; });
+    return entries;
+}
+
+FrozenModel ModelBuilder::freeze_sorted(
+    const std::vector<Entry>& entries, Language language, size_t ngram_length, ModelKind kind, PagePolicy pages) {
+    const bool has_values = kind == ModelKind::PROBABILITY;
+    std::vector<double> values;
+    if (has_values) {
+        values.reserve(entries.size());
+        for (const auto& entry : entries) {
+            values.push_back(entry.second);
+        }
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+    const uint8_t value_index_width = !has_values ? 0 : values.size() <= 65536 ? 2 : 4;
+
+    uint64_t key_byte_count = 0;
+    for (const auto& entry : entries) {
+        key_byte_count += entry.first.size();
+    }
+    if (key_byte_count > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Model keys exceed the 4 GiB frozen model limit");
+    }
+
+    const uint64_t slot_count = slot_count_for(entries.size());
+    BlockWriter writer({
+        slot_count * sizeof(uint64_t),
+        (entries.size() + 1) * sizeof(uint32_t),
+        key_byte_count,
+        entries.size() * value_index_width,
+        values.size() * sizeof(double)
+    }, pages);
+
+    auto* slots = writer.section<uint64_t>(0);
+    auto* key_offsets = writer.section<uint32_t>(1);
+    auto* key_bytes = writer.section<char>(2);
+    auto* value_indices = writer.section<std::byte>(3);
+    auto* value_table = writer.section<double>(4);
+
+    std::copy(values.begin(), values.end(), value_table);
+    uint32_t key_offset = 0;
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& [ngram, probability] = entries[i];
+        key_offsets[i] = key_offset;
+        std::memcpy(key_bytes + key_offset, ngram.data(), ngram.size());
+        key_offset += static_cast<uint32_t>(ngram.size());
+
+        if (has_values) {
+            const auto value_index = static_cast<uint32_t>(
+                std::lower_bound(values.begin(), values.end(), probability) - values.begin());
+            if (value_index_width == 2) {
+                const auto narrow_index = static_cast<uint16_t>(value_index);
+                std::memcpy(value_indices + i * 2, &narrow_index, sizeof(narrow_index));
+            } else {
+                std::memcpy(value_indices + i * 4, &value_index, sizeof(value_index));
+            }
+        }
+
+        const uint64_t hash = hash_bytes(ngram);
+        uint64_t slot = hash & (slot_count - 1);
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slots[slot] = (hash >> 32 << 32) | (i + 1);
+    }
+    key_offsets[entries.size()] = key_offset;
+
+    FrozenModelHeader& header = writer.header();
+    header.value_index_width = value_index_width;
+    header.ngram_count = entries.size();
+    header.slot_count = slot_count;
+    header.value_count = values.size();
+    return writer.finish(language, ngram_length, kind, FrozenModelLayout::HASH_TABLE);
+}
+
+FrozenModel ModelBuilder::freeze_hashed_entries(
+    const std::vector<Entry>& entries, Language language, size_t ngram_length, ModelKind kind, PagePolicy pages) {
+    const bool has_values = kind == ModelKind::PROBABILITY;
+    std::vector<double> values;
+    if (has_values) {
+        values.reserve(entries.size());
+        for (const auto& entry : entries) {
+            values.push_back(entry.second);
+        }
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+    const uint8_t value_index_width = !has_values ? 0 : values.size() <= 65536 ? 2 : 4;
+
+    const uint64_t slot_count = slot_count_for(entries.size());
+    BlockWriter writer({slot_count * sizeof(uint16_t), 0, 0, slot_count * value_index_width, values.size() * sizeof(double)},
+                       pages);
+    auto* slot_fingerprints = writer.section<uint16_t>(0);
+    auto* value_indices = writer.section<std::byte>(3);
+    std::copy(values.begin(), values.end(), writer.section<double>(4));
+
+    for (const auto& [ngram, probability] : entries) {
+        const auto ngram_hash = NgramHasher::hash_of_utf8(ngram);
+        if (!ngram_hash) {
+            throw std::invalid_argument("Cannot hash an n-gram that is not valid UTF-8");
+        }
+        uint64_t slot = *ngram_hash & (slot_count - 1);
+        while (slot_fingerprints[slot] != 0) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slot_fingerprints[slot] = FrozenModel::hash_fingerprint(*ngram_hash);
+
+        if (has_values) {
+            const auto value_index = static_cast<uint32_t>(
+                std::lower_bound(values.begin(), values.end(), probability) - values.begin());
+            if (value_index_width == 2) {
+                const auto narrow_index = static_cast<uint16_t>(value_index);
+                std::memcpy(value_indices + slot * 2, &narrow_index, sizeof(narrow_index));
+            } else {
+                std::memcpy(value_indices + slot * 4, &value_index, sizeof(value_index));
+            }
+        }
+    }
+
+    FrozenModelHeader& header = writer.header();
+    header.value_index_width = value_index_width;
+    header.fingerprint_bits = 16;
+    header.ngram_count = entries.size();
+    header.slot_count = slot_count;
+    header.value_count = values.size();
+    return writer.finish(language, ngram_length, kind, FrozenModelLayout::HASHED_NGRAMS);
+}
+
+FrozenModel ModelBuilder::freeze_fingerprints(unsigned fingerprint_bits, PagePolicy pages) const {
+    if (kind_ == ModelKind::PROBABILITY) {
+        throw std::logic_error("Cannot store probabilities as fingerprints");
+    }
+
+    std::vector<std::string_view> ngrams;
+    ngrams.reserve(ngrams_.size());
+    for (const auto& entry : ngrams_) {
+        ngrams.push_back(entry.first);
+    }
+    const FingerprintSet set(ngrams, fingerprint_bits);
+
+    BlockWriter writer({set.lower_bits().size_bytes(), set.upper_bits().size_bytes(), set.zero_samples().size_bytes(), 0, 0},
+                       pages);
+    std::copy(set.lower_bits().begin(), set.lower_bits().end(), writer.section<uint64_t>(0));
+    std::copy(set.upper_bits().begin(), set.upper_bits().end(), writer.section<uint64_t>(1));
+    std::copy(set.zero_samples().begin(), set.zero_samples().end(), writer.section<uint64_t>(2));
+
+    FrozenModelHeader& header = writer.header();
+    header.fingerprint_bits = set.fingerprint_bits();
+    header.lower_bit_count = set.lower_bit_count();
+    header.ngram_count = set.size();
+    header.slot_count = set.bucket_count();
+    return writer.finish(language_, ngram_length_, kind_, FrozenModelLayout::FINGERPRINTS);
+}
+
+std::string_view ModelBuilder::store(std::string_view ngram) {
+    if (arena_.empty() || arena_.back().capacity() - arena_.back().size() < ngram.size()) {
+        arena_.emplace_back();
+        arena_.back().reserve(std::max(ARENA_CHUNK_SIZE, ngram.size()));
+    }
+    std::string& chunk = arena_.back();
+    const size_t offset = chunk.size();
+    chunk.append(ngram);
+    return {chunk.data() + offset, ngram.size()};
+}
+
+void ModelBuilder::unstore(std::string_view ngram) {
+    arena_.back().resize(arena_.back().size() - ngram.size());
+}
+
+} // namespace lingua
@@ -0,0 +1,313 @@
+#include "lingua/model_bundle.h"
+#include "lingua/exception.h"
+#include "lingua/hash.h"
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#else
+#include <mutex>
+#endif
+
+namespace lingua {
+
+namespace {
+    uint64_t key_of(Language language, size_t ngram_length, ModelKind kind) {
+        return static_cast<uint64_t>(language) << 16 | static_cast<uint64_t>(ngram_length) << 8 | static_cast<uint64_t>(kind);
+    }
+
+    std::string iso_code_of(const ModelBundleEntry& entry) {
+        return std::string(entry.iso_code, strnlen(entry.iso_code, sizeof(entry.iso_code)));
+    }
+
+    std::string describe(const ModelBundleEntry& entry) {
+        return iso_code_of(entry) + " " + std::to_string(entry.ngram_length) + "-gram "
+            + to_string(static_cast<ModelKind>(entry.kind));
+    }
+
+    constexpr uint64_t align_to_8(uint64_t offset) {
+        return (offset + 7) & ~uint64_t{7};
+    }
+}
+
+#ifndef _WIN32
+
+struct ModelBundle::File {
+    int fd = -1;
+
+    ~File() {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+};
+
+#else
+
+struct ModelBundle::File {
+    std::ifstream stream;
+    std::mutex mutex;
+};
+
+#endif
+
+ModelBundle::ModelBundle() = default;
+
+ModelBundle::~ModelBundle() = default;
+
+std::shared_ptr<const ModelBundle> ModelBundle::open(
+    const std::string& bundle_path,
+    ModelBundleAccess access,
+    const MappingOptions& options
+) {
+    std::shared_ptr<ModelBundle> bundle(new ModelBundle());
+    bundle->path_ = bundle_path;
+    bundle->access_ = access;
+    bundle->pages_ = options.pages;
+    if (access == ModelBundleAccess::MEMORY_MAP) {
+        bundle->mapping_ = MappedFile::open(bundle_path, options);
+        bundle->size_ = bundle->mapping_->bytes().size();
+    } else {
+        bundle->file_ = std::make_unique<File>();
+#ifndef _WIN32
+        bundle->file_->fd = ::open(bundle_path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat status {};
+        if (bundle->file_->fd < 0 || ::fstat(bundle->file_->fd, &status) != 0) {
+            throw ModelLoadException("Cannot open model bundle: " + bundle_path + ": " + std::strerror(errno));
+        }
+        bundle->size_ = static_cast<uint64_t>(status.st_size);
+#else
+        bundle->file_->stream.open(bundle_path, std::ios::binary | std::ios::ate);
+        if (!bundle->file_->stream.is_open()) {
+            throw ModelLoadException("Cannot open model bundle: " + bundle_path);
+        }
+        bundle->size_ = static_cast<uint64_t>(bundle->file_->stream.tellg());
+#endif
+    }
+
+    ModelBundleHeader header {};
+    if (bundle->size_ < sizeof(header)) {
+        throw ModelLoadException("Model bundle is too small: " + bundle_path);
+    }
+    bundle->read_at(0, &header, sizeof(header));
+    if (std::memcmp(header.magic, ModelBundleHeader::MAGIC, sizeof(header.magic)) != 0) {
+        throw ModelLoadException("Model bundle has no valid magic number: " + bundle_path);
+    }
+    if (header.byte_order != ModelBundleHeader::BYTE_ORDER_MARK) {
+        throw ModelLoadException("Model bundle was written with a different byte order: " + bundle_path);
+    }
+    if (header.format_version != ModelBundleHeader::FORMAT_VERSION) {
+        throw ModelLoadException("Unsupported model bundle format version " + std::to_string(header.format_version)
+            + ": " + bundle_path);
+    }
+    if (header.total_size != bundle->size_) {
+        throw ModelLoadException("Model bundle is truncated: " + bundle_path);
+    }
+    if (header.index_offset < sizeof(header) || header.index_offset > header.total_size
+        || header.entry_count > (header.total_size - header.index_offset) / sizeof(ModelBundleEntry)) {
+        throw ModelLoadException("Model bundle has an index out of bounds: " + bundle_path);
+    }
+
+    bundle->entries_.resize(header.entry_count);
+    bundle->read_at(header.index_offset, bundle->entries_.data(), header.entry_count * sizeof(ModelBundleEntry));
+    for (size_t i = 0; i < bundle->entries_.size(); ++i) {
+        const ModelBundleEntry& entry = bundle->entries_[i];
+        if (entry.offset % 8 != 0 || entry.offset < sizeof(header) || entry.offset > header.index_offset
+            || entry.size > header.index_offset - entry.offset) {
+            throw ModelLoadException("Model bundle has a model out of bounds: " + bundle_path);
+        }
+        if (entry.ngram_length < 1 || entry.ngram_length > 5 || entry.kind > static_cast<uint8_t>(ModelKind::MOST_COMMON)) {
+            throw ModelLoadException("Model bundle has an invalid n-gram length or kind: " + bundle_path);
+        }
+        Language language;
+        try {
+            language = from_iso_code_639_1(iso_code_of(entry));
+        } catch (const std::exception&) {
+            throw ModelLoadException("Model bundle has an unknown language: " + bundle_path);
+        }
+        if (!bundle->entry_by_key_.emplace(key_of(language, entry.ngram_length, static_cast<ModelKind>(entry.kind)), i).second) {
+            throw ModelLoadException("Model bundle holds the " + describe(entry) + " model twice: " + bundle_path);
+        }
+    }
+    return bundle;
+}
+
+std::span<const ModelBundleEntry> ModelBundle::entries() const {
+    return entries_;
+}
+
+const ModelBundleEntry* ModelBundle::find(Language language, size_t ngram_length, ModelKind kind) const {
+    const auto it = entry_by_key_.find(key_of(language, ngram_length, kind));
+    return it == entry_by_key_.end() ? nullptr : &entries_[it->second];
+}
+
+FrozenModel ModelBundle::load(const ModelBundleEntry& entry, bool verify_checksum) const {
+    std::span<const std::byte> bytes;
+    std::shared_ptr<const void> owner;
+    if (mapping_) {
+        bytes = mapping_->bytes().subspan(entry.offset, entry.size);
+        owner = mapping_;
+    } else {
+        auto storage = ModelMemory::allocate(entry.size, pages_);
+        read_at(entry.offset, storage->bytes().data(), entry.size);
+        bytes = storage->bytes();
+        owner = std::move(storage);
+    }
+
+    if (verify_checksum && checksum(bytes) != entry.checksum) {
+        throw ModelLoadException("Model bundle has a corrupt " + describe(entry) + " model: " + path_);
+    }
+    FrozenModel model = FrozenModel::from_bytes(bytes, std::move(owner));
+    if (model.get_ngram_length() != entry.ngram_length || model.get_kind() != static_cast<ModelKind>(entry.kind)
+        || iso_code_639_1(model.get_language()) != iso_code_of(entry)) {
+        throw ModelLoadException("Model bundle has a " + describe(entry) + " model that does not match its index: " + path_);
+    }
+    return model;
+}
+
+ModelBundleAccess ModelBundle::access() const {
+    return access_;
+}
+
+const std::string& ModelBundle::path() const {
+    return path_;
+}
+
+uint64_t ModelBundle::checksum(std::span<const std::byte> bytes) {
+    // One multiply per 8-byte word, finished like the n-gram hash
+    constexpr uint64_t MULTIPLIER = 0x9e3779b97f4a7c15ULL;
+    uint64_t hash = MULTIPLIER ^ bytes.size();
+    const size_t word_count = bytes.size() / 8;
+    for (size_t i = 0; i < word_count; ++i) {
+        uint64_t word;
+        std::memcpy(&word, bytes.data() + i * 8, sizeof(word));
+        hash = std::rotl((hash ^ word) * MULTIPLIER, 29);
+    }
+    if (bytes.size() % 8 != 0) {
+        uint64_t word = 0;
+        std::memcpy(&word, bytes.data() + word_count * 8, bytes.size() % 8);
+        hash = std::rotl((hash ^ word) * MULTIPLIER, 29);
+    }
+    return mix_hash(hash);
+}
+
+void ModelBundle::read_at(uint64_t offset, void* destination, size_t size) const {
+    if (mapping_) {
+        std::memcpy(destination, mapping_->bytes().data() + offset, size);
+        return;
+    }
+#ifndef _WIN32
+    auto* output = static_cast<char*>(destination);
+    while (size > 0) {
+        const ssize_t count = ::pread(file_->fd, output, size, static_cast<off_t>(offset));
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            throw ModelLoadException("Cannot read model bundle: " + path_
+                + (count < 0 ? ": " + std::string(std::strerror(errno)) : ": unexpected end of file"));
+        }
+        output += count;
+        offset += static_cast<uint64_t>(count);
+        size -= static_cast<size_t>(count);
+    }
+#else
+    std::lock_guard<std::mutex> lock(file_->mutex);
+    file_->stream.seekg(static_cast<std::streamoff>(offset));
+    if (!file_->stream.read(static_cast<char*>(destination), static_cast<std::streamsize>(size))) {
+        throw ModelLoadException("Cannot read model bundle: " + path_);
+    }
+#endif
+}
+
+// ModelBundleWriter implementation
+
+ModelBundleWriter::ModelBundleWriter(const std::string& bundle_path)
+    : bundle_path_(bundle_path),
+      temporary_path_(bundle_path + ".tmp"),
+      file_(temporary_path_, std::ios::binary | std::ios::trunc) {
+    if (!file_.is_open()) {
+        throw ModelLoadException("Cannot create model bundle: " + temporary_path_);
+    }
+    // The header is rewritten by finish()
+    const ModelBundleHeader header {};
+    write(&header, sizeof(header));
+}
+
+ModelBundleWriter::~ModelBundleWriter() {
+    if (!finished_) {
+        file_.close();
+        std::remove(temporary_path_.c_str());
+    }
+}
+
+void ModelBundleWriter::add(const FrozenModel& model) {
+    const std::string iso_code = iso_code_639_1(model.get_language());
+    const bool duplicate = std::any_of(entries_.begin(), entries_.end(), [&](const ModelBundleEntry& entry) {
+        return entry.ngram_length == model.get_ngram_length() && entry.kind == static_cast<uint8_t>(model.get_kind())
+            && iso_code_of(entry) == iso_code;
+    });
+    if (duplicate) {
+        throw std::invalid_argument("The bundle already holds the " + iso_code + " "
+            + std::to_string(model.get_ngram_length()) + "-gram " + to_string(model.get_kind()) + " model");
+    }
+
+    ModelBundleEntry entry {};
+    std::memcpy(entry.iso_code, iso_code.data(), std::min(iso_code.size(), sizeof(entry.iso_code)));
+    entry.ngram_length = static_cast<uint8_t>(model.get_ngram_length());
+    entry.kind = static_cast<uint8_t>(model.get_kind());
+    entry.offset = offset_;
+    entry.size = model.bytes().size();
+    entry.checksum = ModelBundle::checksum(model.bytes());
+
+    write(model.bytes().data(), model.bytes().size());
+    const uint64_t padding[1] = {};
+    write(padding, align_to_8(offset_) - offset_);
+    entries_.push_back(entry);
+}
+
+size_t ModelBundleWriter::size() const {
+    return entries_.size();
+}
+
+uint64_t ModelBundleWriter::finish() {
+    ModelBundleHeader header {};
+    std::memcpy(header.magic, ModelBundleHeader::MAGIC, sizeof(header.magic));
+    header.byte_order = ModelBundleHeader::BYTE_ORDER_MARK;
+    header.format_version = ModelBundleHeader::FORMAT_VERSION;
+    header.entry_count = entries_.size();
+    header.index_offset = offset_;
+    write(entries_.data(), entries_.size() * sizeof(ModelBundleEntry));
+    header.total_size = offset_;
+
+    file_.seekp(0);
+    if (!file_.write(reinterpret_cast<const char*>(&header), sizeof(header)) || !file_.flush()) {
+        throw ModelLoadException("Cannot write model bundle: " + temporary_path_);
+    }
+    file_.close();
+    std::error_code error;
+    std::filesystem::rename(temporary_path_, bundle_path_, error);
+    if (error) {
+        throw ModelLoadException("Cannot move model bundle into place: " + bundle_path_ + ": " + error.message());
+    }
+    finished_ = true;
+    return header.total_size;
+}
+
+void ModelBundleWriter::write(const void* data, size_t size) {
+    if (size > 0 && !file_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size))) {
+        throw ModelLoadException("Cannot write model bundle: " + temporary_path_);
+    }
+    offset_ += size;
+}
+
+} // namespace lingua
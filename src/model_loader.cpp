@@ -1,18 +1,175 @@
 #include "lingua/model_loader.h"
+#include "lingua/embedded_models.h"
+#include "lingua/exception.h"
+#include "lingua/hash.h"
 #include <brotli/decode.h>
 #include <simdjson.h>
+#include <spdlog/spdlog.h>
+#include <bit>
+#include <charconv>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <mutex>
+#include <optional>
+#include <utility>
 #include <stdexcept>
 #include <algorithm>
 #include <format>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 namespace lingua {
+    namespace {
+        // Compressed bytes read per decoder call
+        constexpr size_t DECODE_INPUT_CHUNK_SIZE = 64 * 1024;
+
+        // Initial guess of the decoded size; the model files compress 3-6x
+        constexpr size_t DECODE_INITIAL_RATIO = 8;
+
+        // Readable bytes simdjson needs after the end of a document
+        constexpr size_t JSON_PADDING = simdjson::SIMDJSON_PADDING;
+
+        // Growable buffer whose contents are never zero-initialized
+        struct DecodeBuffer {
+            std::unique_ptr<char[]> data;
+            size_t capacity = 0;
+            size_t size = 0;
+
+            void reserve(size_t new_capacity) {
+                if (new_capacity <= capacity) {
+                    return;
+                }
+                new_capacity = std::max(new_capacity, capacity * 2);
+                auto grown = std::make_unique_for_overwrite<char[]>(new_capacity);
+                std::copy_n(data.get(), size, grown.get());
+                data = std::move(grown);
+                capacity = new_capacity;
+            }
+        };
+
+        // Calls emit for each non-empty run of bytes between spaces, scanning 16 bytes at a time
+        template <typename Emit>
+        void for_each_space_separated(std::string_view text, Emit&& emit) {
+            const char* const begin = text.data();
+            const char* const end = begin + text.size();
+            const char* word = begin;
+            const char* position = begin;
+            const auto emit_until = [&](const char* space) {
+                if (space != word) {
+                    emit(std::string_view(word, static_cast<size_t>(space - word)));
+                }
+                word = space + 1;
+            };
+#if defined(__SSE2__) || defined(_M_X64)
+            const __m128i spaces = _mm_set1_epi8(' ');
+            for (; end - position >= 16; position += 16) {
+                const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+                auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, spaces)));
+                while (mask != 0) {
+                    emit_until(position + std::countr_zero(mask));
+                    mask &= mask - 1;
+                }
+            }
+#endif
+            for (; position != end; ++position) {
+                if (*position == ' ') {
+                    emit_until(position);
+                }
+            }
+            emit_until(end);
+        }
+
+        // Parses "numerator/denominator"; nullopt if the key is not a fraction
+        std::optional<double> parse_fraction(std::string_view key) {
+            const size_t slash = key.find('/');
+            if (slash == std::string_view::npos) {
+                return std::nullopt;
+            }
+            uint32_t numerator = 0;
+            uint32_t denominator = 0;
+            const char* const numerator_end = key.data() + slash;
+            const char* const denominator_end = key.data() + key.size();
+            const auto [numerator_stop, numerator_error] = std::from_chars(key.data(), numerator_end, numerator);
+            const auto [denominator_stop, denominator_error] = std::from_chars(numerator_end + 1, denominator_end, denominator);
+            if (numerator_error != std::errc() || numerator_stop != numerator_end ||
+                denominator_error != std::errc() || denominator_stop != denominator_end || denominator == 0) {
+                throw ModelLoadException("Malformed n-gram probability: " + std::string(key));
+            }
+            return static_cast<double>(numerator) / static_cast<double>(denominator);
+        }
+
+        // Smallest share of a model's JSON worth parsing on its own thread
+        constexpr size_t PARALLEL_PARSE_MIN_PART_SIZE = 256 * 1024;
+
+        // The on-demand parser keeps its buffers between models loaded on the same thread
+        simdjson::ondemand::document iterate_json(std::string_view json_content) {
+            thread_local simdjson::ondemand::parser parser;
+            return parser.iterate(simdjson::padded_string_view(
+                json_content.data(), json_content.size(), json_content.size() + JSON_PADDING));
+        }
+    }
+
+    void ModelMemoryReport::add(ModelMemoryUsage usage) {
+        total_bytes += usage.bytes;
+        bytes_by_language[usage.language] += usage.bytes;
+        bytes_by_ngram_length[usage.ngram_length] += usage.bytes;
+        bytes_by_model_type[usage.model_type] += usage.bytes;
+        models.push_back(std::move(usage));
+    }
+
+    std::string to_string(ModelSource source) {
+        switch (source) {
+            case ModelSource::EMBEDDED:
+                return "embedded";
+            case ModelSource::BUNDLE:
+                return "bundle";
+            case ModelSource::BINARY_FILE:
+                return "binary";
+            case ModelSource::JSON_FILE:
+                return "json";
+        }
+        return "unknown";
+    }
+
+    void ModelLoadStats::add(ModelLoadRecord record) {
+        ++load_count;
+        read_time += record.read_time;
+        decompress_time += record.decompress_time;
+        parse_time += record.parse_time;
+        freeze_time += record.freeze_time;
+        total_time += record.total_time;
+        file_bytes += record.file_bytes;
+        decompressed_bytes += record.decompressed_bytes;
+        ngram_count += record.ngram_count;
+        memory_bytes += record.memory_bytes;
+        if (loads.size() == MAX_RECORDS) {
+            loads.erase(loads.begin());
+        }
+        loads.push_back(std::move(record));
+    }
+
     ModelLoader &ModelLoader::get_instance() {
         static ModelLoader instance;
         return instance;
     }
 
+    template <typename Model>
+    std::shared_ptr<const Model> ModelLoader::load_and_record(Language language, size_t ngram_length, ModelKind kind) {
+        ModelLoadRecord record{language, ngram_length, kind, ModelSource::JSON_FILE};
+        const auto start = std::chrono::steady_clock::now();
+        FrozenModel frozen = load_frozen_model(language, ngram_length, kind, record);
+        std::shared_ptr<const NumaTopology> topology;
+        std::vector<FrozenModel> replicas = replicate_for_numa(frozen, topology);
+        auto model = replicas.empty() ? std::make_shared<const Model>(std::move(frozen))
+                                      : std::make_shared<const Model>(std::move(replicas), std::move(topology));
+        record.total_time = std::chrono::steady_clock::now() - start;
+        record.ngram_count = model->size();
+        record.memory_bytes = model->memory_usage_bytes();
+        record_load(record);
+        return model;
+    }
+
     std::shared_ptr<const NgramProbabilityModel> ModelLoader::load_probability_model(
         Language language,
         size_t ngram_length
@@ -21,179 +178,966 @@ namespace lingua {
             throw std::invalid_argument("n-gram length must be between 1 and 5");
         }
 
-        const std::string cache_key = generate_cache_key(language, ngram_length, "probability");
+        const size_t slot = model_slot(language, ngram_length, ModelKind::PROBABILITY);
+        auto model = probability_models_.get_or_load(slot, [&] {
+            return load_and_record<NgramProbabilityModel>(language, ngram_length, ModelKind::PROBABILITY);
+        });
+        const size_t budget = memory_budget_.load(std::memory_order_relaxed);
+        if (budget != 0 && probability_models_.resident_bytes() + count_models_.resident_bytes() > budget) {
+            enforce_memory_budget(ModelKind::PROBABILITY, slot);
+        }
+        return model;
+    }
+
+    std::shared_ptr<const NgramCountModel> ModelLoader::load_count_model(
+        Language language,
+        size_t ngram_length,
+        NgramModelType model_type
+    ) {
+        if (ngram_length < 1 || ngram_length > 5) {
+            throw std::invalid_argument("n-gram length must be between 1 and 5");
+        }
 
-        // Try to get from cache first
-        {
-            std::shared_lock<std::shared_mutex> lock(cache_mutex_);
-            auto it = probability_model_cache_.find(cache_key);
-            if (it != probability_model_cache_.end()) {
-                return it->second;
-            }
+        const ModelKind kind = model_kind_of(model_type);
+        const size_t slot = model_slot(language, ngram_length, kind);
+        auto model = count_models_.get_or_load(slot, [&] {
+            return load_and_record<NgramCountModel>(language, ngram_length, kind);
+        });
+        const size_t budget = memory_budget_.load(std::memory_order_relaxed);
+        if (budget != 0 && probability_models_.resident_bytes() + count_models_.resident_bytes() > budget) {
+            enforce_memory_budget(kind, slot);
         }
+        return model;
+    }
 
-        // Load model if not in cache
-        const std::string ngram_name = Ngram::get_ngram_name_by_length(ngram_length);
-        const std::string file_name = ngram_name + "s.json.br";
-        // const std::string file_path = "models/" + iso_code_639_1(language) + "/" + file_name;
-        const std::string file_path = std::format("models/{}/models/{}", iso_code_639_1(language), file_name);
+    std::string ModelLoader::model_file_path(
+        Language language,
+        size_t ngram_length,
+        ModelKind kind,
+        const std::string &extension
+    ) {
+        const std::string ngram_name = std::string(Ngram::get_ngram_name_by_length(ngram_length)) + "s";
+        std::string file_name;
+        switch (kind) {
+            case ModelKind::PROBABILITY:
+                file_name = ngram_name;
+                break;
+            case ModelKind::UNIQUE:
+                file_name = "unique_" + ngram_name;
+                break;
+            case ModelKind::MOST_COMMON:
+                file_name = "mostcommon_" + ngram_name;
+                break;
+        }
+        return std::format("models/{}/models/{}{}", iso_code_639_1(language), file_name, extension);
+    }
 
-        const std::string json_content = load_and_decompress_model(file_path);
-        auto model = parse_probability_model(json_content, language);
+    ModelBuilder ModelLoader::parse_model(Language language, size_t ngram_length, ModelKind kind) const {
+        if (ngram_length < 1 || ngram_length > 5) {
+            throw std::invalid_argument("n-gram length must be between 1 and 5");
+        }
 
-        // Store in cache
-        {
-            std::unique_lock<std::shared_mutex> lock(cache_mutex_);
-            probability_model_cache_[cache_key] = model;
+        const std::string file_path = resolve_model_path(model_file_path(language, ngram_length, kind, JSON_MODEL_EXTENSION));
+        const std::string_view json_content = load_and_decompress_model(file_path);
+        try {
+            return parse_json_model(json_content, language, ngram_length, kind);
+        } catch (const simdjson::simdjson_error& e) {
+            throw ModelLoadException("Malformed model file: " + file_path + ": " + e.what());
         }
+    }
 
-        return model;
+    FrozenModel ModelLoader::compile_model(Language language, size_t ngram_length, ModelKind kind) const {
+        return compile_model(language, ngram_length, kind, nullptr);
     }
 
-    std::shared_ptr<const NgramCountModel> ModelLoader::load_count_model(
+    FrozenModel ModelLoader::compile_model(
         Language language,
         size_t ngram_length,
-        NgramModelType model_type
-    ) {
+        ModelKind kind,
+        ModelLoadRecord *record
+    ) const {
         if (ngram_length < 1 || ngram_length > 5) {
             throw std::invalid_argument("n-gram length must be between 1 and 5");
         }
 
-        const std::string model_type_str = to_string(model_type);
-        const std::string cache_key = generate_cache_key(language, ngram_length, model_type_str);
+        const std::string file_path = resolve_model_path(model_file_path(language, ngram_length, kind, JSON_MODEL_EXTENSION));
+        const std::string_view json_content = load_and_decompress_model(file_path, record);
+        try {
+            if (kind == ModelKind::PROBABILITY) {
+                const size_t part_count = std::min(get_thread_count(), json_content.size() / PARALLEL_PARSE_MIN_PART_SIZE);
+                if (part_count > 1) {
+                    return parse_probability_model_in_parallel(json_content, language, ngram_length, part_count, record);
+                }
+            }
 
-        // Try to get from cache first
-        {
-            std::shared_lock<std::shared_mutex> lock(cache_mutex_);
-            auto it = count_model_cache_.find(cache_key);
-            if (it != count_model_cache_.end()) {
-                return it->second;
+            const auto parse_start = std::chrono::steady_clock::now();
+            const ModelBuilder builder = parse_json_model(json_content, language, ngram_length, kind);
+            const auto freeze_start = std::chrono::steady_clock::now();
+            const double false_positive_rate = count_model_false_positive_rate_.load();
+            const PagePolicy pages = get_page_policy();
+            FrozenModel model = kind != ModelKind::PROBABILITY && false_positive_rate > 0.0
+                ? builder.freeze_fingerprints(FingerprintSet::fingerprint_bits_for(builder.size(), false_positive_rate), pages)
+                : builder.freeze(pages);
+            if (record) {
+                record->parse_time += freeze_start - parse_start;
+                record->freeze_time += std::chrono::steady_clock::now() - freeze_start;
             }
+            return model;
+        } catch (const simdjson::simdjson_error& e) {
+            throw ModelLoadException("Malformed model file: " + file_path + ": " + e.what());
         }
+    }
+
+    void ModelLoader::set_count_model_false_positive_rate(double rate) {
+        if (!(rate >= 0.0 && rate < 1.0)) {
+            throw std::invalid_argument("false-positive rate must lie in between 0.0 and 1.0");
+        }
+        count_model_false_positive_rate_.store(rate);
+    }
+
+    double ModelLoader::get_count_model_false_positive_rate() const {
+        return count_model_false_positive_rate_.load();
+    }
+
+    ModelPreloadReport ModelLoader::preload_models(
+        const std::unordered_set<Language> &languages,
+        const std::vector<size_t> &ngram_lengths,
+        const ModelPreloadCallback &on_progress
+    ) {
+        return prefetch(languages, ngram_lengths,
+                        {ModelKind::PROBABILITY, ModelKind::UNIQUE, ModelKind::MOST_COMMON}, on_progress).get();
+    }
+
+    std::future<ModelPreloadReport> ModelLoader::prefetch(
+        const std::unordered_set<Language> &languages,
+        const std::vector<size_t> &ngram_lengths,
+        const std::vector<ModelKind> &kinds,
+        const ModelPreloadCallback &on_progress
+    ) {
+        const std::shared_ptr<const ModelBundle> bundle = get_model_bundle();
+        std::vector<ModelLoadTask> tasks;
+        size_t missing_count = 0;
+        for (Language language: languages) {
+            for (size_t ngram_length: ngram_lengths) {
+                if (ngram_length < 1 || ngram_length > 5) {
+                    throw std::invalid_argument("n-gram length must be between 1 and 5");
+                }
+                for (ModelKind kind: {ModelKind::PROBABILITY, ModelKind::UNIQUE, ModelKind::MOST_COMMON}) {
+                    if (std::find(kinds.begin(), kinds.end(), kind) == kinds.end()) {
+                        continue;
+                    }
+                    if (const EmbeddedModel* embedded = find_embedded_model(language, ngram_length, kind)) {
+                        tasks.push_back({language, ngram_length, kind, static_cast<uintmax_t>(embedded->end - embedded->begin)});
+                        continue;
+                    }
+                    if (const ModelBundleEntry* entry = bundle ? bundle->find(language, ngram_length, kind) : nullptr) {
+                        tasks.push_back({language, ngram_length, kind, entry->size});
+                        continue;
+                    }
+                    std::error_code error;
+                    uintmax_t file_size = std::filesystem::file_size(
+                        resolve_model_path(model_file_path(language, ngram_length, kind, BINARY_MODEL_EXTENSION)), error);
+                    if (error) {
+                        file_size = std::filesystem::file_size(
+                            resolve_model_path(model_file_path(language, ngram_length, kind, JSON_MODEL_EXTENSION)), error);
+                    }
+                    if (!error) {
+                        tasks.push_back({language, ngram_length, kind, file_size});
+                        continue;
+                    }
+                    ++missing_count;
+                    if (load_logging_enabled_.load(std::memory_order_relaxed)) {
+                        spdlog::warn("Skipped {} {}-gram {} model: not embedded, not in the bundle and no {} or JSON file",
+                                     to_string(language), ngram_length, to_string(kind),
+                                     resolve_model_path(model_file_path(language, ngram_length, kind, BINARY_MODEL_EXTENSION)));
+                    }
+                }
+            }
+        }
+        return run_load_tasks(std::move(tasks), on_progress, false, missing_count);
+    }
+
+    std::future<ModelPreloadReport> ModelLoader::reload_models(
+        const std::unordered_set<Language> &languages,
+        const ModelPreloadCallback &on_progress
+    ) {
+        std::vector<ModelLoadTask> tasks;
+        for (Language language: languages) {
+            for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+                for (ModelKind kind: {ModelKind::PROBABILITY, ModelKind::UNIQUE, ModelKind::MOST_COMMON}) {
+                    const size_t slot = model_slot(language, ngram_length, kind);
+                    size_t bytes = 0;
+                    if (kind == ModelKind::PROBABILITY) {
+                        if (const auto model = probability_models_.peek(slot)) {
+                            bytes = model->memory_usage_bytes();
+                        }
+                    } else if (const auto model = count_models_.peek(slot)) {
+                        bytes = model->memory_usage_bytes();
+                    }
+                    // Only cached models are reloaded
+                    if (bytes != 0) {
+                        tasks.push_back({language, ngram_length, kind, bytes});
+                    }
+                }
+            }
+        }
+        return run_load_tasks(std::move(tasks), on_progress, true);
+    }
+
+    std::future<ModelPreloadReport> ModelLoader::reload_models(const ModelPreloadCallback &on_progress) {
+        return reload_models(all_languages(), on_progress);
+    }
+
+    size_t ModelLoader::unload_models(const std::unordered_set<Language> &languages) {
+        size_t released_bytes = 0;
+        for (Language language: languages) {
+            for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+                for (ModelKind kind: {ModelKind::PROBABILITY, ModelKind::UNIQUE, ModelKind::MOST_COMMON}) {
+                    const size_t slot = model_slot(language, ngram_length, kind);
+                    released_bytes += kind == ModelKind::PROBABILITY
+                        ? probability_models_.remove(slot) : count_models_.remove(slot);
+                }
+            }
+        }
+        return released_bytes;
+    }
+
+    std::future<ModelPreloadReport> ModelLoader::run_load_tasks(
+        std::vector<ModelLoadTask> tasks,
+        const ModelPreloadCallback &on_progress,
+        bool reload,
+        size_t missing_count
+    ) {
+        // Shared by the tasks; the last one to finish fulfills the promise
+        struct LoadState {
+            std::vector<ModelLoadTask> tasks;
+            ModelPreloadCallback on_progress;
+            std::chrono::steady_clock::time_point start;
+            std::mutex mutex;
+            size_t remaining_count = 0;
+            ModelPreloadReport report;
+            std::exception_ptr first_error;
+            std::promise<ModelPreloadReport> promise;
+        };
+
+        // Largest first, so the longest loads overlap with the many small ones
+        std::sort(tasks.begin(), tasks.end(), [](const ModelLoadTask &a, const ModelLoadTask &b) {
+            return a.size > b.size;
+        });
+
+        const auto pool = thread_pool();
+        auto state = std::make_shared<LoadState>();
+        state->tasks = std::move(tasks);
+        state->on_progress = on_progress;
+        state->start = std::chrono::steady_clock::now();
+        state->remaining_count = state->tasks.size();
+        state->report.thread_count = pool->thread_count();
+        state->report.missing_count = missing_count;
+        std::future<ModelPreloadReport> result = state->promise.get_future();
+        if (state->tasks.empty()) {
+            state->promise.set_value(state->report);
+            return result;
+        }
+
+        for (size_t i = 0; i < state->tasks.size(); ++i) {
+            pool->submit([this, state, i, reload] {
+                const ModelLoadTask &task = state->tasks[i];
+                const auto task_start = std::chrono::steady_clock::now();
+                size_t bytes = 0;
+                std::exception_ptr error;
+                try {
+                    bytes = reload
+                        ? reload_model(task.language, task.ngram_length, task.kind)
+                        : load_model(task.language, task.ngram_length, task.kind);
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                const auto load_time = std::chrono::steady_clock::now() - task_start;
 
-        // Load model if not in cache
-        const std::string ngram_name = Ngram::get_ngram_name_by_length(ngram_length);
-        const std::string file_name = model_type_str + "_" + ngram_name + "s.json.br";
-        // const std::string file_path = "models/" + iso_code_639_1(language) + "/" + file_name;
-        const std::string file_path = std::format("models/{}/models/{}", iso_code_639_1(language), file_name);
+                std::lock_guard<std::mutex> lock(state->mutex);
+                if (error) {
+                    if (!state->first_error) {
+                        state->first_error = error;
+                    }
+                } else {
+                    ModelPreloadReport &report = state->report;
+                    ++report.model_count;
+                    report.bytes += bytes;
+                    report.load_time += load_time;
+                    if (state->on_progress) {
+                        try {
+                            state->on_progress({report.model_count, state->tasks.size(), task.language,
+                                                task.ngram_length, task.kind, load_time});
+                        } catch (...) {
+                            if (!state->first_error) {
+                                state->first_error = std::current_exception();
+                            }
+                        }
+                    }
+                }
+                if (--state->remaining_count == 0) {
+                    state->report.wall_time = std::chrono::steady_clock::now() - state->start;
+                    if (state->first_error) {
+                        state->promise.set_exception(state->first_error);
+                    } else {
+                        state->promise.set_value(state->report);
+                    }
+                }
+            });
+        }
+        return result;
+    }
+
+    size_t ModelLoader::load_model(Language language, size_t ngram_length, ModelKind kind) {
+        // Models being loaded by another thread are waited for instead of loaded again
+        if (kind == ModelKind::PROBABILITY) {
+            return load_probability_model(language, ngram_length)->memory_usage_bytes();
+        }
+        const NgramModelType model_type = kind == ModelKind::UNIQUE ? NgramModelType::UNIQUE : NgramModelType::MOST_COMMON;
+        return load_count_model(language, ngram_length, model_type)->memory_usage_bytes();
+    }
 
-        const std::string json_content = load_and_decompress_model(file_path);
-        auto model = parse_count_model(json_content, language, model_type);
+    size_t ModelLoader::reload_model(Language language, size_t ngram_length, ModelKind kind) {
+        const size_t slot = model_slot(language, ngram_length, kind);
+        size_t bytes;
+        if (kind == ModelKind::PROBABILITY) {
+            auto model = load_and_record<NgramProbabilityModel>(language, ngram_length, kind);
+            bytes = model->memory_usage_bytes();
+            probability_models_.replace(slot, std::move(model));
+        } else {
+            auto model = load_and_record<NgramCountModel>(language, ngram_length, kind);
+            bytes = model->memory_usage_bytes();
+            count_models_.replace(slot, std::move(model));
+        }
+        const size_t budget = memory_budget_.load(std::memory_order_relaxed);
+        if (budget != 0 && probability_models_.resident_bytes() + count_models_.resident_bytes() > budget) {
+            enforce_memory_budget(kind, slot);
+        }
+        return bytes;
+    }
 
-        // Store in cache
+    void ModelLoader::set_thread_count(size_t thread_count) {
+        auto pool = std::make_shared<ThreadPool>(thread_count);
         {
-            std::unique_lock<std::shared_mutex> lock(cache_mutex_);
-            count_model_cache_[cache_key] = model;
+            std::lock_guard<std::mutex> lock(pool_mutex_);
+            thread_count_ = thread_count;
+            pool_.swap(pool);
         }
+        // The previous pool, if no longer in use, drains and joins here, outside the lock
+    }
 
-        return model;
+    size_t ModelLoader::get_thread_count() const {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        return thread_count_;
     }
 
-    void ModelLoader::clear_cache() {
-        std::unique_lock<std::shared_mutex> lock(cache_mutex_);
-        probability_model_cache_.clear();
-        count_model_cache_.clear();
+    std::shared_ptr<ThreadPool> ModelLoader::thread_pool() const {
+        std::lock_guard<std::mutex> lock(pool_mutex_);
+        if (!pool_) {
+            pool_ = std::make_shared<ThreadPool>(thread_count_);
+        }
+        return pool_;
     }
 
-    std::string ModelLoader::generate_cache_key(Language language, size_t ngram_length,
-                                                const std::string &model_type) const {
-        return to_string(language) + "_" + std::to_string(ngram_length) + "_" + model_type;
+    void ModelLoader::set_model_root(const std::string &model_root) {
+        std::unique_lock<std::shared_mutex> lock(settings_mutex_);
+        model_root_ = model_root;
     }
 
-    std::string ModelLoader::load_and_decompress_model(const std::string &file_path) const {
-        // Read compressed file
-        std::ifstream file(file_path, std::ios::binary);
-        if (!file.is_open()) {
-            throw std::runtime_error("Cannot open model file: " + file_path);
+    std::string ModelLoader::get_model_root() const {
+        std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+        return model_root_;
+    }
+
+    std::string ModelLoader::resolve_model_path(const std::string &relative_path) const {
+        const std::string model_root = get_model_root();
+        if (model_root.empty()) {
+            return relative_path;
         }
+        return (std::filesystem::path(model_root) / relative_path).string();
+    }
 
-        std::ostringstream buffer;
-        buffer << file.rdbuf();
-        std::string compressed_data = buffer.str();
-        file.close();
+    void ModelLoader::set_model_bundle(const std::string &bundle_path, ModelBundleAccess access, bool verify_checksums) {
+        std::shared_ptr<const ModelBundle> bundle;
+        if (!bundle_path.empty()) {
+            MappingOptions options;
+            {
+                std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+                options = mapping_options_;
+            }
+            bundle = ModelBundle::open(resolve_model_path(bundle_path), access, options);
+        }
+        std::unique_lock<std::shared_mutex> lock(settings_mutex_);
+        bundle_ = std::move(bundle);
+        verify_bundle_checksums_ = verify_checksums;
+        shared_store_.reset();
+    }
 
-        // Decompress using brotli
-        size_t decoded_size = compressed_data.size() * 10; // Initial estimate
-        std::string decompressed_data(decoded_size, 0);
+    std::shared_ptr<const SharedModelStore> ModelLoader::set_shared_model_store(
+        const std::unordered_set<Language> &languages,
+        const std::string &directory
+    ) {
+        struct StoredModel {
+            Language language;
+            size_t ngram_length;
+            ModelKind kind;
+        };
 
-        BrotliDecoderResult result = BrotliDecoderDecompress(
-            compressed_data.size(),
-            reinterpret_cast<const uint8_t *>(compressed_data.data()),
-            &decoded_size,
-            reinterpret_cast<uint8_t *>(&decompressed_data[0])
-        );
+        std::vector<Language> sorted_languages(languages.begin(), languages.end());
+        std::sort(sorted_languages.begin(), sorted_languages.end());
+        const double false_positive_rate = count_model_false_positive_rate_.load();
+        const std::string model_root = get_model_root();
+        std::error_code error;
+        const std::filesystem::path absolute_root = std::filesystem::absolute(model_root.empty() ? "." : model_root, error);
 
-        if (result != BROTLI_DECODER_RESULT_SUCCESS) {
-            throw std::runtime_error("Failed to decompress model file: " + file_path);
+        // The version covers everything the frozen models depend on, so changing a
+        // model file or a setting publishes a new store instead of reusing a stale one
+        std::string signature = std::format("lingua shared model store {} {}\n{}\n{}\n",
+            ModelBundleHeader::FORMAT_VERSION, FrozenModelHeader::FORMAT_VERSION, absolute_root.string(),
+            std::bit_cast<uint64_t>(false_positive_rate));
+        std::vector<StoredModel> models;
+        for (Language language: sorted_languages) {
+            for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+                for (ModelKind kind: {ModelKind::PROBABILITY, ModelKind::UNIQUE, ModelKind::MOST_COMMON}) {
+                    // Embedded models are shared through the executable's pages already
+                    if (find_embedded_model(language, ngram_length, kind)) {
+                        continue;
+                    }
+                    bool has_file = false;
+                    for (const char *extension: {BINARY_MODEL_EXTENSION, JSON_MODEL_EXTENSION}) {
+                        const std::string path = resolve_model_path(model_file_path(language, ngram_length, kind, extension));
+                        const uintmax_t file_size = std::filesystem::file_size(path, error);
+                        if (error) {
+                            continue;
+                        }
+                        const auto write_time = std::filesystem::last_write_time(path, error);
+                        signature += std::format("{} {} {}\n", path, file_size,
+                                                 static_cast<int64_t>(write_time.time_since_epoch().count()));
+                        has_file = true;
+                    }
+                    if (has_file) {
+                        models.push_back({language, ngram_length, kind});
+                    }
+                }
+            }
         }
+        const std::string file_name = std::format("{}{:016x}.lfb", SHARED_MODEL_STORE_PREFIX, hash_bytes(signature));
+
+        MappingOptions options;
+        {
+            std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+            options = mapping_options_;
+        }
+        auto store = SharedModelStore::open(directory, file_name, [&](ModelBundleWriter &writer) {
+            for (const StoredModel &model: models) {
+                ModelLoadRecord record{model.language, model.ngram_length, model.kind, ModelSource::JSON_FILE};
+                writer.add(load_frozen_model(model.language, model.ngram_length, model.kind, record));
+            }
+        }, options);
+        // Earlier versions that no process maps anymore
+        SharedModelStore::remove_unused(directory, SHARED_MODEL_STORE_PREFIX);
+
+        std::unique_lock<std::shared_mutex> lock(settings_mutex_);
+        bundle_ = store->bundle();
+        verify_bundle_checksums_ = true;
+        shared_store_ = store;
+        return store;
+    }
+
+    std::shared_ptr<const SharedModelStore> ModelLoader::get_shared_model_store() const {
+        std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+        return shared_store_;
+    }
 
-        decompressed_data.resize(decoded_size);
-        return decompressed_data;
+    std::shared_ptr<const ModelBundle> ModelLoader::get_model_bundle() const {
+        std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+        return bundle_;
     }
 
-    std::shared_ptr<const NgramProbabilityModel> ModelLoader::parse_probability_model(
-        const std::string &json_content,
-        Language language
+    void ModelLoader::set_memory_mapping(bool enabled, MappingOptions options) {
+        std::unique_lock<std::shared_mutex> lock(settings_mutex_);
+        memory_mapping_enabled_ = enabled;
+        mapping_options_ = options;
+    }
+
+    bool ModelLoader::is_memory_mapping_enabled() const {
+        std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+        return memory_mapping_enabled_;
+    }
+
+    void ModelLoader::set_page_policy(PagePolicy pages) {
+        std::unique_lock<std::shared_mutex> lock(settings_mutex_);
+        mapping_options_.pages = pages;
+    }
+
+    PagePolicy ModelLoader::get_page_policy() const {
+        std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+        return mapping_options_.pages;
+    }
+
+    void ModelLoader::set_numa_replication(size_t replica_budget, std::shared_ptr<const NumaTopology> topology) {
+        if (!topology) {
+            topology = NumaTopology::system();
+        }
+        std::unique_lock<std::shared_mutex> lock(settings_mutex_);
+        numa_replica_budget_ = replica_budget;
+        numa_topology_ = std::move(topology);
+    }
+
+    size_t ModelLoader::get_numa_replication_budget() const {
+        std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+        return numa_replica_budget_;
+    }
+
+    size_t ModelLoader::numa_replica_bytes() const {
+        return numa_replica_bytes_->load(std::memory_order_relaxed);
+    }
+
+    std::vector<FrozenModel> ModelLoader::replicate_for_numa(
+        const FrozenModel& model,
+        std::shared_ptr<const NumaTopology>& topology
     ) const {
-        using namespace simdjson;
+        size_t budget = 0;
+        PagePolicy pages = PagePolicy::DEFAULT;
+        {
+            std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+            budget = numa_replica_budget_;
+            topology = numa_topology_;
+            pages = mapping_options_.pages;
+        }
+        if (budget == 0 || !topology || topology->node_count() < 2) {
+            return {};
+        }
 
-        dom::parser parser;
-        dom::object root_object = parser.parse(json_content).get<dom::object>();
+        // Reserve the extra replicas' bytes, or keep the single copy if they do not fit
+        const size_t extra_bytes = (topology->node_count() - 1) * model.bytes().size();
+        auto replica_bytes = numa_replica_bytes_;
+        size_t used = replica_bytes->load(std::memory_order_relaxed);
+        do {
+            if (used + extra_bytes > budget) {
+                return {};
+            }
+        } while (!replica_bytes->compare_exchange_weak(used, used + extra_bytes, std::memory_order_relaxed));
 
-        auto model = std::make_shared<NgramProbabilityModel>(language);
+        std::vector<FrozenModel> replicas;
+        try {
+            replicas = replicate_model(model, *topology, pages);
+        } catch (...) {
+            replica_bytes->fetch_sub(extra_bytes, std::memory_order_relaxed);
+            throw;
+        }
+        // The replicas share one owner that returns the reservation when the last of them is freed
+        auto owner = std::shared_ptr<std::vector<FrozenModel>>(
+            new std::vector<FrozenModel>(std::move(replicas)),
+            [replica_bytes, extra_bytes](std::vector<FrozenModel>* owned) {
+                replica_bytes->fetch_sub(extra_bytes, std::memory_order_relaxed);
+                delete owned;
+            }
+        );
+        std::vector<FrozenModel> owned_replicas;
+        owned_replicas.reserve(owner->size());
+        for (const FrozenModel& replica : *owner) {
+            owned_replicas.push_back(FrozenModel::from_bytes(replica.bytes(), owner));
+        }
+        return owned_replicas;
+    }
 
-        // Parse n-grams
-        dom::object ngrams_object = root_object["ngrams"].get<dom::object>();
-        for (auto field: ngrams_object) {
-            std::string fraction_str(field.key);
-            std::string_view ngrams_view = field.value.get<std::string_view>();
+    ModelMemoryReport ModelLoader::memory_report() const {
+        return memory_report(all_languages());
+    }
 
-            // Parse fraction (e.g., "1/2")
-            size_t slash_pos = fraction_str.find('/');
-            if (slash_pos == std::string::npos) {
-                continue;
+    ModelMemoryReport ModelLoader::memory_report(const std::unordered_set<Language> &languages) const {
+        std::vector<Language> sorted_languages(languages.begin(), languages.end());
+        std::sort(sorted_languages.begin(), sorted_languages.end());
+
+        ModelMemoryReport report;
+        for (Language language: sorted_languages) {
+            for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+                if (const auto model = probability_models_.peek(model_slot(language, ngram_length, ModelKind::PROBABILITY))) {
+                    report.add({language, ngram_length, "probability", model->size(), model->memory_usage_bytes()});
+                }
+
+                for (NgramModelType model_type: {NgramModelType::UNIQUE, NgramModelType::MOST_COMMON}) {
+                    if (const auto model = count_models_.peek(model_slot(language, ngram_length, model_kind_of(model_type)))) {
+                        report.add({language, ngram_length, to_string(model_type), model->size(), model->memory_usage_bytes()});
+                    }
+                }
             }
+        }
+        return report;
+    }
+
+    void ModelLoader::clear_cache() {
+        probability_models_.clear();
+        count_models_.clear();
+    }
+
+    void ModelLoader::set_memory_budget(size_t bytes) {
+        memory_budget_.store(bytes);
+        if (bytes != 0) {
+            // MODEL_SLOT_COUNT is no slot, so every unpinned model may go
+            enforce_memory_budget(ModelKind::PROBABILITY, MODEL_SLOT_COUNT);
+        }
+    }
+
+    size_t ModelLoader::get_memory_budget() const {
+        return memory_budget_.load();
+    }
 
-            uint32_t numerator = std::stoi(fraction_str.substr(0, slash_pos));
-            uint32_t denominator = std::stoi(fraction_str.substr(slash_pos + 1));
-            double probability = static_cast<double>(numerator) / static_cast<double>(denominator);
+    void ModelLoader::pin_model(Language language, size_t ngram_length, ModelKind kind) {
+        if (ngram_length < 1 || ngram_length > 5) {
+            throw std::invalid_argument("n-gram length must be between 1 and 5");
+        }
+        const size_t slot = model_slot(language, ngram_length, kind);
+        if (kind == ModelKind::PROBABILITY) {
+            probability_models_.pin(slot);
+        } else {
+            count_models_.pin(slot);
+        }
+    }
 
-            // Split n-grams by space
-            std::istringstream iss{std::string(ngrams_view)};
-            std::string ngram;
-            while (iss >> ngram) {
-                model->set_probability(Ngram(ngram), probability);
+    bool ModelLoader::unpin_model(Language language, size_t ngram_length, ModelKind kind) {
+        if (ngram_length < 1 || ngram_length > 5) {
+            throw std::invalid_argument("n-gram length must be between 1 and 5");
+        }
+        const size_t slot = model_slot(language, ngram_length, kind);
+        return kind == ModelKind::PROBABILITY ? probability_models_.unpin(slot) : count_models_.unpin(slot);
+    }
+
+    ModelCacheStats ModelLoader::cache_stats() const {
+        ModelCacheStats stats = probability_models_.stats();
+        const ModelCacheStats count_stats = count_models_.stats();
+        stats.model_count += count_stats.model_count;
+        stats.pinned_count += count_stats.pinned_count;
+        stats.resident_bytes += count_stats.resident_bytes;
+        stats.load_count += count_stats.load_count;
+        stats.reload_count += count_stats.reload_count;
+        stats.eviction_count += count_stats.eviction_count;
+        stats.replace_count += count_stats.replace_count;
+        stats.memory_budget = memory_budget_.load();
+        return stats;
+    }
+
+    void ModelLoader::enforce_memory_budget(ModelKind kept_kind, size_t kept_slot) {
+        std::lock_guard<std::mutex> lock(eviction_mutex_);
+        const size_t budget = memory_budget_.load();
+        size_t resident_bytes = probability_models_.resident_bytes() + count_models_.resident_bytes();
+        if (budget == 0 || resident_bytes <= budget) {
+            return;
+        }
+
+        struct Candidate {
+            EvictableModel model;
+            bool is_probability_model;
+        };
+        std::vector<Candidate> candidates;
+        std::vector<EvictableModel> models;
+        probability_models_.evictable_models(models);
+        for (const EvictableModel &model: models) {
+            if (kept_kind != ModelKind::PROBABILITY || model.slot != kept_slot) {
+                candidates.push_back({model, true});
+            }
+        }
+        models.clear();
+        count_models_.evictable_models(models);
+        for (const EvictableModel &model: models) {
+            if (kept_kind == ModelKind::PROBABILITY || model.slot != kept_slot) {
+                candidates.push_back({model, false});
             }
         }
 
-        return model;
+        // Least recently used first, and the largest of equally recent models
+        std::sort(candidates.begin(), candidates.end(), [](const Candidate &a, const Candidate &b) {
+            if (a.model.last_used != b.model.last_used) {
+                return a.model.last_used < b.model.last_used;
+            }
+            return a.model.bytes > b.model.bytes;
+        });
+        for (const Candidate &candidate: candidates) {
+            if (resident_bytes <= budget) {
+                break;
+            }
+            resident_bytes -= candidate.is_probability_model
+                ? probability_models_.evict(candidate.model.slot)
+                : count_models_.evict(candidate.model.slot);
+        }
     }
 
-    std::shared_ptr<const NgramCountModel> ModelLoader::parse_count_model(
-        const std::string &json_content,
+    size_t ModelLoader::model_slot(Language language, size_t ngram_length, ModelKind kind) {
+        return (static_cast<size_t>(language) * 5 + ngram_length - 1) * 3 + static_cast<size_t>(kind);
+    }
+
+    FrozenModel ModelLoader::load_frozen_model(
         Language language,
-        NgramModelType model_type
+        size_t ngram_length,
+        ModelKind kind,
+        ModelLoadRecord &record
     ) const {
-        using namespace simdjson;
+        // Models linked into the library need neither file I/O nor a copy
+        if (const EmbeddedModel* embedded = find_embedded_model(language, ngram_length, kind)) {
+            const auto read_start = std::chrono::steady_clock::now();
+            const size_t embedded_size = static_cast<size_t>(embedded->end - embedded->begin);
+            FrozenModel model = FrozenModel::from_bytes({embedded->begin, embedded_size}, nullptr);
+            record.read_time += std::chrono::steady_clock::now() - read_start;
+            if (model.get_language() == language && model.get_ngram_length() == ngram_length
+                && model.get_kind() == kind
+                && model.false_positive_rate() <= count_model_false_positive_rate_.load()) {
+                record.source = ModelSource::EMBEDDED;
+                record.file_bytes = embedded_size;
+                return model;
+            }
+        }
+
+        bool map_file;
+        MappingOptions options;
+        std::shared_ptr<const ModelBundle> bundle;
+        bool verify_checksums;
+        {
+            std::shared_lock<std::shared_mutex> lock(settings_mutex_);
+            map_file = memory_mapping_enabled_;
+            options = mapping_options_;
+            bundle = bundle_;
+            verify_checksums = verify_bundle_checksums_;
+        }
+
+        if (const ModelBundleEntry* entry = bundle ? bundle->find(language, ngram_length, kind) : nullptr) {
+            const auto read_start = std::chrono::steady_clock::now();
+            FrozenModel model = bundle->load(*entry, verify_checksums);
+            record.read_time += std::chrono::steady_clock::now() - read_start;
+            if (model.false_positive_rate() <= count_model_false_positive_rate_.load()) {
+                record.source = ModelSource::BUNDLE;
+                record.file_bytes = entry->size;
+                return model;
+            }
+        }
 
-        dom::parser parser;
-        dom::object root_object = parser.parse(json_content).get<dom::object>();
+        const std::string binary_path = resolve_model_path(model_file_path(language, ngram_length, kind, BINARY_MODEL_EXTENSION));
+        std::error_code error;
+        const uintmax_t binary_size = std::filesystem::file_size(binary_path, error);
+        // Binary models older than their JSON model, unreadable, of another format
+        // version or for another model fall back to the JSON model
+        std::error_code binary_time_error;
+        std::error_code json_time_error;
+        const auto binary_time = std::filesystem::last_write_time(binary_path, binary_time_error);
+        const auto json_time = std::filesystem::last_write_time(
+            resolve_model_path(model_file_path(language, ngram_length, kind, JSON_MODEL_EXTENSION)), json_time_error);
+        const bool stale = !binary_time_error && !json_time_error && json_time > binary_time;
+        if (!error && !stale) {
+            try {
+                const auto read_start = std::chrono::steady_clock::now();
+                FrozenModel model = map_file
+                    ? FrozenModel::map_from(binary_path, options)
+                    : FrozenModel::read_from(binary_path, options.pages);
+                record.read_time += std::chrono::steady_clock::now() - read_start;
+                if (model.get_language() == language && model.get_ngram_length() == ngram_length
+                    && model.get_kind() == kind
+                    && model.false_positive_rate() <= count_model_false_positive_rate_.load()) {
+                    record.source = ModelSource::BINARY_FILE;
+                    record.file_bytes = static_cast<size_t>(binary_size);
+                    return model;
+                }
+            } catch (const ModelLoadException&) {
+            }
+        }
+        record.source = ModelSource::JSON_FILE;
+        return compile_model(language, ngram_length, kind, &record);
+    }
 
-        auto model = std::make_shared<NgramCountModel>(language, model_type);
+    void ModelLoader::record_load(const ModelLoadRecord &record) {
+        {
+            std::lock_guard<std::mutex> lock(load_stats_mutex_);
+            load_stats_.add(record);
+        }
+        if (load_logging_enabled_.load(std::memory_order_relaxed)) {
+            using Milliseconds = std::chrono::duration<double, std::milli>;
+            spdlog::info("Loaded {} {}-gram {} model from {} in {:.1f} ms (read {:.1f} ms, decompress {:.1f} ms, "
+                         "parse {:.1f} ms, freeze {:.1f} ms): {} bytes stored, {} bytes of JSON, {} n-grams, {} bytes in memory",
+                         to_string(record.language), record.ngram_length, to_string(record.kind), to_string(record.source),
+                         Milliseconds(record.total_time).count(), Milliseconds(record.read_time).count(),
+                         Milliseconds(record.decompress_time).count(), Milliseconds(record.parse_time).count(),
+                         Milliseconds(record.freeze_time).count(), record.file_bytes, record.decompressed_bytes,
+                         record.ngram_count, record.memory_bytes);
+        }
+    }
 
-        // Parse n-grams
-        dom::array ngrams_object = root_object["ngrams"].get<dom::array>();
-        for (auto field: ngrams_object) {
-            std::string_view ngrams_view = field.get<std::string_view>();
+    ModelLoadStats ModelLoader::load_stats() const {
+        std::lock_guard<std::mutex> lock(load_stats_mutex_);
+        return load_stats_;
+    }
 
-            // Split n-grams by space
-            std::istringstream iss{std::string(ngrams_view)};
-            std::string ngram;
-            while (iss >> ngram) {
-                model->add_ngram(Ngram(ngram));
+    void ModelLoader::reset_load_stats() {
+        std::lock_guard<std::mutex> lock(load_stats_mutex_);
+        load_stats_ = {};
+    }
+
+    void ModelLoader::set_load_logging(bool enabled) {
+        load_logging_enabled_.store(enabled);
+    }
+
+    std::string_view ModelLoader::load_and_decompress_model(const std::string &file_path, ModelLoadRecord *record) const {
+        std::ifstream file(file_path, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            throw std::runtime_error("Cannot open model file: " + file_path);
+        }
+        const auto compressed_size = static_cast<size_t>(file.tellg());
+        file.seekg(0);
+
+        // Buffers are reused by every load on this thread, so their capacity
+        // settles at the largest model decoded so far
+        thread_local DecodeBuffer input;
+        thread_local DecodeBuffer output;
+        input.reserve(DECODE_INPUT_CHUNK_SIZE);
+        output.size = 0;
+        output.reserve(compressed_size * DECODE_INITIAL_RATIO + JSON_PADDING);
+
+        std::unique_ptr<BrotliDecoderState, decltype(&BrotliDecoderDestroyInstance)> decoder(
+            BrotliDecoderCreateInstance(nullptr, nullptr, nullptr), &BrotliDecoderDestroyInstance);
+        if (!decoder) {
+            throw std::bad_alloc();
+        }
+
+        size_t available_in = 0;
+        const uint8_t *next_in = nullptr;
+        std::chrono::nanoseconds read_time{0};
+        std::chrono::nanoseconds decompress_time{0};
+        BrotliDecoderResult result = BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT;
+        while (result != BROTLI_DECODER_RESULT_SUCCESS) {
+            const auto chunk_start = std::chrono::steady_clock::now();
+            if (result == BROTLI_DECODER_RESULT_NEEDS_MORE_INPUT) {
+                file.read(input.data.get(), static_cast<std::streamsize>(DECODE_INPUT_CHUNK_SIZE));
+                available_in = static_cast<size_t>(file.gcount());
+                next_in = reinterpret_cast<const uint8_t *>(input.data.get());
+                if (available_in == 0) {
+                    throw std::runtime_error("Truncated model file: " + file_path);
+                }
+            } else if (result == BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) {
+                output.reserve(output.capacity * 2);
+            } else {
+                throw std::runtime_error("Failed to decompress model file: " + file_path + ": "
+                                         + BrotliDecoderErrorString(BrotliDecoderGetErrorCode(decoder.get())));
             }
+
+            const auto decode_start = std::chrono::steady_clock::now();
+            read_time += decode_start - chunk_start;
+
+            size_t available_out = output.capacity - JSON_PADDING - output.size;
+            auto *next_out = reinterpret_cast<uint8_t *>(output.data.get() + output.size);
+            result = BrotliDecoderDecompressStream(
+                decoder.get(), &available_in, &next_in, &available_out, &next_out, nullptr);
+            output.size = reinterpret_cast<char *>(next_out) - output.data.get();
+            decompress_time += std::chrono::steady_clock::now() - decode_start;
+        }
+
+        if (record) {
+            record->read_time += read_time;
+            record->decompress_time += decompress_time;
+            record->file_bytes = compressed_size;
+            record->decompressed_bytes = output.size;
         }
 
+        return {output.data.get(), output.size};
+    }
+
+    ModelBuilder ModelLoader::parse_json_model(
+        std::string_view json_content,
+        Language language,
+        size_t ngram_length,
+        ModelKind kind
+    ) {
+        ModelBuilder builder(language, ngram_length, kind);
+        // Roughly one n-gram per ngram_length + 1 bytes of JSON
+        builder.reserve(json_content.size() / (ngram_length + 1));
+        if (kind == ModelKind::PROBABILITY) {
+            parse_probability_model(json_content, builder);
+        } else {
+            parse_count_model(json_content, builder);
+        }
+        return builder;
+    }
+
+    void ModelLoader::parse_probability_model(std::string_view json_content, ModelBuilder& builder) {
+        simdjson::ondemand::document document = iterate_json(json_content);
+        for (auto field : document["ngrams"].get_object()) {
+            const std::optional<double> probability = parse_fraction(field.unescaped_key());
+            const std::string_view ngrams = field.value().get_string();
+            if (!probability) {
+                continue;
+            }
+            for_each_space_separated(ngrams, [&](std::string_view ngram) {
+                builder.set_probability(ngram, *probability);
+            });
+        }
+    }
+
+    FrozenModel ModelLoader::parse_probability_model_in_parallel(
+        std::string_view json_content,
+        Language language,
+        size_t ngram_length,
+        size_t part_count,
+        ModelLoadRecord *record
+    ) const {
+        const auto parse_start = std::chrono::steady_clock::now();
+        // Finding the fraction groups is cheap; splitting and indexing their n-grams is not
+        struct FractionGroup {
+            double probability;
+            std::string_view ngrams;
+        };
+        std::vector<FractionGroup> groups;
+        size_t ngram_bytes = 0;
+        simdjson::ondemand::document document = iterate_json(json_content);
+        for (auto field : document["ngrams"].get_object()) {
+            const std::optional<double> probability = parse_fraction(field.unescaped_key());
+            const std::string_view ngrams = field.value().get_string();
+            if (probability) {
+                groups.push_back({*probability, ngrams});
+                ngram_bytes += ngrams.size();
+            }
+        }
+
+        // Contiguous runs of groups with about the same number of bytes each, in file
+        // order, so that a repeated n-gram keeps the probability of its last group
+        std::vector<size_t> part_starts{0};
+        size_t part_bytes = 0;
+        for (size_t i = 0; i < groups.size() && part_starts.size() < part_count; ++i) {
+            part_bytes += groups[i].ngrams.size();
+            if (part_bytes * part_count >= ngram_bytes * part_starts.size()) {
+                part_starts.push_back(i + 1);
+            }
+        }
+        part_starts.push_back(groups.size());
+
+        std::vector<ModelBuilder> parts;
+        parts.reserve(part_starts.size() - 1);
+        for (size_t i = 0; i + 1 < part_starts.size(); ++i) {
+            parts.emplace_back(language, ngram_length, ModelKind::PROBABILITY);
+        }
+
+        const auto pool = thread_pool();
+        pool->parallel_for(parts.size(), [&](size_t part) {
+            ModelBuilder& builder = parts[part];
+            builder.reserve(ngram_bytes / parts.size() / ngram_length);
+            for (size_t i = part_starts[part]; i < part_starts[part + 1]; ++i) {
+                for_each_space_separated(groups[i].ngrams, [&](std::string_view ngram) {
+                    builder.set_probability(ngram, groups[i].probability);
+                });
+            }
+        });
+
+        const auto freeze_start = std::chrono::steady_clock::now();
+        FrozenModel model = ModelBuilder::freeze(parts, pool.get(), get_page_policy());
+        if (record) {
+            record->parse_time += freeze_start - parse_start;
+            record->freeze_time += std::chrono::steady_clock::now() - freeze_start;
+        }
         return model;
     }
+
+    void ModelLoader::parse_count_model(std::string_view json_content, ModelBuilder& builder) {
+        simdjson::ondemand::document document = iterate_json(json_content);
+        for (auto element : document["ngrams"].get_array()) {
+            for_each_space_separated(element.get_string(), [&](std::string_view ngram) {
+                builder.add_ngram(ngram);
+            });
+        }
+    }
 } // namespace lingua
@@ -0,0 +1,99 @@
+#include "lingua/ngram_extractor.h"
+#include "lingua/unicode.h"
+#include <stdexcept>
+
+namespace lingua {
+
+namespace {
+    constexpr unsigned CODE_POINT_BITS = 21;
+    // Bit position of the last code point of a five-code-point n-gram, just above the count
+    constexpr unsigned LAST_SHIFT = 128 - CODE_POINT_BITS * Ngram::MAX_CHAR_COUNT;
+    // Code points decoded per chunk of the text
+    constexpr size_t DECODE_CHUNK = 256;
+
+    // The n-gram of the last `order` code points of a window holding the last five, last code point lowest
+    template <size_t order>
+    Ngram window_suffix(uint64_t high, uint64_t low) {
+        constexpr unsigned shift = CODE_POINT_BITS * (Ngram::MAX_CHAR_COUNT - order);
+        if constexpr (shift >= 64) {
+            high = low << (shift - 64);
+            low = 0;
+        } else if constexpr (shift > 0) {
+            high = (high << shift) | (low >> (64 - shift));
+            low <<= shift;
+        }
+        return Ngram::from_bits(high, low | order);
+    }
+}
+
+void NgramExtractor::extract(std::string_view text) {
+    // A text has at most one code point, and so one n-gram of each order, per byte
+    if (ngrams_[0].size() < text.size()) {
+        for (auto& ngrams : ngrams_) {
+            ngrams.resize(text.size());
+        }
+    }
+    std::array<Ngram*, Ngram::MAX_CHAR_COUNT> out {};
+    for (size_t order = 0; order < Ngram::MAX_CHAR_COUNT; ++order) {
+        out[order] = ngrams_[order].data();
+    }
+    word_count_ = 0;
+
+    // The last five code points of the current word packed like a five-code-point Ngram,
+    // without the count; code points before the word are zero
+    uint64_t high = 0;
+    uint64_t low = 0;
+    size_t word_length = 0;
+    std::array<char32_t, DECODE_CHUNK> code_points;
+    for (std::string_view rest = text; !rest.empty();) {
+        const Utf8DecodeResult decoded = decode_utf8(rest, code_points);
+        rest.remove_prefix(decoded.bytes_read);
+        for (size_t i = 0; i < decoded.code_points_written; ++i) {
+            const char32_t code_point = code_points[i];
+            if (code_point == REPLACEMENT_CHARACTER || is_word_separator(code_point)) {
+                word_length = 0;
+                high = 0;
+                low = 0;
+                continue;
+            }
+            if (word_length == 0) {
+                ++word_count_;
+            }
+            ++word_length;
+            // Slide the window by one code point; the oldest falls off the top
+            high = (high << CODE_POINT_BITS) | (low >> (64 - CODE_POINT_BITS));
+            low = (low << CODE_POINT_BITS) | (static_cast<uint64_t>(code_point) << LAST_SHIFT);
+
+            *out[0]++ = window_suffix<1>(high, low);
+            if (word_length >= 2) {
+                *out[1]++ = window_suffix<2>(high, low);
+            }
+            if (word_length >= 3) {
+                *out[2]++ = window_suffix<3>(high, low);
+            }
+            if (word_length >= 4) {
+                *out[3]++ = window_suffix<4>(high, low);
+            }
+            if (word_length >= 5) {
+                *out[4]++ = window_suffix<5>(high, low);
+            }
+        }
+    }
+
+    for (size_t order = 0; order < Ngram::MAX_CHAR_COUNT; ++order) {
+        counts_[order] = static_cast<size_t>(out[order] - ngrams_[order].data());
+    }
+}
+
+std::span<const Ngram> NgramExtractor::ngrams(size_t order) const {
+    if (order < 1 || order > Ngram::MAX_CHAR_COUNT) {
+        throw std::invalid_argument("n-gram length must be between 1 and 5");
+    }
+    return {ngrams_[order - 1].data(), counts_[order - 1]};
+}
+
+size_t NgramExtractor::word_count() const {
+    return word_count_;
+}
+
+} // namespace lingua
@@ -0,0 +1,100 @@
+#include "lingua/ngram_hasher.h"
+#include "lingua/hash.h"
+#include "lingua/ngram_extractor.h"
+#include "lingua/unicode.h"
+#include <stdexcept>
+
+namespace lingua {
+
+namespace {
+    // Code points decoded per chunk of the text
+    constexpr size_t DECODE_CHUNK = 256;
+}
+
+void NgramHasher::extract(std::string_view text) {
+    // A text has at most one code point, and so one n-gram of each order, per byte
+    if (hashes_[0].size() < text.size()) {
+        for (auto& hashes : hashes_) {
+            hashes.resize(text.size());
+        }
+    }
+    std::array<uint64_t*, Ngram::MAX_CHAR_COUNT> out {};
+    for (size_t order = 0; order < Ngram::MAX_CHAR_COUNT; ++order) {
+        out[order] = hashes_[order].data();
+    }
+    word_count_ = 0;
+
+    // The polynomial hashes of the n-grams of each order ending at the previous code point
+    std::array<uint64_t, Ngram::MAX_CHAR_COUNT> previous {};
+    size_t word_length = 0;
+    std::array<char32_t, DECODE_CHUNK> code_points;
+    for (std::string_view rest = text; !rest.empty();) {
+        const Utf8DecodeResult decoded = decode_utf8(rest, code_points);
+        rest.remove_prefix(decoded.bytes_read);
+        for (size_t i = 0; i < decoded.code_points_written; ++i) {
+            const char32_t code_point = code_points[i];
+            if (code_point == REPLACEMENT_CHARACTER || NgramExtractor::is_word_separator(code_point)) {
+                word_length = 0;
+                continue;
+            }
+            if (word_length == 0) {
+                ++word_count_;
+            }
+            ++word_length;
+            // The n-gram of each order ending here extends the one an order lower ending before
+            for (size_t order = Ngram::MAX_CHAR_COUNT - 1; order > 0; --order) {
+                previous[order] = extend_ngram_hash(previous[order - 1], code_point);
+            }
+            previous[0] = extend_ngram_hash(0, code_point);
+
+            const size_t orders = word_length < Ngram::MAX_CHAR_COUNT ? word_length : Ngram::MAX_CHAR_COUNT;
+            for (size_t order = 0; order < orders; ++order) {
+                *out[order]++ = finish_ngram_hash(previous[order]);
+            }
+        }
+    }
+
+    for (size_t order = 0; order < Ngram::MAX_CHAR_COUNT; ++order) {
+        counts_[order] = static_cast<size_t>(out[order] - hashes_[order].data());
+    }
+}
+
+std::span<const uint64_t> NgramHasher::hashes(size_t order) const {
+    if (order < 1 || order > Ngram::MAX_CHAR_COUNT) {
+        throw std::invalid_argument("n-gram length must be between 1 and 5");
+    }
+    return {hashes_[order - 1].data(), counts_[order - 1]};
+}
+
+size_t NgramHasher::word_count() const {
+    return word_count_;
+}
+
+uint64_t NgramHasher::hash_of(const Ngram& ngram) noexcept {
+    uint64_t hash = 0;
+    for (size_t i = 0; i < ngram.char_count(); ++i) {
+        hash = extend_ngram_hash(hash, ngram.code_point(i));
+    }
+    return finish_ngram_hash(hash);
+}
+
+std::optional<uint64_t> NgramHasher::hash_of_utf8(std::string_view ngram) noexcept {
+    if (ngram.empty()) {
+        return std::nullopt;
+    }
+    uint64_t hash = 0;
+    std::array<char32_t, Ngram::MAX_CHAR_COUNT> code_points;
+    for (std::string_view rest = ngram; !rest.empty();) {
+        const Utf8DecodeResult decoded = decode_utf8(rest, code_points);
+        if (decoded.invalid_sequences > 0) {
+            return std::nullopt;
+        }
+        for (size_t i = 0; i < decoded.code_points_written; ++i) {
+            hash = extend_ngram_hash(hash, code_points[i]);
+        }
+        rest.remove_prefix(decoded.bytes_read);
+    }
+    return finish_ngram_hash(hash);
+}
+
+} // namespace lingua
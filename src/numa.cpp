@@ -0,0 +1,148 @@
+#include "lingua/numa.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace lingua {
+
+NumaTopology::NumaTopology() : kernel_node_ids_{-1}, node_cpus_(1) {}
+
+NumaTopology NumaTopology::detect(const std::string& node_directory) {
+    std::vector<std::pair<int, std::vector<unsigned>>> nodes;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(node_directory, error)) {
+        const std::string name = entry.path().filename().string();
+        int id = 0;
+        const char* digits = name.data() + 4;
+        if (name.rfind("node", 0) != 0 || name.size() == 4
+            || std::from_chars(digits, name.data() + name.size(), id).ptr != name.data() + name.size()) {
+            continue;
+        }
+        std::ifstream file(entry.path() / "cpulist");
+        std::string list;
+        std::getline(file, list);
+        try {
+            std::vector<unsigned> cpus = parse_cpu_list(list);
+            // Memory-only nodes have no threads to serve
+            if (!cpus.empty()) {
+                nodes.emplace_back(id, std::move(cpus));
+            }
+        } catch (const std::invalid_argument&) {
+            continue;
+        }
+    }
+
+    NumaTopology topology;
+    if (nodes.empty()) {
+        return topology;
+    }
+    std::sort(nodes.begin(), nodes.end());
+    topology.kernel_node_ids_.clear();
+    topology.node_cpus_.clear();
+    for (auto& [id, cpus] : nodes) {
+        for (unsigned cpu : cpus) {
+            if (cpu >= topology.cpu_nodes_.size()) {
+                topology.cpu_nodes_.resize(cpu + 1, 0);
+            }
+            topology.cpu_nodes_[cpu] = static_cast<uint32_t>(topology.node_cpus_.size());
+        }
+        topology.kernel_node_ids_.push_back(id);
+        topology.node_cpus_.push_back(std::move(cpus));
+    }
+    return topology;
+}
+
+std::shared_ptr<const NumaTopology> NumaTopology::system() {
+#ifdef __linux__
+    static const auto topology = std::make_shared<const NumaTopology>(detect());
+#else
+    static const auto topology = std::make_shared<const NumaTopology>();
+#endif
+    return topology;
+}
+
+std::vector<unsigned> NumaTopology::parse_cpu_list(std::string_view list) {
+    while (!list.empty() && (list.back() == '\n' || list.back() == ' ')) {
+        list.remove_suffix(1);
+    }
+    std::vector<unsigned> cpus;
+    while (!list.empty()) {
+        const size_t comma = list.find(',');
+        const std::string_view range = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+        unsigned first = 0;
+        unsigned last = 0;
+        const char* end = range.data() + range.size();
+        std::from_chars_result parsed = std::from_chars(range.data(), end, first);
+        last = first;
+        if (parsed.ec == std::errc() && parsed.ptr != end && *parsed.ptr == '-') {
+            parsed = std::from_chars(parsed.ptr + 1, end, last);
+        }
+        if (parsed.ec != std::errc() || parsed.ptr != end || last < first) {
+            throw std::invalid_argument("Malformed CPU list: " + std::string(range));
+        }
+        for (unsigned cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+size_t NumaTopology::node_count() const {
+    return node_cpus_.size();
+}
+
+int NumaTopology::kernel_node_id(size_t node) const {
+    return kernel_node_ids_[node];
+}
+
+const std::vector<unsigned>& NumaTopology::node_cpus(size_t node) const {
+    return node_cpus_[node];
+}
+
+size_t NumaTopology::node_of_cpu(unsigned cpu) const {
+    return cpu < cpu_nodes_.size() ? cpu_nodes_[cpu] : 0;
+}
+
+size_t NumaTopology::current_node() const {
+    if (node_cpus_.size() == 1) {
+        return 0;
+    }
+#ifdef __linux__
+    thread_local unsigned calls = 0;
+    thread_local int cpu = -1;
+    if (cpu < 0 || ++calls == CPU_REFRESH_INTERVAL) {
+        calls = 0;
+        cpu = ::sched_getcpu();
+    }
+    return cpu < 0 ? 0 : node_of_cpu(static_cast<unsigned>(cpu));
+#else
+    return 0;
+#endif
+}
+
+std::vector<FrozenModel> replicate_model(const FrozenModel& model, const NumaTopology& topology, PagePolicy pages) {
+    const std::span<const std::byte> source = model.bytes();
+    std::vector<FrozenModel> replicas;
+    replicas.reserve(topology.node_count());
+    for (size_t node = 0; node < topology.node_count(); ++node) {
+        // The pages are bound to the node before the copy faults them in
+        auto memory = ModelMemory::allocate(source.size(), pages, topology.kernel_node_id(node));
+        std::memcpy(memory->bytes().data(), source.data(), source.size());
+        const std::span<const std::byte> bytes = memory->bytes();
+        replicas.push_back(FrozenModel::from_bytes(bytes, std::move(memory)));
+    }
+    return replicas;
+}
+
+} // namespace lingua
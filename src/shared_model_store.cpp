@@ -0,0 +1,179 @@
+#include "lingua/shared_model_store.h"
+#include "lingua/exception.h"
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lingua {
+
+namespace {
+#ifndef _WIN32
+    // Closes a descriptor, and so releases its lock, when it goes out of scope
+    struct LockedFile {
+        int fd = -1;
+
+        ~LockedFile() {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+
+        int release() {
+            const int released = fd;
+            fd = -1;
+            return released;
+        }
+    };
+
+    void lock(int fd, int operation, const std::string& path) {
+        while (::flock(fd, operation) != 0) {
+            if (errno != EINTR) {
+                throw ModelLoadException("Cannot lock shared model store: " + path + ": " + std::strerror(errno));
+            }
+        }
+    }
+
+    // Whether a descriptor still refers to the file at a path, rather than to one
+    // that remove_unused() unlinked after it was opened
+    bool is_linked(int fd, const std::string& path) {
+        struct stat opened;
+        struct stat linked;
+        return ::fstat(fd, &opened) == 0 && ::stat(path.c_str(), &linked) == 0
+               && opened.st_dev == linked.st_dev && opened.st_ino == linked.st_ino;
+    }
+
+    // Takes the exclusive build lock of a store, reopening the lock file if it was removed meanwhile
+    int lock_build(const std::string& lock_path) {
+        while (true) {
+            LockedFile builder{::open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)};
+            if (builder.fd < 0) {
+                throw ModelLoadException("Cannot create shared model store lock: " + lock_path + ": " + std::strerror(errno));
+            }
+            lock(builder.fd, LOCK_EX, lock_path);
+            if (is_linked(builder.fd, lock_path)) {
+                return builder.release();
+            }
+        }
+    }
+#endif
+}
+
+std::shared_ptr<const SharedModelStore> SharedModelStore::open(
+    const std::string& directory,
+    const std::string& file_name,
+    const Builder& build,
+    const MappingOptions& options
+) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        throw ModelLoadException("Cannot create shared model store directory: " + directory + ": " + error.message());
+    }
+
+    std::shared_ptr<SharedModelStore> store(new SharedModelStore());
+    store->path_ = (std::filesystem::path(directory) / file_name).string();
+
+#ifndef _WIN32
+    while (true) {
+        LockedFile reader{::open(store->path_.c_str(), O_RDONLY | O_CLOEXEC)};
+        if (reader.fd >= 0) {
+            // The reader reference; remove_unused() cannot take the exclusive lock while it is held
+            lock(reader.fd, LOCK_SH, store->path_);
+        } else {
+            // Only one process builds; the others wait here and then find the store published
+            const std::string lock_path = store->path_ + ".lock";
+            LockedFile builder{lock_build(lock_path)};
+            reader.fd = ::open(store->path_.c_str(), O_RDONLY | O_CLOEXEC);
+            if (reader.fd < 0) {
+                ModelBundleWriter writer(store->path_);
+                build(writer);
+                writer.finish();
+                store->was_built_ = true;
+                reader.fd = ::open(store->path_.c_str(), O_RDONLY | O_CLOEXEC);
+                if (reader.fd < 0) {
+                    throw ModelLoadException("Cannot open shared model store: " + store->path_ + ": " + std::strerror(errno));
+                }
+            }
+            // Taken before the build lock is released, which remove_unused() also needs
+            lock(reader.fd, LOCK_SH, store->path_);
+        }
+        // Between the open and the lock, remove_unused() may have deleted the file; then look again
+        if (is_linked(reader.fd, store->path_)) {
+            store->reader_lock_fd_ = reader.release();
+            break;
+        }
+        store->was_built_ = false;
+    }
+    store->bundle_ = ModelBundle::open(store->path_, ModelBundleAccess::MEMORY_MAP, options);
+#else
+    if (!std::filesystem::exists(store->path_)) {
+        ModelBundleWriter writer(store->path_);
+        build(writer);
+        writer.finish();
+        store->was_built_ = true;
+    }
+    store->bundle_ = ModelBundle::open(store->path_, ModelBundleAccess::MEMORY_MAP, options);
+#endif
+    return store;
+}
+
+size_t SharedModelStore::remove_unused(const std::string& directory, const std::string& file_name_prefix) {
+    size_t removed_count = 0;
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+        const std::string file_name = file.path().filename().string();
+        if (file_name.rfind(file_name_prefix, 0) != 0 || file.path().extension() != ".lfb") {
+            continue;
+        }
+        const std::string lock_path = file.path().string() + ".lock";
+#ifndef _WIN32
+        LockedFile candidate{::open(file.path().c_str(), O_RDONLY | O_CLOEXEC)};
+        if (candidate.fd < 0 || ::flock(candidate.fd, LOCK_EX | LOCK_NB) != 0
+            || !is_linked(candidate.fd, file.path().string())) {
+            continue;
+        }
+        // A process holding the build lock is about to read the store, so it stays
+        LockedFile builder{::open(lock_path.c_str(), O_RDWR | O_CLOEXEC)};
+        if (builder.fd >= 0 && ::flock(builder.fd, LOCK_EX | LOCK_NB) != 0) {
+            continue;
+        }
+#endif
+        std::error_code remove_error;
+        if (std::filesystem::remove(file.path(), remove_error)) {
+            ++removed_count;
+            // Builders waiting on the lock file notice it is gone and lock a new one
+            std::filesystem::remove(lock_path, remove_error);
+        }
+    }
+    return removed_count;
+}
+
+SharedModelStore::~SharedModelStore() {
+#ifndef _WIN32
+    if (reader_lock_fd_ >= 0) {
+        ::close(reader_lock_fd_);
+    }
+#endif
+}
+
+const std::shared_ptr<const ModelBundle>& SharedModelStore::bundle() const {
+    return bundle_;
+}
+
+const std::string& SharedModelStore::path() const {
+    return path_;
+}
+
+bool SharedModelStore::was_built() const {
+    return was_built_;
+}
+
+} // namespace lingua
@@ -0,0 +1,74 @@
+#include "lingua/text_normalizer.h"
+#include "lingua/ngram_extractor.h"
+#include "lingua/unicode.h"
+#include <array>
+
+namespace lingua {
+
+namespace {
+    // Code points decoded per chunk of the text
+    constexpr size_t DECODE_CHUNK = 256;
+}
+
+std::span<const std::string_view> TextNormalizer::normalize(std::string_view text) {
+    // Simple case folding grows a code point by at most one byte in two (U+023A to U+2C65),
+    // and a separator byte per word never outgrows the dropped whitespace, so the buffer
+    // never reallocates under the views into it
+    buffer_.clear();
+    buffer_.reserve(text.size() + text.size() / 2);
+    words_.clear();
+
+    size_t word_start = 0;
+    bool in_word = false;
+    const auto end_word = [&] {
+        if (in_word && buffer_.size() > word_start) {
+            words_.emplace_back(buffer_.data() + word_start, buffer_.size() - word_start);
+            in_word = false;
+        }
+    };
+
+    std::array<char32_t, DECODE_CHUNK> code_points;
+    for (std::string_view rest = text; !rest.empty();) {
+        const Utf8DecodeResult decoded = decode_utf8(rest, code_points);
+        rest.remove_prefix(decoded.bytes_read);
+        for (size_t i = 0; i < decoded.code_points_written; ++i) {
+            const char32_t code_point = code_points[i];
+            if (NgramExtractor::is_word_separator(code_point)) {
+                end_word();
+                continue;
+            }
+            if (!is_letter(code_point)) {
+                continue;
+            }
+            if (!in_word) {
+                if (!words_.empty()) {
+                    buffer_.push_back(' ');
+                }
+                word_start = buffer_.size();
+                in_word = true;
+            }
+            const char32_t folded = fold_case(code_point);
+            if (folded < 0x80) {
+                buffer_.push_back(static_cast<char>(folded));
+            } else {
+                append_utf8(folded, buffer_);
+            }
+        }
+    }
+    end_word();
+    return words_;
+}
+
+std::span<const std::string_view> TextNormalizer::words() const {
+    return words_;
+}
+
+std::string_view TextNormalizer::text() const {
+    return buffer_;
+}
+
+size_t TextNormalizer::word_count() const {
+    return words_.size();
+}
+
+} // namespace lingua
@@ -1,6 +1,7 @@
 #include "lingua/text_processor.h"
-#include <utf8.h>
+#include "lingua/unicode.h"
 #include <algorithm>
+#include <array>
 #include <cctype>
 #include <regex>
 #include <stdexcept>
@@ -64,24 +65,33 @@ std::vector<Ngram> TextProcessor::generate_ngrams(const std::string& text, size_
 
     std::vector<Ngram> ngrams;
 
-    // Generate n-grams
+    // Generate n-grams; windows that are longer than an n-gram or not valid UTF-8 are skipped
     for (size_t i = 0; i + n <= words.size(); ++i) {
-        std::string ngram_str;
-        for (size_t j = 0; j < n; ++j) {
+        std::array<char32_t, Ngram::MAX_CHAR_COUNT> code_points {};
+        size_t count = 0;
+        bool valid = true;
+        for (size_t j = 0; j < n && valid; ++j) {
             if (j > 0) {
-                ngram_str += " ";
+                valid = count < code_points.size();
+                if (valid) {
+                    code_points[count++] = U' ';
+                }
+            }
+            const std::string& word = words[i + j];
+            for (size_t offset = 0; offset < word.size() && valid;) {
+                char32_t code_point = 0;
+                const size_t length = Ngram::decode_utf8(word, offset, code_point);
+                valid = length != 0 && count < code_points.size();
+                if (valid) {
+                    code_points[count++] = code_point;
+                    offset += length;
+                }
             }
-            ngram_str += words[i + j];
         }
-
-        // Debug output
-        // std::cout << "Creating ngram: '" << ngram_str << "'" << std::endl;
-        
-        try {
-            ngrams.emplace_back(ngram_str);
-        } catch (const std::invalid_argument& e) {
-            // Skip invalid n-grams
-            // std::cout << "Skipping invalid ngram: " << e.what() << std::endl;
+        if (valid) {
+            if (const auto ngram = Ngram::from_code_points({code_points.data(), count})) {
+                ngrams.push_back(*ngram);
+            }
         }
     }
 
@@ -100,7 +110,10 @@ std::string TextProcessor::normalize_unicode(const std::string& text) {
     } else {
         // If text is invalid UTF-8, replace invalid sequences with replacement character
         std::string normalized;
-        utf8::replace_invalid(text.begin(), text.end(), std::back_inserter(normalized));
+        normalized.reserve(text.size());
+        for (char32_t code_point : to_utf32(text)) {
+            append_utf8(code_point, normalized);
+        }
         return normalized;
     }
 }
@@ -110,11 +123,7 @@ bool TextProcessor::validate_unicode(const std::string& text) {
         return true;
     }
 
-    try {
-        return utf8::is_valid(text.begin(), text.end());
-    } catch (...) {
-        return false;
-    }
+    return is_valid_utf8(text);
 }
 
 std::string TextProcessor::remove_extra_whitespace(const std::string& text) {
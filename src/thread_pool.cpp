@@ -0,0 +1,109 @@
+#include "lingua/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+
+namespace lingua {
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    if (thread_count == 0) {
+        throw std::invalid_argument("A thread pool needs at least 1 thread");
+    }
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this] { run(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    task_available_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+size_t ThreadPool::thread_count() const {
+    return threads_.size();
+}
+
+size_t ThreadPool::default_thread_count() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t)>& body) {
+    // Helpers that start after every iteration was claimed return without touching body
+    struct State {
+        const std::function<void(size_t)>* body;
+        size_t count;
+        std::atomic<size_t> next{0};
+        size_t remaining;
+        std::exception_ptr error;
+        std::mutex mutex;
+        std::condition_variable finished;
+    };
+    const auto state = std::make_shared<State>();
+    state->body = &body;
+    state->count = count;
+    state->remaining = count;
+
+    const auto work = [](State& shared) {
+        for (size_t i = shared.next.fetch_add(1); i < shared.count; i = shared.next.fetch_add(1)) {
+            std::exception_ptr error;
+            try {
+                (*shared.body)(i);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            if (error && !shared.error) {
+                shared.error = error;
+            }
+            if (--shared.remaining == 0) {
+                shared.finished.notify_all();
+            }
+        }
+    };
+
+    const size_t helper_count = count > 1 ? std::min(count - 1, threads_.size()) : 0;
+    for (size_t i = 0; i < helper_count; ++i) {
+        enqueue([state, work] { work(*state); });
+    }
+    work(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->finished.wait(lock, [&state] { return state->remaining == 0; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    task_available_.notify_one();
+}
+
+void ThreadPool::run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            task_available_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace lingua
@@ -0,0 +1,566 @@
+#include "lingua/unicode.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace lingua {
+
+namespace {
+    // Bytes examined per step of the ASCII fast path
+    constexpr size_t ASCII_BLOCK = 32;
+
+    struct Sequence {
+        size_t length;
+        char32_t code_point;
+        bool valid;
+    };
+
+    inline bool is_continuation(unsigned char byte) noexcept {
+        return (byte & 0xC0) == 0x80;
+    }
+
+    // The maximal subpart of an invalid sequence starting at a byte above 0x7F: the lead
+    // byte and the continuation bytes that could still have completed it
+    Sequence invalid_sequence(const unsigned char* in, size_t available) noexcept {
+        const unsigned char lead = in[0];
+        size_t length = 1;
+        // The second byte is restricted so as to rule out overlong forms, surrogates and values above U+10FFFF
+        unsigned char lower = 0x80;
+        unsigned char upper = 0xBF;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            length = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            length = 3;
+            lower = lead == 0xE0 ? 0xA0 : 0x80;
+            upper = lead == 0xED ? 0x9F : 0xBF;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            length = 4;
+            lower = lead == 0xF0 ? 0x90 : 0x80;
+            upper = lead == 0xF4 ? 0x8F : 0xBF;
+        }
+        size_t subpart = 1;
+        while (subpart < length && subpart < available && in[subpart] >= lower && in[subpart] <= upper) {
+            ++subpart;
+            lower = 0x80;
+            upper = 0xBF;
+        }
+        return {subpart, REPLACEMENT_CHARACTER, false};
+    }
+
+    // Decodes the sequence starting at a byte above 0x7F. Valid sequences are decoded
+    // first and their value range checked after, which keeps the common case short.
+    inline Sequence decode_sequence(const unsigned char* in, size_t available) noexcept {
+        const unsigned char lead = in[0];
+        if (lead < 0xE0) {
+            if (lead >= 0xC2 && available >= 2 && is_continuation(in[1])) {
+                return {2, static_cast<char32_t>(((lead & 0x1F) << 6) | (in[1] & 0x3F)), true};
+            }
+        } else if (lead < 0xF0) {
+            if (available >= 3 && is_continuation(in[1]) && is_continuation(in[2])) {
+                const char32_t code_point = ((lead & 0x0F) << 12) | ((in[1] & 0x3F) << 6) | (in[2] & 0x3F);
+                if (code_point >= 0x800 && (code_point < 0xD800 || code_point > 0xDFFF)) {
+                    return {3, code_point, true};
+                }
+            }
+        } else if (lead <= 0xF4) {
+            if (available >= 4 && is_continuation(in[1]) && is_continuation(in[2]) && is_continuation(in[3])) {
+                const char32_t code_point =
+                    ((lead & 0x07) << 18) | ((in[1] & 0x3F) << 12) | ((in[2] & 0x3F) << 6) | (in[3] & 0x3F);
+                if (code_point >= 0x10000 && code_point <= 0x10FFFF) {
+                    return {4, code_point, true};
+                }
+            }
+        }
+        return invalid_sequence(in, available);
+    }
+
+#if defined(__AVX2__)
+    inline uint32_t non_ascii_mask(const unsigned char* in) noexcept {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(bytes));
+    }
+
+    inline void widen_ascii(const unsigned char* in, char32_t* out) noexcept {
+        for (size_t i = 0; i < ASCII_BLOCK; i += 8) {
+            const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(in + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_cvtepu8_epi32(bytes));
+        }
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    inline uint32_t non_ascii_mask(const unsigned char* in) noexcept {
+        const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16));
+        return static_cast<uint32_t>(_mm_movemask_epi8(low)) | (static_cast<uint32_t>(_mm_movemask_epi8(high)) << 16);
+    }
+
+    inline void widen_ascii(const unsigned char* in, char32_t* out) noexcept {
+        const __m128i zero = _mm_setzero_si128();
+        for (size_t i = 0; i < ASCII_BLOCK; i += 16) {
+            const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+            const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+            auto* words = reinterpret_cast<__m128i*>(out + i);
+            _mm_storeu_si128(words, _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(words + 1, _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(words + 2, _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(words + 3, _mm_unpackhi_epi16(high, zero));
+        }
+    }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    inline uint32_t non_ascii_mask(const unsigned char* in) noexcept {
+        const uint8x16_t either = vorrq_u8(vld1q_u8(in), vld1q_u8(in + 16));
+        if (vmaxvq_u8(either) < 0x80) {
+            return 0;
+        }
+        // NEON has no byte movemask; a block with a byte above 0x7F is sorted out byte by byte
+        uint32_t mask = 0;
+        for (size_t i = 0; i < ASCII_BLOCK; ++i) {
+            mask |= static_cast<uint32_t>(in[i] >> 7) << i;
+        }
+        return mask;
+    }
+
+    inline void widen_ascii(const unsigned char* in, char32_t* out) noexcept {
+        for (size_t i = 0; i < ASCII_BLOCK; i += 16) {
+            const uint8x16_t bytes = vld1q_u8(in + i);
+            const uint16x8_t low = vmovl_u8(vget_low_u8(bytes));
+            const uint16x8_t high = vmovl_u8(vget_high_u8(bytes));
+            auto* words = reinterpret_cast<uint32_t*>(out + i);
+            vst1q_u32(words, vmovl_u16(vget_low_u16(low)));
+            vst1q_u32(words + 4, vmovl_u16(vget_high_u16(low)));
+            vst1q_u32(words + 8, vmovl_u16(vget_low_u16(high)));
+            vst1q_u32(words + 12, vmovl_u16(vget_high_u16(high)));
+        }
+    }
+#else
+    // Eight bytes at a time in a 64-bit word
+    inline uint32_t non_ascii_mask(const unsigned char* in) noexcept {
+        for (size_t i = 0; i < ASCII_BLOCK; i += 8) {
+            uint64_t word = 0;
+            std::memcpy(&word, in + i, sizeof(word));
+            if ((word & 0x8080808080808080ULL) != 0) {
+                uint32_t mask = 0;
+                for (size_t j = i; j < ASCII_BLOCK; ++j) {
+                    mask |= static_cast<uint32_t>(in[j] >> 7) << j;
+                }
+                return mask;
+            }
+        }
+        return 0;
+    }
+
+    inline void widen_ascii(const unsigned char* in, char32_t* out) noexcept {
+        for (size_t i = 0; i < ASCII_BLOCK; ++i) {
+            out[i] = in[i];
+        }
+    }
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+    // Unsigned a >= b for every byte lane
+    inline __m128i at_least(__m128i bytes, unsigned char bound) noexcept {
+        return _mm_cmpeq_epi8(_mm_max_epu8(bytes, _mm_set1_epi8(static_cast<char>(bound))), bytes);
+    }
+
+    inline int byte_mask(__m128i bytes, unsigned char bound) noexcept {
+        return _mm_movemask_epi8(at_least(bytes, bound));
+    }
+
+    // Decodes eight lanes as sequences of up to three bytes, given the byte of each lane
+    // and the two after it widened to 16 bits; lanes that start an invalid sequence are
+    // set in errors
+    inline __m128i decode_lanes(__m128i first, __m128i second, __m128i third, __m128i& errors) noexcept {
+        const __m128i low6 = _mm_set1_epi16(0x3F);
+        const __m128i two = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(first, _mm_set1_epi16(0x1F)), 6),
+                                         _mm_and_si128(second, low6));
+        const __m128i three = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(first, 12),
+                                                        _mm_slli_epi16(_mm_and_si128(second, low6), 6)),
+                                           _mm_and_si128(third, low6));
+        const __m128i is_three = _mm_cmpgt_epi16(first, _mm_set1_epi16(0xDF));
+        const __m128i is_two = _mm_andnot_si128(is_three, _mm_cmpgt_epi16(first, _mm_set1_epi16(0xBF)));
+        // Overlong forms, and surrogates, whose top five bits are 11011
+        const __m128i top = _mm_srli_epi16(three, 11);
+        const __m128i bad_three = _mm_or_si128(_mm_cmpeq_epi16(top, _mm_setzero_si128()),
+                                               _mm_cmpeq_epi16(top, _mm_set1_epi16(0x1B)));
+        errors = _mm_or_si128(_mm_and_si128(is_two, _mm_cmplt_epi16(two, _mm_set1_epi16(0x80))),
+                              _mm_and_si128(is_three, bad_three));
+        const __m128i value = _mm_or_si128(_mm_andnot_si128(_mm_or_si128(is_two, is_three), first),
+                                           _mm_and_si128(is_two, two));
+        return _mm_or_si128(value, _mm_and_si128(is_three, three));
+    }
+
+    // Decodes the sequences of up to three bytes that start in the 17 bytes at in, up to
+    // the last one to start there, and appends them to out. Reads 18 bytes. Returns the
+    // bytes consumed, or 0 if the block holds a four-byte or invalid sequence.
+    inline size_t decode_block(const unsigned char* in, char32_t* out, size_t& written) noexcept {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 1));
+        const __m128i after_next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2));
+
+        const uint32_t high_bit = static_cast<uint32_t>(_mm_movemask_epi8(bytes));
+        const uint32_t lead = static_cast<uint32_t>(byte_mask(bytes, 0xC0));
+        const uint32_t three = static_cast<uint32_t>(byte_mask(bytes, 0xE0));
+        const uint32_t four = static_cast<uint32_t>(byte_mask(bytes, 0xF0));
+        const uint32_t continuation = (high_bit & ~lead) | (is_continuation(in[16]) ? 1u << 16 : 0u);
+        const uint32_t starts = ~continuation & 0x1FFFF;
+        if (starts <= 1) {
+            return 0;
+        }
+        const size_t length = static_cast<size_t>(std::bit_width(starts)) - 1;
+        const uint32_t before = (1u << length) - 1;
+        // Every continuation byte up to the last start must follow a two- or three-byte lead
+        const uint32_t expected = ((lead | three) << 1) | ((three & ~four) << 2);
+        if (((continuation ^ expected) & ((2u << length) - 1)) != 0 || (four & before) != 0) {
+            return 0;
+        }
+
+        __m128i low_errors;
+        __m128i high_errors;
+        alignas(16) uint16_t values[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(values),
+                        decode_lanes(_mm_unpacklo_epi8(bytes, zero), _mm_unpacklo_epi8(next, zero),
+                                     _mm_unpacklo_epi8(after_next, zero), low_errors));
+        _mm_store_si128(reinterpret_cast<__m128i*>(values + 8),
+                        decode_lanes(_mm_unpackhi_epi8(bytes, zero), _mm_unpackhi_epi8(next, zero),
+                                     _mm_unpackhi_epi8(after_next, zero), high_errors));
+        const uint32_t errors = static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(low_errors, high_errors)));
+        if ((errors & starts & before) != 0) {
+            return 0;
+        }
+        for (uint32_t remaining = starts & before; remaining != 0; remaining &= remaining - 1) {
+            out[written++] = values[std::countr_zero(remaining)];
+        }
+        return length;
+    }
+#else
+    // Without SSE2, sequences other than ASCII are decoded one at a time
+    inline size_t decode_block(const unsigned char*, char32_t*, size_t&) noexcept {
+        return 0;
+    }
+#endif
+
+    // Bytes of the text a step of the block paths may read
+    constexpr size_t BLOCK_READ = ASCII_BLOCK + 2;
+
+    struct CodePointRange {
+        char32_t first;
+        char32_t last;
+    };
+
+    // Code points from first to last, or every other one if stride is 2, fold to themselves plus delta
+    struct CaseFoldRange {
+        char32_t first;
+        char32_t last;
+        int32_t delta;
+        uint8_t stride;
+    };
+
+    // Generated from the Unicode 14.0 character database: the maximal ranges above
+    // U+007F of general categories L and M, unassigned code points included
+    constexpr CodePointRange LETTER_RANGES[] = {
+        {0xAA, 0xAA}, {0xB5, 0xB5}, {0xBA, 0xBA}, {0xC0, 0xD6}, {0xD8, 0xF6},
+        {0xF8, 0x2C1}, {0x2C6, 0x2D1}, {0x2E0, 0x2E4}, {0x2EC, 0x2EC}, {0x2EE, 0x2EE},
+        {0x300, 0x374}, {0x376, 0x37D}, {0x37F, 0x37F}, {0x386, 0x386}, {0x388, 0x3F5},
+        {0x3F7, 0x481}, {0x483, 0x559}, {0x560, 0x588}, {0x591, 0x5BD}, {0x5BF, 0x5BF},
+        {0x5C1, 0x5C2}, {0x5C4, 0x5C5}, {0x5C7, 0x5F2}, {0x610, 0x61A}, {0x620, 0x65F},
+        {0x66E, 0x6D3}, {0x6D5, 0x6DC}, {0x6DF, 0x6E8}, {0x6EA, 0x6EF}, {0x6FA, 0x6FC},
+        {0x6FF, 0x6FF}, {0x710, 0x7B1}, {0x7CA, 0x7F5}, {0x7FA, 0x7FD}, {0x800, 0x82D},
+        {0x840, 0x85B}, {0x860, 0x887}, {0x889, 0x88E}, {0x898, 0x8E1}, {0x8E3, 0x963},
+        {0x971, 0x9E3}, {0x9F0, 0x9F1}, {0x9FC, 0x9FC}, {0x9FE, 0xA5E}, {0xA70, 0xA75},
+        {0xA81, 0xAE3}, {0xAF9, 0xB63}, {0xB71, 0xB71}, {0xB82, 0xBD7}, {0xC00, 0xC63},
+        {0xC80, 0xC83}, {0xC85, 0xCE3}, {0xCF1, 0xD4E}, {0xD54, 0xD57}, {0xD5F, 0xD63},
+        {0xD7A, 0xDDF}, {0xDF2, 0xDF3}, {0xE01, 0xE3A}, {0xE40, 0xE4E}, {0xE81, 0xECD},
+        {0xEDC, 0xF00}, {0xF18, 0xF19}, {0xF35, 0xF35}, {0xF37, 0xF37}, {0xF39, 0xF39},
+        {0xF3E, 0xF84}, {0xF86, 0xFBC}, {0xFC6, 0xFC6}, {0x1000, 0x103F}, {0x1050, 0x108F},
+        {0x109A, 0x109D}, {0x10A0, 0x10FA}, {0x10FC, 0x135F}, {0x1380, 0x138F}, {0x13A0, 0x13FD},
+        {0x1401, 0x166C}, {0x166F, 0x167F}, {0x1681, 0x169A}, {0x16A0, 0x16EA}, {0x16F1, 0x1734},
+        {0x1740, 0x17D3}, {0x17D7, 0x17D7}, {0x17DC, 0x17DD}, {0x180B, 0x180D}, {0x180F, 0x180F},
+        {0x1820, 0x193B}, {0x1950, 0x19C9}, {0x1A00, 0x1A1B}, {0x1A20, 0x1A7F}, {0x1AA7, 0x1AA7},
+        {0x1AB0, 0x1B4C}, {0x1B6B, 0x1B73}, {0x1B80, 0x1BAF}, {0x1BBA, 0x1BF3}, {0x1C00, 0x1C37},
+        {0x1C4D, 0x1C4F}, {0x1C5A, 0x1C7D}, {0x1C80, 0x1CBF}, {0x1CD0, 0x1CD2}, {0x1CD4, 0x1FBC},
+        {0x1FBE, 0x1FBE}, {0x1FC2, 0x1FCC}, {0x1FD0, 0x1FDB}, {0x1FE0, 0x1FEC}, {0x1FF2, 0x1FFC},
+        {0x2071, 0x2071}, {0x207F, 0x207F}, {0x2090, 0x209C}, {0x20D0, 0x20F0}, {0x2102, 0x2102},
+        {0x2107, 0x2107}, {0x210A, 0x2113}, {0x2115, 0x2115}, {0x2119, 0x211D}, {0x2124, 0x2124},
+        {0x2126, 0x2126}, {0x2128, 0x2128}, {0x212A, 0x212D}, {0x212F, 0x2139}, {0x213C, 0x213F},
+        {0x2145, 0x2149}, {0x214E, 0x214E}, {0x2183, 0x2184}, {0x2C00, 0x2CE4}, {0x2CEB, 0x2CF3},
+        {0x2D00, 0x2D6F}, {0x2D7F, 0x2DFF}, {0x2E2F, 0x2E2F}, {0x3005, 0x3006}, {0x302A, 0x302F},
+        {0x3031, 0x3035}, {0x303B, 0x303C}, {0x3041, 0x309A}, {0x309D, 0x309F}, {0x30A1, 0x30FA},
+        {0x30FC, 0x318E}, {0x31A0, 0x31BF}, {0x31F0, 0x31FF}, {0x3400, 0x4DBF}, {0x4E00, 0xA48C},
+        {0xA4D0, 0xA4FD}, {0xA500, 0xA60C}, {0xA610, 0xA61F}, {0xA62A, 0xA672}, {0xA674, 0xA67D},
+        {0xA67F, 0xA6E5}, {0xA6F0, 0xA6F1}, {0xA717, 0xA71F}, {0xA722, 0xA788}, {0xA78B, 0xA827},
+        {0xA82C, 0xA82C}, {0xA840, 0xA873}, {0xA880, 0xA8C5}, {0xA8E0, 0xA8F7}, {0xA8FB, 0xA8FB},
+        {0xA8FD, 0xA8FF}, {0xA90A, 0xA92D}, {0xA930, 0xA953}, {0xA960, 0xA9C0}, {0xA9CF, 0xA9CF},
+        {0xA9E0, 0xA9EF}, {0xA9FA, 0xAA4D}, {0xAA60, 0xAA76}, {0xAA7A, 0xAADD}, {0xAAE0, 0xAAEF},
+        {0xAAF2, 0xAB5A}, {0xAB5C, 0xAB69}, {0xAB70, 0xABEA}, {0xABEC, 0xABED}, {0xAC00, 0xD7FB},
+        {0xF900, 0xFB28}, {0xFB2A, 0xFBB1}, {0xFBD3, 0xFD3D}, {0xFD50, 0xFDC7}, {0xFDF0, 0xFDFB},
+        {0xFE00, 0xFE0F}, {0xFE20, 0xFE2F}, {0xFE70, 0xFEFC}, {0xFF21, 0xFF3A}, {0xFF41, 0xFF5A},
+        {0xFF66, 0xFFDC}, {0x10000, 0x100FA}, {0x101FD, 0x102E0}, {0x10300, 0x1031F}, {0x1032D, 0x10340},
+        {0x10342, 0x10349}, {0x10350, 0x1039D}, {0x103A0, 0x103CF}, {0x10400, 0x1049D}, {0x104B0, 0x10563},
+        {0x10570, 0x10855}, {0x10860, 0x10876}, {0x10880, 0x1089E}, {0x108E0, 0x108F5}, {0x10900, 0x10915},
+        {0x10920, 0x10939}, {0x10980, 0x109B7}, {0x109BE, 0x109BF}, {0x10A00, 0x10A3F}, {0x10A60, 0x10A7C},
+        {0x10A80, 0x10A9C}, {0x10AC0, 0x10AC7}, {0x10AC9, 0x10AE6}, {0x10B00, 0x10B35}, {0x10B40, 0x10B55},
+        {0x10B60, 0x10B72}, {0x10B80, 0x10B91}, {0x10C00, 0x10CF2}, {0x10D00, 0x10D27}, {0x10E80, 0x10EAC},
+        {0x10EB0, 0x10F1C}, {0x10F27, 0x10F50}, {0x10F70, 0x10F85}, {0x10FB0, 0x10FC4}, {0x10FE0, 0x11046},
+        {0x11070, 0x110BA}, {0x110C2, 0x110C2}, {0x110D0, 0x110E8}, {0x11100, 0x11134}, {0x11144, 0x11173},
+        {0x11176, 0x111C4}, {0x111C9, 0x111CC}, {0x111CE, 0x111CF}, {0x111DA, 0x111DA}, {0x111DC, 0x111DC},
+        {0x11200, 0x11237}, {0x1123E, 0x112A8}, {0x112B0, 0x112EA}, {0x11300, 0x1144A}, {0x1145E, 0x114C5},
+        {0x114C7, 0x114C7}, {0x11580, 0x115C0}, {0x115D8, 0x11640}, {0x11644, 0x11644}, {0x11680, 0x116B8},
+        {0x11700, 0x1172B}, {0x11740, 0x1183A}, {0x118A0, 0x118DF}, {0x118FF, 0x11943}, {0x119A0, 0x119E1},
+        {0x119E3, 0x11A3E}, {0x11A47, 0x11A99}, {0x11A9D, 0x11A9D}, {0x11AB0, 0x11C40}, {0x11C72, 0x11D47},
+        {0x11D60, 0x11D98}, {0x11EE0, 0x11EF6}, {0x11FB0, 0x11FB0}, {0x12000, 0x12399}, {0x12480, 0x12FF0},
+        {0x13000, 0x1342E}, {0x14400, 0x16A5E}, {0x16A70, 0x16ABE}, {0x16AD0, 0x16AF4}, {0x16B00, 0x16B36},
+        {0x16B40, 0x16B43}, {0x16B63, 0x16E7F}, {0x16F00, 0x16FE1}, {0x16FE3, 0x1BC99}, {0x1BC9D, 0x1BC9E},
+        {0x1CF00, 0x1CF46}, {0x1D165, 0x1D169}, {0x1D16D, 0x1D172}, {0x1D17B, 0x1D182}, {0x1D185, 0x1D18B},
+        {0x1D1AA, 0x1D1AD}, {0x1D242, 0x1D244}, {0x1D400, 0x1D6C0}, {0x1D6C2, 0x1D6DA}, {0x1D6DC, 0x1D6FA},
+        {0x1D6FC, 0x1D714}, {0x1D716, 0x1D734}, {0x1D736, 0x1D74E}, {0x1D750, 0x1D76E}, {0x1D770, 0x1D788},
+        {0x1D78A, 0x1D7A8}, {0x1D7AA, 0x1D7C2}, {0x1D7C4, 0x1D7CB}, {0x1DA00, 0x1DA36}, {0x1DA3B, 0x1DA6C},
+        {0x1DA75, 0x1DA75}, {0x1DA84, 0x1DA84}, {0x1DA9B, 0x1E13D}, {0x1E14E, 0x1E14E}, {0x1E290, 0x1E2EF},
+        {0x1E7E0, 0x1E8C4}, {0x1E8D0, 0x1E94B}, {0x1EE00, 0x1EEBB}, {0x20000, 0x3134A}, {0xE0100, 0xE01EF},
+    };
+
+    // Generated from the Unicode 14.0 character database: the simple (C and S)
+    // foldings of CaseFolding.txt above U+007F
+    constexpr CaseFoldRange CASE_FOLD_RANGES[] = {
+        {0xB5, 0xB5, 775, 1}, {0xC0, 0xD6, 32, 1}, {0xD8, 0xDE, 32, 1}, {0x100, 0x12E, 1, 2},
+        {0x132, 0x136, 1, 2}, {0x139, 0x147, 1, 2}, {0x14A, 0x176, 1, 2}, {0x178, 0x178, -121, 1},
+        {0x179, 0x17D, 1, 2}, {0x17F, 0x17F, -268, 1}, {0x181, 0x181, 210, 1}, {0x182, 0x184, 1, 2},
+        {0x186, 0x186, 206, 1}, {0x187, 0x187, 1, 1}, {0x189, 0x18A, 205, 1}, {0x18B, 0x18B, 1, 1},
+        {0x18E, 0x18E, 79, 1}, {0x18F, 0x18F, 202, 1}, {0x190, 0x190, 203, 1}, {0x191, 0x191, 1, 1},
+        {0x193, 0x193, 205, 1}, {0x194, 0x194, 207, 1}, {0x196, 0x196, 211, 1}, {0x197, 0x197, 209, 1},
+        {0x198, 0x198, 1, 1}, {0x19C, 0x19C, 211, 1}, {0x19D, 0x19D, 213, 1}, {0x19F, 0x19F, 214, 1},
+        {0x1A0, 0x1A4, 1, 2}, {0x1A6, 0x1A6, 218, 1}, {0x1A7, 0x1A7, 1, 1}, {0x1A9, 0x1A9, 218, 1},
+        {0x1AC, 0x1AC, 1, 1}, {0x1AE, 0x1AE, 218, 1}, {0x1AF, 0x1AF, 1, 1}, {0x1B1, 0x1B2, 217, 1},
+        {0x1B3, 0x1B5, 1, 2}, {0x1B7, 0x1B7, 219, 1}, {0x1B8, 0x1B8, 1, 1}, {0x1BC, 0x1BC, 1, 1},
+        {0x1C4, 0x1C4, 2, 1}, {0x1C5, 0x1C5, 1, 1}, {0x1C7, 0x1C7, 2, 1}, {0x1C8, 0x1C8, 1, 1},
+        {0x1CA, 0x1CA, 2, 1}, {0x1CB, 0x1DB, 1, 2}, {0x1DE, 0x1EE, 1, 2}, {0x1F1, 0x1F1, 2, 1},
+        {0x1F2, 0x1F4, 1, 2}, {0x1F6, 0x1F6, -97, 1}, {0x1F7, 0x1F7, -56, 1}, {0x1F8, 0x21E, 1, 2},
+        {0x220, 0x220, -130, 1}, {0x222, 0x232, 1, 2}, {0x23A, 0x23A, 10795, 1}, {0x23B, 0x23B, 1, 1},
+        {0x23D, 0x23D, -163, 1}, {0x23E, 0x23E, 10792, 1}, {0x241, 0x241, 1, 1}, {0x243, 0x243, -195, 1},
+        {0x244, 0x244, 69, 1}, {0x245, 0x245, 71, 1}, {0x246, 0x24E, 1, 2}, {0x345, 0x345, 116, 1},
+        {0x370, 0x372, 1, 2}, {0x376, 0x376, 1, 1}, {0x37F, 0x37F, 116, 1}, {0x386, 0x386, 38, 1},
+        {0x388, 0x38A, 37, 1}, {0x38C, 0x38C, 64, 1}, {0x38E, 0x38F, 63, 1}, {0x391, 0x3A1, 32, 1},
+        {0x3A3, 0x3AB, 32, 1}, {0x3C2, 0x3C2, 1, 1}, {0x3CF, 0x3CF, 8, 1}, {0x3D0, 0x3D0, -30, 1},
+        {0x3D1, 0x3D1, -25, 1}, {0x3D5, 0x3D5, -15, 1}, {0x3D6, 0x3D6, -22, 1}, {0x3D8, 0x3EE, 1, 2},
+        {0x3F0, 0x3F0, -54, 1}, {0x3F1, 0x3F1, -48, 1}, {0x3F4, 0x3F4, -60, 1}, {0x3F5, 0x3F5, -64, 1},
+        {0x3F7, 0x3F7, 1, 1}, {0x3F9, 0x3F9, -7, 1}, {0x3FA, 0x3FA, 1, 1}, {0x3FD, 0x3FF, -130, 1},
+        {0x400, 0x40F, 80, 1}, {0x410, 0x42F, 32, 1}, {0x460, 0x480, 1, 2}, {0x48A, 0x4BE, 1, 2},
+        {0x4C0, 0x4C0, 15, 1}, {0x4C1, 0x4CD, 1, 2}, {0x4D0, 0x52E, 1, 2}, {0x531, 0x556, 48, 1},
+        {0x10A0, 0x10C5, 7264, 1}, {0x10C7, 0x10C7, 7264, 1}, {0x10CD, 0x10CD, 7264, 1}, {0x13F8, 0x13FD, -8, 1},
+        {0x1C80, 0x1C80, -6222, 1}, {0x1C81, 0x1C81, -6221, 1}, {0x1C82, 0x1C82, -6212, 1}, {0x1C83, 0x1C84, -6210, 1},
+        {0x1C85, 0x1C85, -6211, 1}, {0x1C86, 0x1C86, -6204, 1}, {0x1C87, 0x1C87, -6180, 1}, {0x1C88, 0x1C88, 35267, 1},
+        {0x1C90, 0x1CBA, -3008, 1}, {0x1CBD, 0x1CBF, -3008, 1}, {0x1E00, 0x1E94, 1, 2}, {0x1E9B, 0x1E9B, -58, 1},
+        {0x1E9E, 0x1E9E, -7615, 1}, {0x1EA0, 0x1EFE, 1, 2}, {0x1F08, 0x1F0F, -8, 1}, {0x1F18, 0x1F1D, -8, 1},
+        {0x1F28, 0x1F2F, -8, 1}, {0x1F38, 0x1F3F, -8, 1}, {0x1F48, 0x1F4D, -8, 1}, {0x1F59, 0x1F5F, -8, 2},
+        {0x1F68, 0x1F6F, -8, 1}, {0x1F88, 0x1F8F, -8, 1}, {0x1F98, 0x1F9F, -8, 1}, {0x1FA8, 0x1FAF, -8, 1},
+        {0x1FB8, 0x1FB9, -8, 1}, {0x1FBA, 0x1FBB, -74, 1}, {0x1FBC, 0x1FBC, -9, 1}, {0x1FBE, 0x1FBE, -7173, 1},
+        {0x1FC8, 0x1FCB, -86, 1}, {0x1FCC, 0x1FCC, -9, 1}, {0x1FD8, 0x1FD9, -8, 1}, {0x1FDA, 0x1FDB, -100, 1},
+        {0x1FE8, 0x1FE9, -8, 1}, {0x1FEA, 0x1FEB, -112, 1}, {0x1FEC, 0x1FEC, -7, 1}, {0x1FF8, 0x1FF9, -128, 1},
+        {0x1FFA, 0x1FFB, -126, 1}, {0x1FFC, 0x1FFC, -9, 1}, {0x2126, 0x2126, -7517, 1}, {0x212A, 0x212A, -8383, 1},
+        {0x212B, 0x212B, -8262, 1}, {0x2132, 0x2132, 28, 1}, {0x2160, 0x216F, 16, 1}, {0x2183, 0x2183, 1, 1},
+        {0x24B6, 0x24CF, 26, 1}, {0x2C00, 0x2C2F, 48, 1}, {0x2C60, 0x2C60, 1, 1}, {0x2C62, 0x2C62, -10743, 1},
+        {0x2C63, 0x2C63, -3814, 1}, {0x2C64, 0x2C64, -10727, 1}, {0x2C67, 0x2C6B, 1, 2}, {0x2C6D, 0x2C6D, -10780, 1},
+        {0x2C6E, 0x2C6E, -10749, 1}, {0x2C6F, 0x2C6F, -10783, 1}, {0x2C70, 0x2C70, -10782, 1}, {0x2C72, 0x2C72, 1, 1},
+        {0x2C75, 0x2C75, 1, 1}, {0x2C7E, 0x2C7F, -10815, 1}, {0x2C80, 0x2CE2, 1, 2}, {0x2CEB, 0x2CED, 1, 2},
+        {0x2CF2, 0x2CF2, 1, 1}, {0xA640, 0xA66C, 1, 2}, {0xA680, 0xA69A, 1, 2}, {0xA722, 0xA72E, 1, 2},
+        {0xA732, 0xA76E, 1, 2}, {0xA779, 0xA77B, 1, 2}, {0xA77D, 0xA77D, -35332, 1}, {0xA77E, 0xA786, 1, 2},
+        {0xA78B, 0xA78B, 1, 1}, {0xA78D, 0xA78D, -42280, 1}, {0xA790, 0xA792, 1, 2}, {0xA796, 0xA7A8, 1, 2},
+        {0xA7AA, 0xA7AA, -42308, 1}, {0xA7AB, 0xA7AB, -42319, 1}, {0xA7AC, 0xA7AC, -42315, 1}, {0xA7AD, 0xA7AD, -42305, 1},
+        {0xA7AE, 0xA7AE, -42308, 1}, {0xA7B0, 0xA7B0, -42258, 1}, {0xA7B1, 0xA7B1, -42282, 1}, {0xA7B2, 0xA7B2, -42261, 1},
+        {0xA7B3, 0xA7B3, 928, 1}, {0xA7B4, 0xA7C2, 1, 2}, {0xA7C4, 0xA7C4, -48, 1}, {0xA7C5, 0xA7C5, -42307, 1},
+        {0xA7C6, 0xA7C6, -35384, 1}, {0xA7C7, 0xA7C9, 1, 2}, {0xA7D0, 0xA7D0, 1, 1}, {0xA7D6, 0xA7D8, 1, 2},
+        {0xA7F5, 0xA7F5, 1, 1}, {0xAB70, 0xABBF, -38864, 1}, {0xFF21, 0xFF3A, 32, 1}, {0x10400, 0x10427, 40, 1},
+        {0x104B0, 0x104D3, 40, 1}, {0x10570, 0x1057A, 39, 1}, {0x1057C, 0x1058A, 39, 1}, {0x1058C, 0x10592, 39, 1},
+        {0x10594, 0x10595, 39, 1}, {0x10C80, 0x10CB2, 64, 1}, {0x118A0, 0x118BF, 32, 1}, {0x16E40, 0x16E5F, 32, 1},
+        {0x1E900, 0x1E921, 34, 1},
+    };
+
+    // One bit per code point of the Basic Multilingual Plane, so the code points of
+    // most scripts skip the binary search over the range tables
+    using BmpBitmap = std::array<uint64_t, 0x10000 / 64>;
+
+    constexpr void set_bmp_bit(BmpBitmap& bitmap, char32_t code_point) {
+        bitmap[code_point / 64] |= uint64_t {1} << (code_point % 64);
+    }
+
+    constexpr bool test_bmp_bit(const BmpBitmap& bitmap, char32_t code_point) {
+        return (bitmap[code_point / 64] >> (code_point % 64)) & 1;
+    }
+
+    constexpr BmpBitmap make_letter_bitmap() {
+        BmpBitmap bitmap {};
+        for (const CodePointRange& range : LETTER_RANGES) {
+            for (char32_t code_point = range.first; code_point <= range.last && code_point < 0x10000; ++code_point) {
+                set_bmp_bit(bitmap, code_point);
+            }
+        }
+        return bitmap;
+    }
+
+    constexpr BmpBitmap make_case_fold_bitmap() {
+        BmpBitmap bitmap {};
+        for (const CaseFoldRange& range : CASE_FOLD_RANGES) {
+            for (char32_t code_point = range.first; code_point <= range.last && code_point < 0x10000;
+                 code_point += range.stride) {
+                set_bmp_bit(bitmap, code_point);
+            }
+        }
+        return bitmap;
+    }
+
+    constexpr BmpBitmap BMP_LETTERS = make_letter_bitmap();
+    constexpr BmpBitmap BMP_CASE_FOLDS = make_case_fold_bitmap();
+}
+
+Utf8DecodeResult decode_utf8(std::string_view text, std::span<char32_t> out) noexcept {
+    const auto* in = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t size = text.size();
+    const size_t capacity = out.size();
+    char32_t* const code_points = out.data();
+    size_t offset = 0;
+    size_t written = 0;
+    size_t invalid = 0;
+    while (offset < size && written < capacity) {
+        if (size - offset >= BLOCK_READ && capacity - written >= ASCII_BLOCK) {
+            if (non_ascii_mask(in + offset) == 0) {
+                widen_ascii(in + offset, code_points + written);
+                offset += ASCII_BLOCK;
+                written += ASCII_BLOCK;
+                continue;
+            }
+            if (const size_t consumed = decode_block(in + offset, code_points, written)) {
+                offset += consumed;
+                continue;
+            }
+        }
+        // Near the ends of the text and the output, and for four-byte and invalid sequences
+        if (in[offset] < 0x80) {
+            code_points[written++] = in[offset++];
+            continue;
+        }
+        const Sequence sequence = decode_sequence(in + offset, size - offset);
+        code_points[written++] = sequence.code_point;
+        offset += sequence.length;
+        invalid += sequence.valid ? 0 : 1;
+    }
+    return {offset, written, invalid};
+}
+
+std::u32string to_utf32(std::string_view text) {
+    // A text has at most one code point per byte
+    std::u32string code_points(text.size(), U'\0');
+    const Utf8DecodeResult decoded = decode_utf8(text, code_points);
+    code_points.resize(decoded.code_points_written);
+    return code_points;
+}
+
+bool is_valid_utf8(std::string_view text) noexcept {
+    const auto* in = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t size = text.size();
+    char32_t scratch[ASCII_BLOCK];
+    for (size_t offset = 0; offset < size;) {
+        if (size - offset >= BLOCK_READ) {
+            if (non_ascii_mask(in + offset) == 0) {
+                offset += ASCII_BLOCK;
+                continue;
+            }
+            size_t written = 0;
+            if (const size_t consumed = decode_block(in + offset, scratch, written)) {
+                offset += consumed;
+                continue;
+            }
+        }
+        if (in[offset] < 0x80) {
+            ++offset;
+            continue;
+        }
+        const Sequence sequence = decode_sequence(in + offset, size - offset);
+        if (!sequence.valid) {
+            return false;
+        }
+        offset += sequence.length;
+    }
+    return true;
+}
+
+size_t ascii_prefix_length(std::string_view text) noexcept {
+    const auto* in = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t size = text.size();
+    size_t offset = 0;
+    while (size - offset >= ASCII_BLOCK) {
+        const uint32_t mask = non_ascii_mask(in + offset);
+        if (mask != 0) {
+            return offset + static_cast<size_t>(std::countr_zero(mask));
+        }
+        offset += ASCII_BLOCK;
+    }
+    while (offset < size && in[offset] < 0x80) {
+        ++offset;
+    }
+    return offset;
+}
+
+char32_t fold_case(char32_t code_point) noexcept {
+    if (code_point < 0x80) {
+        return code_point >= 'A' && code_point <= 'Z' ? code_point + 32 : code_point;
+    }
+    if (code_point < 0x10000 && !test_bmp_bit(BMP_CASE_FOLDS, code_point)) {
+        return code_point;
+    }
+    const auto* range = std::upper_bound(
+        std::begin(CASE_FOLD_RANGES), std::end(CASE_FOLD_RANGES), code_point,
+        [](char32_t value, const CaseFoldRange& candidate) { return value < candidate.first; });
+    if (range == std::begin(CASE_FOLD_RANGES)) {
+        return code_point;
+    }
+    --range;
+    if (code_point > range->last || (code_point - range->first) % range->stride != 0) {
+        return code_point;
+    }
+    return static_cast<char32_t>(static_cast<int32_t>(code_point) + range->delta);
+}
+
+bool is_letter(char32_t code_point) noexcept {
+    if (code_point < 0x80) {
+        return (code_point | 0x20) >= 'a' && (code_point | 0x20) <= 'z';
+    }
+    if (code_point < 0x10000) {
+        return test_bmp_bit(BMP_LETTERS, code_point);
+    }
+    const auto* range = std::upper_bound(
+        std::begin(LETTER_RANGES), std::end(LETTER_RANGES), code_point,
+        [](char32_t value, const CodePointRange& candidate) { return value < candidate.first; });
+    return range != std::begin(LETTER_RANGES) && code_point <= (range - 1)->last;
+}
+
+void append_utf8(char32_t code_point, std::string& out) {
+    if (code_point < 0x80) {
+        out += static_cast<char>(code_point);
+    } else if (code_point < 0x800) {
+        const char bytes[] = {static_cast<char>(0xC0 | (code_point >> 6)), static_cast<char>(0x80 | (code_point & 0x3F))};
+        out.append(bytes, sizeof(bytes));
+    } else if (code_point < 0x10000) {
+        const char bytes[] = {static_cast<char>(0xE0 | (code_point >> 12)),
+                              static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)),
+                              static_cast<char>(0x80 | (code_point & 0x3F))};
+        out.append(bytes, sizeof(bytes));
+    } else {
+        const char bytes[] = {static_cast<char>(0xF0 | (code_point >> 18)),
+                              static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)),
+                              static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)),
+                              static_cast<char>(0x80 | (code_point & 0x3F))};
+        out.append(bytes, sizeof(bytes));
+    }
+}
+
+} // namespace lingua
@@ -1,12 +1,87 @@
 #include <gtest/gtest.h>
 #include "lingua/lingua.h"
+#include "lingua/embedded_models.h"
 #include "lingua/model.h"
+#include "lingua/model_builder.h"
+#include "lingua/model_bundle.h"
 #include "lingua/model_loader.h"
+#include "lingua/model_registry.h"
+#include "lingua/shared_model_store.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <new>
 #include <stdexcept>
+#include <thread>
 #include <unordered_set>
 
 using namespace lingua;
 
+// Counting allocator used to check memory accounting against real allocations.
+// Every block carries a header holding its requested size.
+namespace {
+    constexpr size_t ALLOCATION_HEADER_SIZE = alignof(std::max_align_t);
+    std::atomic<size_t> live_allocated_bytes{0};
+    std::atomic<size_t> allocation_count{0};
+
+    size_t allocated_bytes() {
+        return live_allocated_bytes.load();
+    }
+
+    size_t allocations() {
+        return allocation_count.load();
+    }
+}
+
+namespace {
+    // Kept out of line so the compiler does not trace the block that operator
+    // delete frees back to the pointer operator new returned
+    [[gnu::noinline]] std::byte* allocation_block(void* ptr) noexcept {
+        return static_cast<std::byte*>(ptr) - ALLOCATION_HEADER_SIZE;
+    }
+}
+
+void* operator new(size_t size) {
+    void* block = std::malloc(size + ALLOCATION_HEADER_SIZE);
+    if (block == nullptr) {
+        throw std::bad_alloc();
+    }
+    std::memcpy(block, &size, sizeof(size));
+    live_allocated_bytes += size;
+    ++allocation_count;
+    return static_cast<std::byte*>(block) + ALLOCATION_HEADER_SIZE;
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+    std::byte* block = allocation_block(ptr);
+    size_t size = 0;
+    std::memcpy(&size, block, sizeof(size));
+    live_allocated_bytes -= size;
+    std::free(block);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    operator delete(ptr);
+}
+
+namespace {
+    // Appends instead of "prefix" + std::to_string(i), on which GCC 12 reports a false -Wrestrict
+    std::string numbered(const char* prefix, size_t number) {
+        std::string key(prefix);
+        key += std::to_string(number);
+        return key;
+    }
+}
+
 // Test Language enum values
 TEST(LanguageTest, EnumValues) {
     // Just verify that the enum values exist, not their specific positions
@@ -302,8 +377,21 @@ TEST(LanguageDetectorBuilderTest, TestWithPreloadedLanguageModels) {
     EXPECT_NO_THROW(builder.with_preloaded_language_models());
     
     // Test building after setting
-    auto detector = builder.with_preloaded_language_models().build();
-    SUCCEED();
+    size_t progress_calls = 0;
+    size_t total_count = 0;
+    auto detector = builder.with_preloaded_language_models([&](const ModelPreloadProgress& progress) {
+        ++progress_calls;
+        total_count = progress.total_count;
+        EXPECT_EQ(progress.loaded_count, progress_calls);
+    }).build();
+
+    // German has no unique unigram model
+    ASSERT_TRUE(detector.preload_report().has_value());
+    EXPECT_EQ(detector.preload_report()->model_count, 29);
+    EXPECT_EQ(progress_calls, 29);
+    EXPECT_EQ(total_count, 29);
+    EXPECT_EQ(detector.memory_report().models.size(), 29);
+    EXPECT_FALSE(LanguageDetectorBuilder::from_languages({Language::ENGLISH}).build().preload_report().has_value());
 }
 
 TEST(LanguageDetectorBuilderTest, TestWithLowAccuracyMode) {
@@ -959,6 +1047,797 @@ TEST(ModelLoaderTest, CacheFunctionality) {
     SUCCEED() << "Skipping cache tests - would require actual model files";
 }
 
+TEST(ModelLoaderTest, MemoryReport) {
+    if (find_embedded_model(Language::ENGLISH, 1, ModelKind::PROBABILITY) != nullptr) {
+        GTEST_SKIP() << "Embedded models are not allocated on the heap";
+    }
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+    EXPECT_EQ(loader.memory_report().total_bytes, 0);
+
+    // Allocations made while loading, minus the parser's released buffers,
+    // are the model plus its cache entry; the reused decode buffers are
+    // grown beforehand by compiling the larger model once
+    loader.compile_model(Language::ENGLISH, 5, ModelKind::UNIQUE);
+    const size_t before = allocated_bytes();
+    auto unigrams = loader.load_probability_model(Language::ENGLISH, 1);
+    auto unique = loader.load_count_model(Language::ENGLISH, 5, NgramModelType::UNIQUE);
+    const size_t allocated = allocated_bytes() - before;
+    const size_t reported = unigrams->memory_usage_bytes() + unique->memory_usage_bytes();
+    EXPECT_NEAR(static_cast<double>(reported), static_cast<double>(allocated), 0.03 * allocated);
+
+    auto german = loader.load_probability_model(Language::GERMAN, 1);
+    auto report = loader.memory_report();
+    ASSERT_EQ(report.models.size(), 3);
+    EXPECT_EQ(report.total_bytes, reported + german->memory_usage_bytes());
+    EXPECT_EQ(report.bytes_by_language[Language::ENGLISH], reported);
+    EXPECT_EQ(report.bytes_by_language[Language::GERMAN], german->memory_usage_bytes());
+    EXPECT_EQ(report.bytes_by_ngram_length[5], unique->memory_usage_bytes());
+    EXPECT_EQ(report.bytes_by_model_type["unique"], unique->memory_usage_bytes());
+    EXPECT_EQ(report.models[0].language, Language::ENGLISH);
+    EXPECT_EQ(report.models[0].ngram_length, 1);
+    EXPECT_EQ(report.models[0].model_type, "probability");
+    EXPECT_EQ(report.models[0].ngram_count, unigrams->size());
+
+    // A detector only sees the models of its own languages
+    auto detector = LanguageDetectorBuilder::from_languages({Language::GERMAN, Language::FRENCH}).build();
+    auto detector_report = detector.memory_report();
+    ASSERT_EQ(detector_report.models.size(), 1);
+    EXPECT_EQ(detector_report.total_bytes, german->memory_usage_bytes());
+
+    loader.clear_cache();
+}
+
+TEST(ModelTest, MemoryUsage) {
+    std::vector<std::string> long_keys;
+    for (int i = 0; i < 2000; ++i) {
+        long_keys.push_back("ngram-with-long-key-" + std::to_string(i));
+    }
+
+    ModelBuilder probabilities(Language::ENGLISH, 4, ModelKind::PROBABILITY);
+    for (int i = 0; i < 2000; ++i) {
+        probabilities.set_probability(std::to_string(i), 0.5);
+    }
+    const size_t before = allocated_bytes();
+    auto* model = new NgramProbabilityModel(probabilities.freeze());
+    const size_t allocated = allocated_bytes() - before;
+    EXPECT_NEAR(static_cast<double>(model->memory_usage_bytes()), static_cast<double>(allocated), 0.03 * allocated);
+    delete model;
+
+    ModelBuilder set(Language::ENGLISH, 5, ModelKind::UNIQUE);
+    for (const auto& key : long_keys) {
+        set.add_ngram(key);
+    }
+    const size_t before_compact = allocated_bytes();
+    auto* compact = new NgramCountModel(set.freeze_fingerprints(32));
+    const size_t allocated_compact = allocated_bytes() - before_compact;
+    EXPECT_NEAR(static_cast<double>(compact->memory_usage_bytes()), static_cast<double>(allocated_compact),
+                0.03 * allocated_compact);
+    EXPECT_LT(compact->memory_usage_bytes(), 8 * compact->size() + sizeof(FrozenModelHeader) + sizeof(FrozenModel));
+    delete compact;
+}
+
+TEST(ModelLoaderTest, CompactCountModels) {
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+    EXPECT_DOUBLE_EQ(loader.get_count_model_false_positive_rate(), ModelLoader::DEFAULT_COUNT_MODEL_FALSE_POSITIVE_RATE);
+
+    auto unique = loader.load_count_model(Language::ENGLISH, 5, NgramModelType::UNIQUE);
+    EXPECT_TRUE(unique->is_compact());
+    EXPECT_GT(unique->size(), 0);
+    EXPECT_TRUE(unique->contains("xysms"));
+    EXPECT_TRUE(unique->contains("xpáas"));
+    EXPECT_LE(unique->false_positive_rate(), ModelLoader::DEFAULT_COUNT_MODEL_FALSE_POSITIVE_RATE);
+
+    auto most_common = loader.load_count_model(Language::ENGLISH, 3, NgramModelType::MOST_COMMON);
+    EXPECT_TRUE(most_common->contains("the"));
+    EXPECT_FALSE(most_common->contains("zzz"));
+
+    // Exact models are loaded when the rate is 0
+    loader.set_count_model_false_positive_rate(0.0);
+    loader.clear_cache();
+    auto exact = loader.load_count_model(Language::ENGLISH, 3, NgramModelType::MOST_COMMON);
+    EXPECT_FALSE(exact->is_compact());
+    EXPECT_EQ(exact->size(), most_common->size());
+    EXPECT_TRUE(exact->contains("the"));
+
+    EXPECT_THROW(loader.set_count_model_false_positive_rate(1.0), std::invalid_argument);
+    EXPECT_THROW(loader.set_count_model_false_positive_rate(-0.1), std::invalid_argument);
+    loader.set_count_model_false_positive_rate(ModelLoader::DEFAULT_COUNT_MODEL_FALSE_POSITIVE_RATE);
+    loader.clear_cache();
+}
+
+TEST(ModelLoaderTest, BinaryModels) {
+    if (find_embedded_model(Language::WELSH, 1, ModelKind::PROBABILITY) != nullptr) {
+        GTEST_SKIP() << "Embedded models take precedence over binary model files";
+    }
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+    EXPECT_EQ(ModelLoader::model_file_path(Language::ENGLISH, 3, ModelKind::MOST_COMMON, ModelLoader::BINARY_MODEL_EXTENSION),
+              "models/en/models/mostcommon_trigrams.lfm");
+
+    const std::string path = ModelLoader::model_file_path(
+        Language::WELSH, 1, ModelKind::PROBABILITY, ModelLoader::BINARY_MODEL_EXTENSION);
+    const std::string backup_path = path + ".bak";
+    const bool had_binary = std::rename(path.c_str(), backup_path.c_str()) == 0;
+    const FrozenModel compiled = loader.compile_model(Language::WELSH, 1, ModelKind::PROBABILITY);
+    EXPECT_GT(compiled.size(), 1);
+
+    // A binary model is used as is
+    ModelBuilder builder(Language::WELSH, 1, ModelKind::PROBABILITY);
+    builder.set_probability("a", 0.5);
+    builder.freeze().write_to(path);
+    auto binary = loader.load_probability_model(Language::WELSH, 1);
+    EXPECT_EQ(binary->size(), 1);
+    EXPECT_DOUBLE_EQ(binary->get_probability("a"), 0.5);
+
+    // A binary model for the wrong n-gram length falls back to JSON
+    loader.clear_cache();
+    ModelBuilder bigrams(Language::WELSH, 2, ModelKind::PROBABILITY);
+    bigrams.freeze().write_to(path);
+    auto fallback = loader.load_probability_model(Language::WELSH, 1);
+    EXPECT_EQ(fallback->size(), compiled.size());
+
+    // So do binary models that are truncated or older than their JSON model
+    loader.clear_cache();
+    builder.freeze().write_to(path);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+    EXPECT_EQ(loader.load_probability_model(Language::WELSH, 1)->size(), compiled.size());
+    loader.clear_cache();
+    builder.freeze().write_to(path);
+    const std::string json_path = ModelLoader::model_file_path(
+        Language::WELSH, 1, ModelKind::PROBABILITY, ModelLoader::JSON_MODEL_EXTENSION);
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(json_path) - std::chrono::hours(1));
+    EXPECT_EQ(loader.load_probability_model(Language::WELSH, 1)->size(), compiled.size());
+
+    std::remove(path.c_str());
+    if (had_binary) {
+        std::rename(backup_path.c_str(), path.c_str());
+    }
+    loader.clear_cache();
+}
+
+TEST(ModelLoaderTest, MemoryMappedModels) {
+    const std::string path = ::testing::TempDir() + "mapped_file.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << std::string(3 * 4096, 'x');
+    }
+    auto lazy = MappedFile::open(path);
+    EXPECT_EQ(lazy->bytes().size(), 3 * 4096);
+    EXPECT_EQ(static_cast<char>(lazy->bytes()[4096]), 'x');
+    auto populated = MappedFile::open(path, {true, MappingAdvice::WILLNEED, false});
+    EXPECT_EQ(populated->resident_bytes(), 3 * 4096);
+    { std::ofstream truncate(path, std::ios::trunc); }
+    EXPECT_THROW(MappedFile::open(path), ModelLoadException);
+    std::remove(path.c_str());
+    EXPECT_THROW(MappedFile::open(path), ModelLoadException);
+
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+    const std::string model_path = ModelLoader::model_file_path(
+        Language::WELSH, 2, ModelKind::UNIQUE, ModelLoader::BINARY_MODEL_EXTENSION);
+    const std::string backup_path = model_path + ".bak";
+    const bool had_binary = std::rename(model_path.c_str(), backup_path.c_str()) == 0;
+    const FrozenModel compiled = loader.compile_model(Language::WELSH, 2, ModelKind::UNIQUE);
+    compiled.write_to(model_path);
+
+    loader.set_memory_mapping(true, {false, MappingAdvice::RANDOM, false});
+    EXPECT_TRUE(loader.is_memory_mapping_enabled());
+    auto model = loader.load_count_model(Language::WELSH, 2, NgramModelType::UNIQUE);
+    EXPECT_TRUE(model->is_compact());
+    EXPECT_EQ(model->size(), compiled.size());
+    EXPECT_NE(model->frozen_model().bytes().data(), compiled.bytes().data());
+    loader.set_memory_mapping(false);
+    EXPECT_FALSE(loader.is_memory_mapping_enabled());
+
+    // The mapping outlives the file name and the cache
+    std::remove(model_path.c_str());
+    if (had_binary) {
+        std::rename(backup_path.c_str(), model_path.c_str());
+    }
+    loader.clear_cache();
+    EXPECT_GT(model->memory_usage_bytes(), 0);
+    EXPECT_FALSE(model->contains("zzzzzzzz"));
+}
+
+TEST(ModelLoaderTest, StreamingDecompression) {
+    auto& loader = lingua::ModelLoader::get_instance();
+
+    // Consecutive loads on one thread reuse the decode buffers
+    const FrozenModel large = loader.compile_model(Language::ENGLISH, 5, ModelKind::PROBABILITY);
+    const FrozenModel small = loader.compile_model(Language::ENGLISH, 1, ModelKind::PROBABILITY);
+    EXPECT_GT(large.size(), small.size());
+    EXPECT_GT(small.get_probability("e"), 0.0);
+    EXPECT_GT(large.get_probability("there"), 0.0);
+
+    const std::string path = ModelLoader::model_file_path(
+        Language::WELSH, 1, ModelKind::PROBABILITY, ModelLoader::JSON_MODEL_EXTENSION);
+    const std::string backup_path = path + ".bak";
+    ASSERT_EQ(std::rename(path.c_str(), backup_path.c_str()), 0);
+    std::string compressed;
+    {
+        std::ifstream original(backup_path, std::ios::binary);
+        compressed.assign(std::istreambuf_iterator<char>(original), {});
+    }
+    {
+        std::ofstream truncated(path, std::ios::binary | std::ios::trunc);
+        truncated.write(compressed.data(), static_cast<std::streamsize>(compressed.size() / 2));
+    }
+    EXPECT_THROW(loader.compile_model(Language::WELSH, 1, ModelKind::PROBABILITY), std::runtime_error);
+    {
+        std::ofstream corrupted(path, std::ios::binary | std::ios::trunc);
+        corrupted << "not brotli at all";
+    }
+    EXPECT_THROW(loader.compile_model(Language::WELSH, 1, ModelKind::PROBABILITY), std::runtime_error);
+    std::rename(backup_path.c_str(), path.c_str());
+    EXPECT_GT(loader.compile_model(Language::WELSH, 1, ModelKind::PROBABILITY).size(), 0);
+}
+
+TEST(ModelLoaderTest, ParseModel) {
+    auto& loader = lingua::ModelLoader::get_instance();
+
+    const ModelBuilder probabilities = loader.parse_model(Language::ENGLISH, 2, ModelKind::PROBABILITY);
+    const FrozenModel frozen_probabilities = probabilities.freeze();
+    EXPECT_EQ(probabilities.get_kind(), ModelKind::PROBABILITY);
+    EXPECT_EQ(frozen_probabilities.size(), probabilities.size());
+    EXPECT_GT(frozen_probabilities.get_probability("th"), 0.0);
+    EXPECT_LT(frozen_probabilities.get_probability("th"), 1.0);
+    EXPECT_FALSE(probabilities.contains(""));
+    EXPECT_FALSE(probabilities.contains(" "));
+
+    const ModelBuilder unique_ngrams = loader.parse_model(Language::ENGLISH, 3, ModelKind::UNIQUE);
+    EXPECT_GT(unique_ngrams.size(), 0);
+    EXPECT_EQ(unique_ngrams.freeze().size(), unique_ngrams.size());
+    EXPECT_THROW(loader.parse_model(Language::ENGLISH, 6, ModelKind::PROBABILITY), std::invalid_argument);
+}
+
+TEST(ModelLoaderTest, ParallelParsing) {
+    auto& loader = lingua::ModelLoader::get_instance();
+
+    loader.set_thread_count(1);
+    const FrozenModel sequential = loader.compile_model(Language::ENGLISH, 5, ModelKind::PROBABILITY);
+    loader.set_thread_count(4);
+    const FrozenModel parallel = loader.compile_model(Language::ENGLISH, 5, ModelKind::PROBABILITY);
+    loader.set_thread_count(ThreadPool::default_thread_count());
+
+    EXPECT_GT(parallel.get_probability("there"), 0.0);
+    ASSERT_EQ(parallel.bytes().size(), sequential.bytes().size());
+    EXPECT_EQ(std::memcmp(parallel.bytes().data(), sequential.bytes().data(), sequential.bytes().size()), 0);
+}
+
+TEST(ModelLoaderTest, EmbeddedModels) {
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+    EXPECT_EQ(find_embedded_model(Language::ENGLISH, 6, ModelKind::PROBABILITY), nullptr);
+
+    // Only populated when built with -DLINGUA_EMBED_MODELS=ON
+    const EmbeddedModel* probability_model = nullptr;
+    for (const EmbeddedModel& embedded : embedded_models()) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(embedded.begin) % 8, 0);
+        const Language language = from_iso_code_639_1(embedded.iso_code);
+        EXPECT_EQ(find_embedded_model(language, embedded.ngram_length, embedded.kind), &embedded);
+        if (embedded.kind == ModelKind::PROBABILITY && probability_model == nullptr) {
+            probability_model = &embedded;
+        }
+    }
+    if (probability_model == nullptr) {
+        return;
+    }
+
+    // Embedded models are wrapped in place and do not depend on the working directory
+    const std::filesystem::path working_directory = std::filesystem::current_path();
+    std::filesystem::current_path(::testing::TempDir());
+    const auto model = loader.load_probability_model(
+        from_iso_code_639_1(probability_model->iso_code), probability_model->ngram_length);
+    std::filesystem::current_path(working_directory);
+    EXPECT_EQ(model->frozen_model().bytes().data(), probability_model->begin);
+    EXPECT_GT(model->size(), 0);
+    loader.clear_cache();
+}
+
+TEST(ModelLoaderTest, ModelBundleAndRoot) {
+    if (find_embedded_model(Language::WELSH, 1, ModelKind::PROBABILITY) != nullptr) {
+        GTEST_SKIP() << "Embedded models take precedence over bundles and model files";
+    }
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+
+    const std::string path = ::testing::TempDir() + "model_loader_bundle.lfb";
+    {
+        ModelBuilder builder(Language::WELSH, 1, ModelKind::PROBABILITY);
+        builder.set_probability("a", 0.5);
+        ModelBundleWriter writer(path);
+        writer.add(builder.freeze());
+        writer.finish();
+    }
+
+    // Models in the bundle are served from it, the others from their files
+    loader.set_model_bundle(path, ModelBundleAccess::PREAD);
+    ASSERT_NE(loader.get_model_bundle(), nullptr);
+    EXPECT_EQ(loader.load_probability_model(Language::WELSH, 1)->size(), 1);
+    EXPECT_GT(loader.load_probability_model(Language::WELSH, 2)->size(), 1);
+    loader.set_model_bundle("");
+    EXPECT_EQ(loader.get_model_bundle(), nullptr);
+    EXPECT_THROW(loader.set_model_bundle(path + ".missing"), ModelLoadException);
+    std::remove(path.c_str());
+    loader.clear_cache();
+
+    // Model files are resolved against the model root instead of the working directory
+    const std::string working_directory = std::filesystem::current_path().string();
+    loader.set_model_root(::testing::TempDir());
+    EXPECT_THROW(loader.load_probability_model(Language::WELSH, 1), std::exception);
+    loader.set_model_root(working_directory);
+    EXPECT_EQ(loader.get_model_root(), working_directory);
+    EXPECT_GT(loader.load_probability_model(Language::WELSH, 1)->size(), 1);
+    loader.set_model_root("");
+    loader.clear_cache();
+}
+
+TEST(ModelLoaderTest, PreloadModels) {
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+    loader.set_thread_count(2);
+    EXPECT_EQ(loader.get_thread_count(), 2);
+
+    std::vector<ModelPreloadProgress> progress;
+    const ModelPreloadReport report = loader.preload_models(
+        {Language::WELSH, Language::LATIN}, {1, 2}, [&progress](const ModelPreloadProgress& p) { progress.push_back(p); });
+    EXPECT_EQ(report.model_count, 12);
+    EXPECT_EQ(report.thread_count, 2);
+    ASSERT_EQ(progress.size(), 12);
+    EXPECT_EQ(progress.back().loaded_count, 12);
+    EXPECT_EQ(progress.back().total_count, 12);
+    EXPECT_GE(report.load_time.count(), 0);
+    EXPECT_GT(report.wall_time.count(), 0);
+
+    const ModelMemoryReport memory = loader.memory_report({Language::WELSH, Language::LATIN});
+    EXPECT_EQ(memory.models.size(), 12);
+    EXPECT_EQ(memory.total_bytes, report.bytes);
+
+    // A model root without models preloads none of the models that are not embedded, and reports them
+    loader.set_model_root(::testing::TempDir());
+    loader.clear_cache();
+    const ModelPreloadReport empty_root = loader.preload_models({Language::WELSH}, {1, 2});
+    EXPECT_EQ(empty_root.model_count + empty_root.missing_count, 6);
+    EXPECT_EQ(empty_root.model_count, loader.memory_report({Language::WELSH}).models.size());
+    loader.set_model_root("");
+    EXPECT_EQ(report.missing_count, 0);
+
+    EXPECT_THROW(loader.preload_models({Language::WELSH}, {6}), std::invalid_argument);
+    EXPECT_THROW(loader.set_thread_count(0), std::invalid_argument);
+    loader.set_thread_count(ThreadPool::default_thread_count());
+    loader.clear_cache();
+}
+
+TEST(ModelLoaderTest, Prefetch) {
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+    const uint64_t initial_load_count = loader.cache_stats().load_count;
+
+    std::future<ModelPreloadReport> prefetch = loader.prefetch({Language::GERMAN}, {3, 4}, {ModelKind::PROBABILITY});
+    ASSERT_EQ(prefetch.wait_for(std::chrono::minutes(1)), std::future_status::ready);
+    const ModelPreloadReport report = prefetch.get();
+    EXPECT_EQ(report.model_count, 2);
+    EXPECT_EQ(loader.memory_report({Language::GERMAN}).models.size(), 2);
+
+    // A load racing with the prefetch of the same model waits for it or finds it cached
+    prefetch = loader.prefetch({Language::GERMAN}, {3, 4, 5}, {ModelKind::PROBABILITY});
+    const auto fivegrams = loader.load_probability_model(Language::GERMAN, 5);
+    EXPECT_EQ(prefetch.get().model_count, 3);
+    EXPECT_EQ(loader.load_probability_model(Language::GERMAN, 5), fivegrams);
+    EXPECT_EQ(loader.cache_stats().load_count, initial_load_count + 3);
+
+    EXPECT_EQ(loader.prefetch({Language::GERMAN}, {}).wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    EXPECT_THROW(loader.prefetch({Language::GERMAN}, {0}), std::invalid_argument);
+    loader.clear_cache();
+}
+
+TEST(ModelLoaderTest, LoadStats) {
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+    loader.reset_load_stats();
+    EXPECT_EQ(loader.load_stats().load_count, 0);
+
+    const auto model = loader.load_probability_model(Language::GERMAN, 2);
+    loader.load_probability_model(Language::GERMAN, 2);
+    const ModelLoadStats stats = loader.load_stats();
+    ASSERT_EQ(stats.load_count, 1);
+    ASSERT_EQ(stats.loads.size(), 1);
+
+    const ModelLoadRecord& record = stats.loads[0];
+    EXPECT_EQ(record.language, Language::GERMAN);
+    EXPECT_EQ(record.ngram_length, 2);
+    EXPECT_EQ(record.kind, ModelKind::PROBABILITY);
+    EXPECT_EQ(record.ngram_count, model->size());
+    EXPECT_EQ(record.memory_bytes, model->memory_usage_bytes());
+    EXPECT_GT(record.file_bytes, 0);
+    EXPECT_GE(record.total_time, record.read_time + record.decompress_time + record.parse_time + record.freeze_time);
+    if (record.source == ModelSource::JSON_FILE) {
+        EXPECT_GT(record.decompressed_bytes, record.file_bytes);
+        EXPECT_GT(record.parse_time.count(), 0);
+    } else {
+        EXPECT_EQ(record.decompressed_bytes, 0);
+        EXPECT_EQ(record.parse_time.count(), 0);
+    }
+    EXPECT_EQ(stats.total_time, record.total_time);
+    EXPECT_EQ(to_string(ModelSource::BINARY_FILE), "binary");
+
+    // Only the most recent records are kept, but the totals count every load
+    ModelLoadStats capped;
+    for (size_t i = 0; i <= ModelLoadStats::MAX_RECORDS; ++i) {
+        ModelLoadRecord load = record;
+        load.ngram_count = i;
+        capped.add(load);
+    }
+    EXPECT_EQ(capped.load_count, ModelLoadStats::MAX_RECORDS + 1);
+    EXPECT_EQ(capped.loads.size(), ModelLoadStats::MAX_RECORDS);
+    EXPECT_EQ(capped.loads.front().ngram_count, 1);
+
+    loader.reset_load_stats();
+    loader.clear_cache();
+}
+
+TEST(ModelLoaderTest, HotReloadAndUnload) {
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+    const ModelCacheStats initial = loader.cache_stats();
+
+    const auto old_version = loader.load_probability_model(Language::GERMAN, 2);
+    const ModelPreloadReport report = loader.reload_models({Language::GERMAN, Language::FRENCH}).get();
+    EXPECT_EQ(report.model_count, 1);
+    const auto new_version = loader.load_probability_model(Language::GERMAN, 2);
+    EXPECT_NE(new_version, old_version);
+    EXPECT_EQ(new_version->size(), old_version->size());
+    EXPECT_EQ(loader.cache_stats().replace_count, initial.replace_count + 1);
+
+    // Readers keep working while models are swapped and dropped under them
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> lookups{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back([&] {
+            while (!stop.load()) {
+                const auto model = loader.load_probability_model(Language::GERMAN, 2);
+                EXPECT_EQ(model->size(), old_version->size());
+                ++lookups;
+            }
+        });
+    }
+    for (int i = 0; i < 3; ++i) {
+        loader.reload_models({Language::GERMAN}).get();
+        loader.unload_models({Language::GERMAN});
+        loader.load_probability_model(Language::GERMAN, 2);
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_GT(lookups.load(), 0);
+
+    EXPECT_GT(loader.unload_models({Language::GERMAN}), 0);
+    EXPECT_TRUE(loader.memory_report({Language::GERMAN}).models.empty());
+    EXPECT_EQ(old_version->size(), new_version->size());
+
+    // A detector unloads the models of its own languages only
+    loader.load_probability_model(Language::GERMAN, 1);
+    loader.load_probability_model(Language::FRENCH, 1);
+    auto detector = LanguageDetectorBuilder::from_languages({Language::GERMAN, Language::ENGLISH}).build();
+    detector.unload_language_models();
+    EXPECT_TRUE(loader.memory_report({Language::GERMAN}).models.empty());
+    EXPECT_EQ(loader.memory_report({Language::FRENCH}).models.size(), 1);
+    loader.clear_cache();
+}
+
+TEST(ModelLoaderTest, SharedModelStore) {
+    auto& loader = lingua::ModelLoader::get_instance();
+    const std::string directory = ::testing::TempDir() + "lingua_shared_models";
+    std::filesystem::remove_all(directory);
+    loader.clear_cache();
+    loader.reset_load_stats();
+
+    const auto store = loader.set_shared_model_store({Language::WELSH}, directory);
+    EXPECT_TRUE(store->was_built());
+    EXPECT_EQ(loader.get_shared_model_store(), store);
+    EXPECT_EQ(loader.get_model_bundle(), store->bundle());
+    EXPECT_EQ(store->path().find(directory), 0);
+    EXPECT_FALSE(store->bundle()->entries().empty());
+
+    // Another process with the same models and settings finds the same version
+    const auto same = loader.set_shared_model_store({Language::WELSH}, directory);
+    EXPECT_FALSE(same->was_built());
+    EXPECT_EQ(same->path(), store->path());
+
+    const auto model = loader.load_probability_model(Language::WELSH, 2);
+    if (!find_embedded_model(Language::WELSH, 2, ModelKind::PROBABILITY)) {
+        EXPECT_EQ(loader.load_stats().loads.back().source, ModelSource::BUNDLE);
+    }
+
+    // A different setting is a different version
+    loader.set_count_model_false_positive_rate(1e-4);
+    const auto other = loader.set_shared_model_store({Language::WELSH}, directory);
+    EXPECT_NE(other->path(), store->path());
+    loader.set_count_model_false_positive_rate(ModelLoader::DEFAULT_COUNT_MODEL_FALSE_POSITIVE_RATE);
+
+    loader.set_model_bundle("");
+    EXPECT_EQ(loader.get_shared_model_store(), nullptr);
+    loader.clear_cache();
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ModelLoaderTest, NumaReplication) {
+    auto& loader = lingua::ModelLoader::get_instance();
+    const std::string directory = ::testing::TempDir() + "lingua_numa_nodes";
+    std::filesystem::remove_all(directory);
+    for (const auto& [node, cpus] : {std::pair{"node0", "0-1\n"}, std::pair{"node1", "2,3\n"}}) {
+        std::filesystem::create_directories(directory + "/" + node);
+        std::ofstream(directory + "/" + node + "/cpulist") << cpus;
+    }
+    const auto topology = std::make_shared<const NumaTopology>(NumaTopology::detect(directory));
+    ASSERT_EQ(topology->node_count(), 2);
+    loader.clear_cache();
+
+    // Binding to a node the host does not have fails harmlessly; the replica is still a copy
+    loader.set_numa_replication(size_t{1} << 30, topology);
+    EXPECT_EQ(loader.get_numa_replication_budget(), size_t{1} << 30);
+    auto replicated = loader.load_probability_model(Language::WELSH, 2);
+    ASSERT_EQ(replicated->replica_count(), 2);
+    const FrozenModel& frozen = replicated->frozen_model();
+    EXPECT_EQ(loader.numa_replica_bytes(), frozen.bytes().size());
+    EXPECT_GE(replicated->memory_usage_bytes(), 2 * frozen.bytes().size());
+    for (size_t i = 0; i < frozen.size(); i += 97) {
+        EXPECT_DOUBLE_EQ(replicated->get_probability(frozen.ngram_at(i)), frozen.probability_at(i));
+    }
+
+    // Replicas that do not fit the budget leave a single copy
+    loader.clear_cache();
+    loader.set_numa_replication(frozen.bytes().size() / 2, topology);
+    const auto single = loader.load_probability_model(Language::WELSH, 2);
+    EXPECT_EQ(single->replica_count(), 1);
+
+    replicated.reset();
+    EXPECT_EQ(loader.numa_replica_bytes(), 0);
+    loader.set_numa_replication(0);
+    loader.clear_cache();
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ThreadPoolTest, RunsTasksAndPropagatesExceptions) {
+    ThreadPool pool(3);
+    EXPECT_EQ(pool.thread_count(), 3);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i) {
+        results.push_back(pool.submit([i] { return i * i; }));
+    }
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(results[i].get(), i * i);
+    }
+    auto failing = pool.submit([]() -> int { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(failing.get(), std::runtime_error);
+    EXPECT_THROW(ThreadPool(0), std::invalid_argument);
+}
+
+TEST(ThreadPoolTest, ParallelFor) {
+    ThreadPool pool(2);
+    std::vector<int> squares(100);
+    pool.parallel_for(squares.size(), [&](size_t i) { squares[i] = static_cast<int>(i * i); });
+    for (size_t i = 0; i < squares.size(); ++i) {
+        EXPECT_EQ(squares[i], static_cast<int>(i * i));
+    }
+    EXPECT_THROW(pool.parallel_for(10, [](size_t i) {
+        if (i == 7) {
+            throw std::runtime_error("iteration failed");
+        }
+    }), std::runtime_error);
+    EXPECT_NO_THROW(pool.parallel_for(0, [](size_t) { FAIL(); }));
+
+    // A task of a single-thread pool runs every iteration itself instead of waiting
+    ThreadPool single(1);
+    std::atomic<int> count{0};
+    single.submit([&] { single.parallel_for(8, [&](size_t) { ++count; }); }).get();
+    EXPECT_EQ(count.load(), 8);
+}
+
+namespace {
+    struct TestModel {
+        int value;
+
+        size_t memory_usage_bytes() const {
+            return sizeof(TestModel);
+        }
+    };
+}
+
+TEST(ModelRegistryTest, SingleFlightLoading) {
+    ModelRegistry<TestModel> registry(4);
+    EXPECT_EQ(registry.find(2), nullptr);
+
+    // Every thread misses the same slot while the first load is still running
+    std::atomic<int> load_count{0};
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::vector<std::future<std::shared_ptr<const TestModel>>> results;
+    for (int i = 0; i < 8; ++i) {
+        results.push_back(std::async(std::launch::async, [&] {
+            return registry.get_or_load(2, [&] {
+                ++load_count;
+                released.wait();
+                return std::make_shared<const TestModel>(TestModel{42});
+            });
+        }));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    release.set_value();
+    std::shared_ptr<const TestModel> first = results.front().get();
+    for (size_t i = 1; i < results.size(); ++i) {
+        EXPECT_EQ(results[i].get(), first);
+    }
+    EXPECT_EQ(load_count.load(), 1);
+    EXPECT_EQ(registry.find(2), first);
+    EXPECT_EQ(registry.get_or_load(2, [] { return std::make_shared<const TestModel>(TestModel{0}); }), first);
+
+    // A failed load is not cached, so the next miss retries
+    EXPECT_THROW(registry.get_or_load(3, []() -> std::shared_ptr<const TestModel> {
+        throw std::runtime_error("load failed");
+    }), std::runtime_error);
+    EXPECT_EQ(registry.find(3), nullptr);
+    EXPECT_EQ(registry.get_or_load(3, [] { return std::make_shared<const TestModel>(TestModel{7}); })->value, 7);
+
+    EXPECT_EQ(registry.stats().load_count, 2u);
+    EXPECT_EQ(registry.resident_bytes(), 2 * sizeof(TestModel));
+
+    registry.clear();
+    EXPECT_EQ(registry.find(2), nullptr);
+    EXPECT_EQ(registry.find(3), nullptr);
+}
+
+TEST(ModelRegistryTest, EvictionAndPinning) {
+    ModelRegistry<TestModel> registry(4);
+    for (size_t slot = 0; slot < 3; ++slot) {
+        registry.get_or_load(slot, [&] { return std::make_shared<const TestModel>(TestModel{static_cast<int>(slot)}); });
+    }
+    registry.pin(1);
+    registry.find(0);
+
+    // Slot 0 was loaded first but looked up after slot 2 was loaded, so both were last used then
+    std::vector<EvictableModel> models;
+    registry.evictable_models(models);
+    ASSERT_EQ(models.size(), 2u);
+    EXPECT_EQ(models[0].slot, 0u);
+    EXPECT_EQ(models[1].slot, 2u);
+    EXPECT_EQ(models[0].last_used, models[1].last_used);
+    EXPECT_EQ(models[0].bytes, sizeof(TestModel));
+
+    EXPECT_EQ(registry.evict(1), 0u);
+    EXPECT_EQ(registry.evict(2), sizeof(TestModel));
+    EXPECT_EQ(registry.evict(3), 0u);
+    EXPECT_EQ(registry.find(2), nullptr);
+    EXPECT_EQ(registry.get_or_load(2, [] { return std::make_shared<const TestModel>(TestModel{2}); })->value, 2);
+
+    ModelCacheStats stats = registry.stats();
+    EXPECT_EQ(stats.model_count, 3u);
+    EXPECT_EQ(stats.pinned_count, 1u);
+    EXPECT_EQ(stats.load_count, 4u);
+    EXPECT_EQ(stats.reload_count, 1u);
+    EXPECT_EQ(stats.eviction_count, 1u);
+
+    EXPECT_TRUE(registry.unpin(1));
+    EXPECT_FALSE(registry.unpin(1));
+    EXPECT_EQ(registry.evict(1), sizeof(TestModel));
+}
+
+TEST(ModelRegistryTest, ReplaceAndRemove) {
+    ModelRegistry<TestModel> registry(2);
+    EXPECT_FALSE(registry.replace(0, std::make_shared<const TestModel>(TestModel{1})));
+    EXPECT_EQ(registry.find(0), nullptr);
+
+    const auto old_version = registry.get_or_load(0, [] { return std::make_shared<const TestModel>(TestModel{1}); });
+    EXPECT_TRUE(registry.replace(0, std::make_shared<const TestModel>(TestModel{2})));
+    EXPECT_EQ(registry.find(0)->value, 2);
+    EXPECT_EQ(old_version->value, 1);
+    EXPECT_EQ(registry.resident_bytes(), sizeof(TestModel));
+
+    registry.pin(0);
+    EXPECT_EQ(registry.remove(0), 0u);
+    registry.unpin(0);
+    EXPECT_EQ(registry.remove(0), sizeof(TestModel));
+    EXPECT_EQ(registry.find(0), nullptr);
+    EXPECT_EQ(registry.resident_bytes(), 0u);
+
+    const ModelCacheStats stats = registry.stats();
+    EXPECT_EQ(stats.replace_count, 1u);
+    EXPECT_EQ(stats.eviction_count, 0u);
+}
+
+TEST(ModelRegistryTest, RemoveDuringLoad) {
+    ModelRegistry<TestModel> registry(2);
+    std::promise<void> started;
+    std::promise<void> release;
+    auto loading = std::async(std::launch::async, [&] {
+        return registry.get_or_load(0, [&] {
+            started.set_value();
+            release.get_future().wait();
+            return std::make_shared<const TestModel>(TestModel{1});
+        });
+    });
+    started.get_future().wait();
+
+    // The unload cancels the load in flight: its caller still gets the model, but the slot stays empty
+    EXPECT_EQ(registry.remove(0), 0u);
+    release.set_value();
+    EXPECT_EQ(loading.get()->value, 1);
+    EXPECT_EQ(registry.find(0), nullptr);
+    EXPECT_EQ(registry.resident_bytes(), 0u);
+    EXPECT_EQ(registry.stats().model_count, 0u);
+
+    // The next miss loads the slot again
+    EXPECT_EQ(registry.get_or_load(0, [] { return std::make_shared<const TestModel>(TestModel{2}); })->value, 2);
+    EXPECT_EQ(registry.resident_bytes(), sizeof(TestModel));
+}
+
+TEST(ModelLoaderTest, MemoryBudget) {
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+    const ModelCacheStats initial = loader.cache_stats();
+    EXPECT_EQ(initial.memory_budget, 0u);
+    EXPECT_EQ(initial.resident_bytes, 0u);
+
+    const auto unigrams = loader.load_probability_model(Language::GERMAN, 1);
+    const auto bigrams = loader.load_probability_model(Language::GERMAN, 2);
+    const size_t budget = loader.cache_stats().resident_bytes;
+    EXPECT_EQ(budget, unigrams->memory_usage_bytes() + bigrams->memory_usage_bytes());
+    loader.set_memory_budget(budget);
+    EXPECT_EQ(loader.get_memory_budget(), budget);
+
+    // The most common unigrams take the cache over the budget and the least recently used bigrams go
+    loader.load_probability_model(Language::GERMAN, 1);
+    loader.load_count_model(Language::GERMAN, 1, NgramModelType::MOST_COMMON);
+    ModelCacheStats stats = loader.cache_stats();
+    EXPECT_LE(stats.resident_bytes, budget);
+    EXPECT_EQ(stats.eviction_count, initial.eviction_count + 1);
+    EXPECT_EQ(stats.model_count, 2u);
+
+    // Evicted models are loaded again on their next use
+    const auto reloaded = loader.load_probability_model(Language::GERMAN, 2);
+    EXPECT_NE(reloaded, bigrams);
+    EXPECT_EQ(reloaded->size(), bigrams->size());
+    EXPECT_EQ(loader.cache_stats().reload_count, initial.reload_count + 1);
+
+    // Pinned models stay, even over the budget
+    loader.pin_model(Language::GERMAN, 1, ModelKind::PROBABILITY);
+    loader.load_probability_model(Language::GERMAN, 1);
+    loader.set_memory_budget(1);
+    const ModelMemoryReport report = loader.memory_report({Language::GERMAN});
+    ASSERT_EQ(report.models.size(), 1u);
+    EXPECT_EQ(report.models[0].ngram_length, 1u);
+    EXPECT_EQ(report.models[0].model_type, "probability");
+    EXPECT_EQ(loader.cache_stats().pinned_count, 1u);
+
+    EXPECT_TRUE(loader.unpin_model(Language::GERMAN, 1, ModelKind::PROBABILITY));
+    EXPECT_FALSE(loader.unpin_model(Language::GERMAN, 1, ModelKind::PROBABILITY));
+    EXPECT_THROW(loader.pin_model(Language::GERMAN, 6, ModelKind::PROBABILITY), std::invalid_argument);
+    loader.set_memory_budget(0);
+    loader.clear_cache();
+}
+
+TEST(ModelLoaderTest, ConcurrentLoading) {
+    auto& loader = lingua::ModelLoader::get_instance();
+    loader.clear_cache();
+
+    std::vector<std::future<std::shared_ptr<const NgramProbabilityModel>>> results;
+    for (int i = 0; i < 4; ++i) {
+        results.push_back(std::async(std::launch::async, [&] {
+            return loader.load_probability_model(Language::GERMAN, 3);
+        }));
+    }
+    const auto model = results.front().get();
+    for (size_t i = 1; i < results.size(); ++i) {
+        EXPECT_EQ(results[i].get(), model);
+    }
+    EXPECT_EQ(loader.load_probability_model(Language::GERMAN, 3), model);
+    loader.clear_cache();
+}
+
 // Additional tests for model loader validation
 TEST(ModelLoaderTest, Validation) {
     auto& loader = lingua::ModelLoader::get_instance();
@@ -980,72 +1859,477 @@ TEST(ModelTest, NgramModelTypeToString) {
 }
 
 TEST(ModelTest, NgramProbabilityModel) {
-    // Test constructor
-    NgramProbabilityModel model(Language::ENGLISH);
+    ModelBuilder builder(Language::ENGLISH, 4, ModelKind::PROBABILITY);
+    EXPECT_EQ(builder.get_language(), Language::ENGLISH);
+    EXPECT_EQ(builder.size(), 0);
+
+    // Test adding and updating probabilities
+    builder.set_probability("test", 0.5);
+    builder.set_probability("test", 0.75);
+    builder.set_probability("hello", 0.25);
+    builder.set_probability("wörld", 0.25);
+    EXPECT_EQ(builder.size(), 3);
+    EXPECT_TRUE(builder.contains("test"));
+    EXPECT_THROW(builder.add_ngram("none"), std::logic_error);
+    EXPECT_THROW(builder.freeze_fingerprints(32), std::logic_error);
+
+    NgramProbabilityModel model(builder.freeze());
     EXPECT_EQ(model.get_language(), Language::ENGLISH);
-    EXPECT_EQ(model.size(), 0);
-    
-    // Test adding and getting probabilities
-    Ngram ngram1("test");
-    model.set_probability(ngram1, 0.5);
-    EXPECT_EQ(model.size(), 1);
-    EXPECT_DOUBLE_EQ(model.get_probability(ngram1), 0.5);
-    EXPECT_TRUE(model.contains(ngram1));
-    
-    // Test updating probability
-    model.set_probability(ngram1, 0.75);
-    EXPECT_DOUBLE_EQ(model.get_probability(ngram1), 0.75);
-    
+    EXPECT_EQ(model.size(), 3);
+    EXPECT_DOUBLE_EQ(model.get_probability(Ngram("test")), 0.75);
+    EXPECT_DOUBLE_EQ(model.get_probability("hello"), 0.25);
+    EXPECT_DOUBLE_EQ(model.get_probability("wörld"), 0.25);
+    EXPECT_TRUE(model.contains(Ngram("test")));
+
     // Test non-existent n-gram
-    Ngram ngram2("none");
-    EXPECT_DOUBLE_EQ(model.get_probability(ngram2), 0.0);
-    EXPECT_FALSE(model.contains(ngram2));
-    
-    // Test multiple n-grams
-    Ngram ngram3("hello");
-    model.set_probability(ngram3, 0.25);
-    EXPECT_EQ(model.size(), 2);
-    EXPECT_DOUBLE_EQ(model.get_probability(ngram3), 0.25);
-    EXPECT_TRUE(model.contains(ngram3));
+    EXPECT_DOUBLE_EQ(model.get_probability(Ngram("none")), 0.0);
+    EXPECT_FALSE(model.contains(Ngram("none")));
+
+    // Frozen entries are sorted and the builder is unaffected by freezing
+    const FrozenModel& frozen = model.frozen_model();
+    EXPECT_EQ(frozen.get_ngram_length(), 4);
+    EXPECT_EQ(frozen.ngram_at(0), "hello");
+    EXPECT_DOUBLE_EQ(frozen.probability_at(0), 0.25);
+    EXPECT_EQ(frozen.ngram_at(2), "wörld");
+    builder.set_probability("more", 0.1);
+    EXPECT_EQ(model.size(), 3);
+    EXPECT_THROW(NgramCountModel{frozen}, std::invalid_argument);
+    EXPECT_THROW(ModelBuilder(Language::ENGLISH, 6, ModelKind::PROBABILITY), std::invalid_argument);
 }
 
 TEST(ModelTest, NgramCountModel) {
-    // Test constructor
-    NgramCountModel model(Language::SPANISH, NgramModelType::UNIQUE);
+    ModelBuilder builder(Language::SPANISH, 5, ModelKind::UNIQUE);
+
+    // Test adding, duplicate and removing n-grams
+    builder.add_ngram("test");
+    builder.add_ngram("test");
+    EXPECT_EQ(builder.size(), 1);
+    EXPECT_TRUE(builder.remove_ngram("test"));
+    EXPECT_FALSE(builder.remove_ngram("none"));
+    EXPECT_EQ(builder.size(), 0);
+    EXPECT_THROW(builder.set_probability("test", 0.5), std::logic_error);
+
+    NgramCountModel empty(builder.freeze());
+    EXPECT_EQ(empty.size(), 0);
+    EXPECT_FALSE(empty.contains("test"));
+
+    builder.add_ngram("hello");
+    builder.add_ngram("world");
+    NgramCountModel model(builder.freeze());
     EXPECT_EQ(model.get_language(), Language::SPANISH);
     EXPECT_EQ(model.get_model_type(), NgramModelType::UNIQUE);
-    EXPECT_EQ(model.size(), 0);
-    
-    // Test adding n-grams
-    Ngram ngram1("test");
-    model.add_ngram(ngram1);
-    EXPECT_EQ(model.size(), 1);
-    EXPECT_TRUE(model.contains(ngram1));
-    
-    // Test adding duplicate n-gram (should not increase size)
-    model.add_ngram(ngram1);
-    EXPECT_EQ(model.size(), 1);
-    
-    // Test non-existent n-gram
-    Ngram ngram2("none");
-    EXPECT_FALSE(model.contains(ngram2));
-    
-    // Test removing n-gram
-    EXPECT_TRUE(model.remove_ngram(ngram1));
-    EXPECT_EQ(model.size(), 0);
-    EXPECT_FALSE(model.contains(ngram1));
-    
-    // Test removing non-existent n-gram
-    EXPECT_FALSE(model.remove_ngram(ngram2));
-    
-    // Test multiple n-grams
-    Ngram ngram3("hello");
-    Ngram ngram4("world");
-    model.add_ngram(ngram3);
-    model.add_ngram(ngram4);
+    EXPECT_FALSE(model.is_compact());
+    EXPECT_DOUBLE_EQ(model.false_positive_rate(), 0.0);
     EXPECT_EQ(model.size(), 2);
-    EXPECT_TRUE(model.contains(ngram3));
-    EXPECT_TRUE(model.contains(ngram4));
+    EXPECT_TRUE(model.contains(Ngram("hello")));
+    EXPECT_TRUE(model.contains("world"));
+    EXPECT_FALSE(model.contains("test"));
+    EXPECT_THROW(NgramProbabilityModel{model.frozen_model()}, std::invalid_argument);
+}
+
+TEST(ModelTest, FrozenModelRoundTrip) {
+    ModelBuilder builder(Language::GERMAN, 3, ModelKind::PROBABILITY);
+    for (int i = 0; i < 70000; ++i) {
+        builder.set_probability(numbered("n", i), 1.0 / (i + 1));
+    }
+    const FrozenModel frozen = builder.freeze();
+
+    const std::string path = ::testing::TempDir() + "frozen_model_round_trip.bin";
+    frozen.write_to(path);
+    const FrozenModel read = FrozenModel::read_from(path);
+    const FrozenModel mapped = FrozenModel::map_from(path);
+    const FrozenModel populated = FrozenModel::map_from(path, {true, MappingAdvice::RANDOM, true});
+    std::remove(path.c_str());
+    EXPECT_DOUBLE_EQ(mapped.get_probability("n41"), 1.0 / 42);
+    EXPECT_DOUBLE_EQ(populated.get_probability("n42"), 1.0 / 43);
+    EXPECT_EQ(mapped.size(), 70000);
+    EXPECT_EQ(read.get_language(), Language::GERMAN);
+    EXPECT_EQ(read.get_ngram_length(), 3);
+    EXPECT_EQ(read.get_kind(), ModelKind::PROBABILITY);
+    EXPECT_EQ(read.size(), 70000);
+    EXPECT_DOUBLE_EQ(read.get_probability("n0"), 1.0);
+    EXPECT_DOUBLE_EQ(read.get_probability("n69999"), 1.0 / 70000);
+    EXPECT_DOUBLE_EQ(read.get_probability("n70000"), 0.0);
+
+    // Blocks can be wrapped in place without copying
+    const FrozenModel view = FrozenModel::from_bytes(frozen.bytes(), nullptr);
+    EXPECT_EQ(view.bytes().data(), frozen.bytes().data());
+    EXPECT_DOUBLE_EQ(view.get_probability("n41"), 1.0 / 42);
+
+    ModelBuilder set(Language::FRENCH, 2, ModelKind::MOST_COMMON);
+    set.add_ngram("le");
+    const FrozenModel compact = set.freeze_fingerprints(40);
+    const FrozenModel fingerprints = FrozenModel::from_bytes(compact.bytes(), nullptr);
+    EXPECT_EQ(fingerprints.get_layout(), FrozenModelLayout::FINGERPRINTS);
+    EXPECT_TRUE(fingerprints.contains("le"));
+    EXPECT_FALSE(fingerprints.contains("la"));
+}
+
+TEST(ModelTest, FreezeMergesPartialBuilders) {
+    ModelBuilder whole(Language::GERMAN, 3, ModelKind::PROBABILITY);
+    std::vector<ModelBuilder> parts;
+    for (int part = 0; part < 3; ++part) {
+        parts.emplace_back(Language::GERMAN, 3, ModelKind::PROBABILITY);
+        for (int i = part * 1000; i < part * 1000 + 1500; ++i) {
+            // Parts overlap by 500 n-grams; the later part wins as in a single builder
+            const double probability = 1.0 / (i + part + 1);
+            parts.back().set_probability(numbered("n", i), probability);
+            whole.set_probability(numbered("n", i), probability);
+        }
+    }
+    parts.emplace_back(Language::GERMAN, 3, ModelKind::PROBABILITY);
+
+    const FrozenModel expected = whole.freeze();
+    ThreadPool pool(2);
+    for (ThreadPool* sorting_pool : {static_cast<ThreadPool*>(nullptr), &pool}) {
+        const FrozenModel merged = ModelBuilder::freeze(parts, sorting_pool);
+        EXPECT_EQ(merged.size(), 3500);
+        EXPECT_DOUBLE_EQ(merged.get_probability("n1200"), 1.0 / 1202);
+        ASSERT_EQ(merged.bytes().size(), expected.bytes().size());
+        EXPECT_EQ(std::memcmp(merged.bytes().data(), expected.bytes().data(), expected.bytes().size()), 0);
+    }
+
+    EXPECT_THROW(ModelBuilder::freeze(std::span<const ModelBuilder>()), std::invalid_argument);
+    parts.emplace_back(Language::GERMAN, 2, ModelKind::PROBABILITY);
+    EXPECT_THROW(ModelBuilder::freeze(parts), std::invalid_argument);
+}
+
+TEST(ModelTest, HugePagePolicy) {
+    // Small regions cannot hold a huge page and stay on the heap
+    const auto small = ModelMemory::allocate(100, PagePolicy::HUGE_PAGES);
+    EXPECT_EQ(small->bytes().size(), 100);
+    EXPECT_FALSE(small->uses_huge_pages());
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small->bytes().data()) % 8, 0);
+
+    const auto large = ModelMemory::allocate(3 * ModelMemory::HUGE_PAGE_SIZE + 5, PagePolicy::HUGE_PAGES);
+    const std::span<std::byte> bytes = large->bytes();
+    ASSERT_EQ(bytes.size(), 3 * ModelMemory::HUGE_PAGE_SIZE + 5);
+    EXPECT_TRUE(std::all_of(bytes.begin(), bytes.end(), [](std::byte byte) { return byte == std::byte{0}; }));
+    bytes.back() = std::byte{1};
+#ifndef _WIN32
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(bytes.data()) % ModelMemory::HUGE_PAGE_SIZE, 0);
+#endif
+
+    // The policy changes where a block lives, never its contents
+    ModelBuilder builder(Language::GERMAN, 3, ModelKind::PROBABILITY);
+    for (int i = 0; i < 150000; ++i) {
+        builder.set_probability(numbered("n", i), 1.0 / (i + 1));
+    }
+    const FrozenModel expected = builder.freeze();
+    const FrozenModel huge = builder.freeze(PagePolicy::HUGE_PAGES);
+    ASSERT_GE(expected.bytes().size(), ModelMemory::HUGE_PAGE_SIZE);
+    ASSERT_EQ(huge.bytes().size(), expected.bytes().size());
+    EXPECT_EQ(std::memcmp(huge.bytes().data(), expected.bytes().data(), expected.bytes().size()), 0);
+    EXPECT_DOUBLE_EQ(huge.get_probability("n41"), 1.0 / 42);
+
+    const std::string path = ::testing::TempDir() + "huge_page_model.bin";
+    expected.write_to(path);
+    const FrozenModel read = FrozenModel::read_from(path, PagePolicy::HUGE_PAGES);
+    MappingOptions options;
+    options.pages = PagePolicy::HUGE_PAGES;
+    const FrozenModel mapped = FrozenModel::map_from(path, options);
+    options.populate = true;
+    const FrozenModel populated = FrozenModel::map_from(path, options);
+    std::remove(path.c_str());
+    for (const FrozenModel* model : {&read, &mapped, &populated}) {
+        ASSERT_EQ(model->bytes().size(), expected.bytes().size());
+        EXPECT_EQ(std::memcmp(model->bytes().data(), expected.bytes().data(), expected.bytes().size()), 0);
+#ifndef _WIN32
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(model->bytes().data()) % ModelMemory::HUGE_PAGE_SIZE, 0);
+#endif
+    }
+
+    auto& loader = ModelLoader::get_instance();
+    loader.clear_cache();
+    loader.set_page_policy(PagePolicy::HUGE_PAGES);
+    EXPECT_EQ(loader.get_page_policy(), PagePolicy::HUGE_PAGES);
+    EXPECT_GT(loader.load_probability_model(Language::GERMAN, 3)->get_probability("der"), 0.0);
+    loader.set_page_policy(PagePolicy::DEFAULT);
+    loader.clear_cache();
+}
+
+TEST(ModelTest, NumaTopology) {
+    EXPECT_EQ(NumaTopology::parse_cpu_list("0-3,8,10-11\n"), (std::vector<unsigned>{0, 1, 2, 3, 8, 10, 11}));
+    EXPECT_TRUE(NumaTopology::parse_cpu_list("").empty());
+    EXPECT_THROW(NumaTopology::parse_cpu_list("3-1"), std::invalid_argument);
+    EXPECT_THROW(NumaTopology::parse_cpu_list("0,a"), std::invalid_argument);
+
+    // Memory-only nodes and other entries are skipped
+    const std::string directory = ::testing::TempDir() + "lingua_numa_topology";
+    std::filesystem::remove_all(directory);
+    for (const auto& [node, cpus] : {std::pair{"node2", "4-5\n"}, std::pair{"node0", "0-1\n"}, std::pair{"node1", "\n"}}) {
+        std::filesystem::create_directories(directory + "/" + node);
+        std::ofstream(directory + "/" + node + "/cpulist") << cpus;
+    }
+    std::ofstream(directory + "/possible") << "0-2\n";
+    const NumaTopology topology = NumaTopology::detect(directory);
+    ASSERT_EQ(topology.node_count(), 2);
+    EXPECT_EQ(topology.kernel_node_id(0), 0);
+    EXPECT_EQ(topology.kernel_node_id(1), 2);
+    EXPECT_EQ(topology.node_cpus(1), (std::vector<unsigned>{4, 5}));
+    EXPECT_EQ(topology.node_of_cpu(5), 1);
+    EXPECT_EQ(topology.node_of_cpu(1), 0);
+    EXPECT_EQ(topology.node_of_cpu(64), 0);
+    EXPECT_LT(topology.current_node(), 2);
+    EXPECT_EQ(NumaTopology::detect(directory + "/missing").node_count(), 1);
+    EXPECT_GE(NumaTopology::system()->node_count(), 1);
+
+    ModelBuilder builder(Language::ENGLISH, 2, ModelKind::PROBABILITY);
+    builder.set_probability("ab", 0.25);
+    builder.set_probability("cd", 0.5);
+    const FrozenModel model = builder.freeze();
+    const auto replicas = replicate_model(model, topology);
+    ASSERT_EQ(replicas.size(), 2);
+    for (const FrozenModel& replica : replicas) {
+        EXPECT_NE(replica.bytes().data(), model.bytes().data());
+        EXPECT_DOUBLE_EQ(replica.get_probability("cd"), 0.5);
+    }
+    const auto shared_topology = std::make_shared<const NumaTopology>(topology);
+    const NgramProbabilityModel replicated(replicas, shared_topology);
+    EXPECT_EQ(replicated.replica_count(), 2);
+    EXPECT_DOUBLE_EQ(replicated.get_probability("ab"), 0.25);
+    EXPECT_THROW(NgramProbabilityModel({model}, shared_topology), std::invalid_argument);
+    EXPECT_THROW(NgramCountModel(replicas, shared_topology), std::invalid_argument);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ModelTest, ModelBundle) {
+    const std::string path = ::testing::TempDir() + "model_bundle.lfb";
+    ModelBuilder probabilities(Language::WELSH, 1, ModelKind::PROBABILITY);
+    probabilities.set_probability("a", 0.5);
+    probabilities.set_probability("b", 0.25);
+    ModelBuilder unique(Language::FRENCH, 3, ModelKind::UNIQUE);
+    unique.add_ngram("les");
+    {
+        ModelBundleWriter writer(path);
+        writer.add(probabilities.freeze());
+        writer.add(unique.freeze_fingerprints(40));
+        EXPECT_THROW(writer.add(probabilities.freeze()), std::invalid_argument);
+        EXPECT_EQ(writer.size(), 2);
+        writer.finish();
+    }
+
+    for (ModelBundleAccess access : {ModelBundleAccess::MEMORY_MAP, ModelBundleAccess::PREAD}) {
+        const auto bundle = ModelBundle::open(path, access);
+        EXPECT_EQ(bundle->access(), access);
+        ASSERT_EQ(bundle->entries().size(), 2);
+        EXPECT_EQ(bundle->find(Language::WELSH, 2, ModelKind::PROBABILITY), nullptr);
+        const ModelBundleEntry* entry = bundle->find(Language::WELSH, 1, ModelKind::PROBABILITY);
+        ASSERT_NE(entry, nullptr);
+        EXPECT_EQ(entry->offset % 8, 0);
+        EXPECT_DOUBLE_EQ(bundle->load(*entry).get_probability("a"), 0.5);
+        EXPECT_TRUE(bundle->load(*bundle->find(Language::FRENCH, 3, ModelKind::UNIQUE)).contains("les"));
+    }
+
+    // A flipped byte in a model fails its checksum
+    const uint64_t last_byte = [&] {
+        const auto bundle = ModelBundle::open(path, ModelBundleAccess::PREAD);
+        const ModelBundleEntry* entry = bundle->find(Language::WELSH, 1, ModelKind::PROBABILITY);
+        return entry->offset + entry->size - 1;
+    }();
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(static_cast<std::streamoff>(last_byte));
+        file.put('\x7f');
+    }
+    const auto corrupted = ModelBundle::open(path, ModelBundleAccess::PREAD);
+    const ModelBundleEntry* entry = corrupted->find(Language::WELSH, 1, ModelKind::PROBABILITY);
+    EXPECT_THROW(corrupted->load(*entry), ModelLoadException);
+    EXPECT_NO_THROW(corrupted->load(*entry, false));
+
+    // A frozen model is not a bundle
+    probabilities.freeze().write_to(path);
+    EXPECT_THROW(ModelBundle::open(path), ModelLoadException);
+    std::remove(path.c_str());
+}
+
+TEST(ModelTest, SharedModelStore) {
+    const std::string directory = ::testing::TempDir() + "shared_model_store";
+    std::filesystem::remove_all(directory);
+    size_t build_count = 0;
+    const auto build = [&](ModelBundleWriter& writer) {
+        ++build_count;
+        ModelBuilder builder(Language::WELSH, 1, ModelKind::PROBABILITY);
+        builder.set_probability("a", 0.5);
+        writer.add(builder.freeze());
+    };
+
+    // The first store builds and publishes; the second maps what was published
+    auto first = SharedModelStore::open(directory, "test-v1.lfb", build);
+    auto second = SharedModelStore::open(directory, "test-v1.lfb", build);
+    EXPECT_TRUE(first->was_built());
+    EXPECT_FALSE(second->was_built());
+    EXPECT_EQ(build_count, 1);
+    EXPECT_EQ(first->path(), second->path());
+    const ModelBundleEntry* entry = second->bundle()->find(Language::WELSH, 1, ModelKind::PROBABILITY);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_DOUBLE_EQ(second->bundle()->load(*entry).get_probability("a"), 0.5);
+    EXPECT_FALSE(std::filesystem::exists(first->path() + ".tmp"));
+
+    // Only versions that no store holds are removed
+    const auto next = SharedModelStore::open(directory, "test-v2.lfb", build);
+    EXPECT_EQ(SharedModelStore::remove_unused(directory, "test-"), 0);
+    const std::string first_path = first->path();
+    const auto bundle = first->bundle();
+    first.reset();
+#ifndef _WIN32
+    EXPECT_EQ(SharedModelStore::remove_unused(directory, "test-"), 0);
+#endif
+    second.reset();
+    EXPECT_EQ(SharedModelStore::remove_unused(directory, "test-"), 1);
+    EXPECT_FALSE(std::filesystem::exists(first_path));
+    EXPECT_FALSE(std::filesystem::exists(first_path + ".lock"));
+    EXPECT_TRUE(std::filesystem::exists(next->path()));
+    // Mappings of a removed version stay valid
+    EXPECT_DOUBLE_EQ(bundle->load(*bundle->find(Language::WELSH, 1, ModelKind::PROBABILITY)).get_probability("a"), 0.5);
+    std::filesystem::remove_all(directory);
+}
+
+TEST(ModelTest, FrozenModelRejectsMalformedBlocks) {
+    ModelBuilder builder(Language::ENGLISH, 1, ModelKind::PROBABILITY);
+    builder.set_probability("a", 0.5);
+    const FrozenModel frozen = builder.freeze();
+    const auto bytes = frozen.bytes();
+    std::vector<uint64_t> words(bytes.size() / 8);
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+    auto block = [&words](size_t size) {
+        return std::span<const std::byte>(reinterpret_cast<const std::byte*>(words.data()), size);
+    };
+    auto* header = reinterpret_cast<FrozenModelHeader*>(words.data());
+
+    EXPECT_NO_THROW(FrozenModel::from_bytes(block(bytes.size()), nullptr));
+    EXPECT_THROW(FrozenModel::from_bytes(block(16), nullptr), ModelLoadException);
+    EXPECT_THROW(FrozenModel::from_bytes(block(bytes.size() - 8), nullptr), ModelLoadException);
+
+    header->sections[4].size = bytes.size();
+    EXPECT_THROW(FrozenModel::from_bytes(block(bytes.size()), nullptr), ModelLoadException);
+    header->sections[4].size = sizeof(double);
+
+    header->format_version = FrozenModelHeader::FORMAT_VERSION + 1;
+    EXPECT_THROW(FrozenModel::from_bytes(block(bytes.size()), nullptr), ModelLoadException);
+    header->format_version = FrozenModelHeader::FORMAT_VERSION;
+
+    // Corrupt section contents give wrong answers, but neither out-of-bounds reads nor endless probing
+    auto section = [&](size_t index) {
+        return reinterpret_cast<std::byte*>(words.data()) + header->sections[index].offset;
+    };
+    const std::vector<uint64_t> original = words;
+    auto* slots = reinterpret_cast<uint64_t*>(section(0));
+    std::fill(slots, slots + header->slot_count, ~uint64_t{0});
+    FrozenModel corrupt = FrozenModel::from_bytes(block(bytes.size()), nullptr);
+    EXPECT_FALSE(corrupt.contains("a"));
+    EXPECT_EQ(corrupt.get_probability("b"), 0.0);
+    words = original;
+    std::memset(section(3), 0xFF, header->sections[3].size);
+    corrupt = FrozenModel::from_bytes(block(bytes.size()), nullptr);
+    EXPECT_TRUE(corrupt.contains("a"));
+    EXPECT_EQ(corrupt.get_probability("a"), 0.0);
+    words = original;
+
+    header->magic[0] = 'X';
+    EXPECT_THROW(FrozenModel::from_bytes(block(bytes.size()), nullptr), ModelLoadException);
+    EXPECT_THROW(FrozenModel::read_from("does/not/exist.bin"), ModelLoadException);
+}
+
+TEST(ModelTest, FingerprintSet) {
+    std::vector<std::string> members;
+    for (int i = 0; i < 5000; ++i) {
+        members.push_back(numbered("m", i));
+    }
+    std::vector<std::string_view> views(members.begin(), members.end());
+
+    const unsigned bits = FingerprintSet::fingerprint_bits_for(members.size(), 1e-3);
+    EXPECT_EQ(bits, 23);
+    FingerprintSet set(views, bits);
+    EXPECT_EQ(set.size(), members.size());
+    EXPECT_EQ(set.fingerprint_bits(), bits);
+    EXPECT_LE(set.false_positive_rate(), 1e-3);
+
+    // No false negatives
+    for (const auto& member : members) {
+        EXPECT_TRUE(set.contains(member));
+    }
+
+    // False positives stay close to the configured rate
+    size_t false_positives = 0;
+    for (int i = 0; i < 100000; ++i) {
+        false_positives += set.contains(numbered("x", i)) ? 1 : 0;
+    }
+    EXPECT_LT(false_positives, 300);
+
+    // Empty sets and invalid widths
+    EXPECT_FALSE(FingerprintSet().contains("a"));
+    EXPECT_FALSE(FingerprintSet({}, 32).contains("a"));
+    EXPECT_THROW(FingerprintSet(views, 7), std::invalid_argument);
+    EXPECT_THROW(FingerprintSet(views, 65), std::invalid_argument);
+    EXPECT_THROW(FingerprintSet::fingerprint_bits_for(10, 0.0), std::invalid_argument);
+    EXPECT_EQ(FingerprintSet::fingerprint_bits_for(1000000000, 1e-30), FingerprintSet::MAX_FINGERPRINT_BITS);
+}
+
+TEST(ModelTest, CompactNgramCountModel) {
+    ModelBuilder builder(Language::GERMAN, 5, ModelKind::UNIQUE);
+    for (std::string_view ngram : {"test", "hello", "wörld"}) {
+        builder.add_ngram(ngram);
+    }
+    NgramCountModel model(builder.freeze_fingerprints(64));
+    EXPECT_TRUE(model.is_compact());
+    EXPECT_EQ(model.size(), 3);
+    EXPECT_TRUE(model.contains(Ngram("test")));
+    EXPECT_TRUE(model.contains("wörld"));
+    EXPECT_FALSE(model.contains("none"));
+    EXPECT_GT(model.false_positive_rate(), 0.0);
+    EXPECT_EQ(model.get_model_type(), NgramModelType::UNIQUE);
+}
+
+TEST(ModelTest, HashedNgramModel) {
+    ModelBuilder builder(Language::RUSSIAN, 3, ModelKind::PROBABILITY);
+    for (int i = 0; i < 5000; ++i) {
+        builder.set_probability("я" + std::to_string(i), 1.0 / (i + 1));
+    }
+    const FrozenModel exact = builder.freeze();
+    const FrozenModel hashed = builder.freeze_hashed();
+    EXPECT_EQ(hashed.get_layout(), FrozenModelLayout::HASHED_NGRAMS);
+    EXPECT_EQ(hashed.size(), 5000);
+    EXPECT_LT(hashed.bytes().size(), exact.bytes().size() / 2);
+    EXPECT_GT(hashed.false_positive_rate(), 0.0);
+    EXPECT_LT(hashed.false_positive_rate(), 1e-4);
+
+    // Lookups by bytes, by Ngram and by hash agree, and no key is kept
+    NgramProbabilityModel model(FrozenModel::from_bytes(hashed.bytes(), nullptr));
+    EXPECT_DOUBLE_EQ(model.get_probability("я41"), 1.0 / 42);
+    EXPECT_DOUBLE_EQ(model.get_probability(Ngram("я41")), 1.0 / 42);
+    EXPECT_DOUBLE_EQ(model.get_probability_by_hash(NgramHasher::hash_of(Ngram("я41"))), 1.0 / 42);
+    EXPECT_TRUE(model.contains("я4999"));
+    EXPECT_DOUBLE_EQ(model.get_probability("я5000"), 0.0);
+    EXPECT_DOUBLE_EQ(model.get_probability("\xFF"), 0.0);
+
+    // Hash table models convert; they cannot be looked up by hash themselves
+    const FrozenModel converted = ModelBuilder::freeze_hashed(exact);
+    ASSERT_EQ(converted.bytes().size(), hashed.bytes().size());
+    EXPECT_EQ(std::memcmp(converted.bytes().data(), hashed.bytes().data(), hashed.bytes().size()), 0);
+    EXPECT_DOUBLE_EQ(exact.get_probability_by_hash(NgramHasher::hash_of(Ngram("я41"))), 0.0);
+    EXPECT_THROW(ModelBuilder::freeze_hashed(converted), std::invalid_argument);
+
+    ModelBuilder set(Language::RUSSIAN, 2, ModelKind::UNIQUE);
+    set.add_ngram("ёж");
+    const NgramCountModel count_model(set.freeze_hashed());
+    EXPECT_TRUE(count_model.is_compact());
+    EXPECT_TRUE(count_model.contains_hash(NgramHasher::hash_of(Ngram("ёж"))));
+    EXPECT_TRUE(count_model.contains(Ngram("ёж")));
+    EXPECT_FALSE(count_model.contains("еж"));
+
+    // An index whose slots are all taken by a corrupt block stops probing after every slot
+    std::vector<uint64_t> words(hashed.bytes().size() / 8);
+    std::memcpy(words.data(), hashed.bytes().data(), hashed.bytes().size());
+    const auto* header = reinterpret_cast<const FrozenModelHeader*>(words.data());
+    auto* fingerprints = reinterpret_cast<uint16_t*>(reinterpret_cast<std::byte*>(words.data()) + header->sections[0].offset);
+    const uint64_t missing_hash = NgramHasher::hash_of(Ngram("я5000"));
+    const auto other_fingerprint = static_cast<uint16_t>(FrozenModel::hash_fingerprint(missing_hash) ^ 1);
+    std::fill(fingerprints, fingerprints + header->slot_count, other_fingerprint);
+    const FrozenModel full = FrozenModel::from_bytes(
+        std::span<const std::byte>(reinterpret_cast<const std::byte*>(words.data()), hashed.bytes().size()), nullptr);
+    EXPECT_FALSE(full.contains_hash(missing_hash));
+    EXPECT_DOUBLE_EQ(full.get_probability_by_hash(missing_hash), 0.0);
 }
 
 TEST(NgramTest, Validation) {
@@ -1084,6 +2368,54 @@ TEST(NgramTest, EqualityOperators) {
     EXPECT_TRUE(ngram1 != ngram3);
 }
 
+TEST(NgramTest, CountsCodePoints) {
+    const Ngram cyrillic("слово");
+    EXPECT_EQ(cyrillic.char_count(), 5);
+    EXPECT_EQ(cyrillic.get_value(), "слово");
+    EXPECT_EQ(cyrillic.code_point(1), U'л');
+    EXPECT_EQ(Ngram("東京都庁前").char_count(), 5);
+    EXPECT_EQ(Ngram("😀a").char_count(), 2);
+    EXPECT_EQ(Ngram("😀😀😀😀😀").get_value(), "😀😀😀😀😀");
+    EXPECT_THROW(Ngram("привет"), std::invalid_argument);
+    EXPECT_EQ(NgramRef("äöü").char_count(), 3);
+    EXPECT_THROW(NgramRef("東京都庁前駅"), std::invalid_argument);
+
+    // Invalid UTF-8 is rejected without throwing by from_utf8
+    EXPECT_FALSE(Ngram::from_utf8("\xC3").has_value());
+    EXPECT_FALSE(Ngram::from_utf8("\xC0\xAF").has_value());
+    EXPECT_FALSE(Ngram::from_utf8("\xED\xA0\x80").has_value());
+    EXPECT_FALSE(Ngram::from_utf8("").has_value());
+    EXPECT_FALSE(NgramRef::from_utf8("abcdef").has_value());
+    EXPECT_FALSE(Ngram::from_code_points(U"ab\xD800").has_value());
+    EXPECT_EQ(Ngram::from_code_points(U"ab"), Ngram("ab"));
+}
+
+TEST(NgramTest, ConstexprValueSemantics) {
+    constexpr auto ab = Ngram::from_utf8("ab");
+    static_assert(ab.has_value() && ab->char_count() == 2);
+    static_assert(*ab == *Ngram::from_code_points(U"ab"));
+    static_assert(*Ngram::from_utf8("a") < *ab && *ab < *Ngram::from_utf8("b"));
+    static_assert(ab->hash() == Ngram::from_utf8("ab")->hash());
+    static_assert(Ngram::from_utf8("abcde")->prefix(2) == *ab);
+    static_assert(NgramRef::from_utf8("東京")->char_count() == 2);
+    static_assert(sizeof(Ngram) == 16);
+
+    EXPECT_NE(std::hash<Ngram>()(Ngram("ab")), std::hash<Ngram>()(Ngram("ba")));
+    std::unordered_set<Ngram> ngrams{Ngram("ab"), Ngram("東京"), Ngram("ab")};
+    EXPECT_EQ(ngrams.size(), 2);
+    EXPECT_EQ(Ngram("東京都").prefix(2), Ngram("東京"));
+    EXPECT_EQ(NgramRef("東京").to_ngram(), Ngram("東京"));
+
+    // Creating, copying, comparing and encoding n-grams never allocates
+    const size_t before = allocations();
+    const auto ngram = Ngram::from_utf8("слово");
+    const Ngram copy = *ngram;
+    Ngram::Utf8Buffer buffer;
+    const bool equal = copy == *ngram && copy.to_utf8(buffer) == "слово";
+    EXPECT_EQ(allocations(), before);
+    EXPECT_TRUE(equal);
+}
+
 TEST(NgramRefTest, ConstructorAndGetters) {
     // Test valid n-gram refs
     NgramRef ngram_ref1("a");
@@ -1115,6 +2447,7 @@ TEST(NgramRefTest, Validation) {
     // Test invalid lengths
     EXPECT_THROW(NgramRef(""), std::invalid_argument);
     EXPECT_THROW(NgramRef("abcdef"), std::invalid_argument);
+    EXPECT_THROW(NgramRef("\xFF"), std::invalid_argument);
 }
 
 TEST(NgramRefTest, EqualityOperators) {
@@ -1142,6 +2475,14 @@ TEST(NgramRefTest, RangeOfLowerOrderNgrams) {
     EXPECT_EQ(actual, expected);
 }
 
+TEST(NgramRefTest, RangeOfMultiByteNgrams) {
+    std::vector<std::string> actual;
+    for (const auto& n : NgramRef("日本語").range_of_lower_order_ngrams()) {
+        actual.push_back(std::string(n.get_value()));
+    }
+    EXPECT_EQ(actual, (std::vector<std::string>{"日本語", "日本", "日"}));
+}
+
 TEST(NgramRefTest, RangeIterator) {
     NgramRef ngram("abc");
     auto range = ngram.range_of_lower_order_ngrams();
@@ -1218,6 +2559,178 @@ TEST(TextProcessorTest, GenerateNgrams) {
     EXPECT_TRUE(ngrams.empty());
 }
 
+TEST(NgramExtractorTest, ExtractsEveryOrderInOnePass) {
+    NgramExtractor extractor;
+    const auto ngrams = [&](size_t order) {
+        const auto extracted = extractor.ngrams(order);
+        return std::vector<Ngram>(extracted.begin(), extracted.end());
+    };
+    extractor.extract("ab\t cde");
+    EXPECT_EQ(extractor.word_count(), 2);
+    EXPECT_EQ(ngrams(1), (std::vector<Ngram>{Ngram("a"), Ngram("b"), Ngram("c"), Ngram("d"), Ngram("e")}));
+    EXPECT_EQ(ngrams(2), (std::vector<Ngram>{Ngram("ab"), Ngram("cd"), Ngram("de")}));
+    EXPECT_EQ(ngrams(3), (std::vector<Ngram>{Ngram("cde")}));
+    EXPECT_TRUE(extractor.ngrams(4).empty());
+    EXPECT_THROW(extractor.ngrams(0), std::invalid_argument);
+    EXPECT_THROW(extractor.ngrams(6), std::invalid_argument);
+
+    // Multi-byte code points count once; ideographic spaces and invalid bytes end words
+    extractor.extract("привет\u3000日本\xFFx");
+    EXPECT_EQ(extractor.word_count(), 3);
+    EXPECT_EQ(extractor.ngrams(1).size(), 9);
+    EXPECT_EQ(ngrams(5), (std::vector<Ngram>{Ngram("приве"), Ngram("ривет")}));
+    EXPECT_EQ(extractor.ngrams(2).back(), Ngram("日本"));
+
+    // The buffers keep their capacity, so extracting a text again allocates nothing
+    extractor.extract("слово word");
+    const size_t before = allocations();
+    extractor.extract("слово word");
+    EXPECT_EQ(allocations(), before);
+    EXPECT_EQ(extractor.ngrams(4).size(), 3);
+}
+
+TEST(NgramHasherTest, RollsTheHashesOfTheExtractedNgrams) {
+    NgramExtractor extractor;
+    NgramHasher hasher;
+    const std::string text = "привет мир\xFFtext 日本語の文章";
+    extractor.extract(text);
+    hasher.extract(text);
+    EXPECT_EQ(hasher.word_count(), extractor.word_count());
+    for (size_t order = 1; order <= Ngram::MAX_CHAR_COUNT; ++order) {
+        const auto ngrams = extractor.ngrams(order);
+        const auto hashes = hasher.hashes(order);
+        ASSERT_EQ(hashes.size(), ngrams.size());
+        for (size_t i = 0; i < ngrams.size(); ++i) {
+            EXPECT_EQ(hashes[i], NgramHasher::hash_of(ngrams[i]));
+            Ngram::Utf8Buffer buffer;
+            EXPECT_EQ(NgramHasher::hash_of_utf8(ngrams[i].to_utf8(buffer)), hashes[i]);
+        }
+    }
+    EXPECT_NE(NgramHasher::hash_of(Ngram("ab")), NgramHasher::hash_of(Ngram("ba")));
+    EXPECT_FALSE(NgramHasher::hash_of_utf8("").has_value());
+    EXPECT_FALSE(NgramHasher::hash_of_utf8("a\xFF").has_value());
+    EXPECT_THROW(hasher.hashes(6), std::invalid_argument);
+}
+
+TEST(Utf8DecoderTest, DecodesValidatesAndReplaces) {
+    // Long ASCII runs go through the block path; the other sequences around them are decoded one by one
+    const std::string ascii(70, 'a');
+    const std::string text = ascii + "é" + ascii + "日本𝄞";
+    std::u32string expected = std::u32string(70, U'a') + U"é" + std::u32string(70, U'a') + U"日本𝄞";
+    EXPECT_EQ(to_utf32(text), expected);
+    EXPECT_TRUE(is_valid_utf8(text));
+    EXPECT_EQ(ascii_prefix_length(text), 70);
+    EXPECT_EQ(ascii_prefix_length(ascii), 70);
+
+    // A small output buffer decodes the text in chunks that end at sequence boundaries
+    std::u32string chunked;
+    std::array<char32_t, 3> buffer {};
+    for (std::string_view rest = text; !rest.empty();) {
+        const Utf8DecodeResult decoded = decode_utf8(rest, buffer);
+        ASSERT_GT(decoded.bytes_read, 0);
+        EXPECT_EQ(decoded.invalid_sequences, 0);
+        chunked.append(buffer.data(), decoded.code_points_written);
+        rest.remove_prefix(decoded.bytes_read);
+    }
+    EXPECT_EQ(chunked, expected);
+
+    // Each maximal invalid subpart becomes one U+FFFD: a stray continuation byte, an overlong
+    // form, a surrogate, a value above U+10FFFF and a sequence cut short by the end
+    const std::string invalid = "a\x80" "b\xC0\xAF" "c\xED\xA0\x80" "d\xF4\x90\x80\x80" "e\xE6\x97";
+    const Utf8DecodeResult decoded = decode_utf8(invalid, buffer);
+    EXPECT_EQ(decoded.code_points_written, 3);
+    EXPECT_EQ(decoded.invalid_sequences, 1);
+    EXPECT_EQ(to_utf32(invalid), U"a\uFFFDb\uFFFD\uFFFDc\uFFFD\uFFFD\uFFFDd\uFFFD\uFFFD\uFFFD\uFFFDe\uFFFD");
+    EXPECT_FALSE(is_valid_utf8(invalid));
+    EXPECT_FALSE(is_valid_utf8(ascii + "\xE6\x97"));
+    EXPECT_EQ(TextProcessor::normalize_unicode("ok\xFF"), "ok\xEF\xBF\xBD");
+    EXPECT_FALSE(matches(Alphabet::LATIN, "ab\xFF"));
+
+    std::string encoded;
+    for (char32_t code_point : expected) {
+        append_utf8(code_point, encoded);
+    }
+    EXPECT_EQ(encoded, text);
+}
+
+TEST(Utf8DecoderTest, BlockPathMatchesScalarPath) {
+    // Decoding into a one-element span never takes a block path, so it decodes every sequence one by one
+    const auto decode_one_by_one = [](std::string_view text) {
+        std::u32string code_points;
+        std::array<char32_t, 1> buffer {};
+        for (std::string_view rest = text; !rest.empty();) {
+            const Utf8DecodeResult decoded = decode_utf8(rest, buffer);
+            code_points.append(buffer.data(), decoded.code_points_written);
+            rest.remove_prefix(decoded.bytes_read);
+        }
+        return code_points;
+    };
+
+    // Each invalid sequence lands at every offset of a 16-byte block of valid two- and
+    // three-byte sequences, with enough text around it for the block path to run
+    const std::string valid = "жé日本ñ語ωклм中文";
+    const std::vector<std::string> invalid_sequences = {
+        "\x80", "\xBF\x80", "\xC0\xAF", "\xC1\xBF", "\xE0\x80\xAF", "\xE0\x9F\xBF", "\xED\xA0\x80",
+        "\xED\xBF\xBF", "\xC3" "a", "\xE6\x97" "a", "\xE6" "\xC3\xA9", "\xF4\x90\x80\x80", "\xF8\x88\x80\x80\x80", "\xFF"};
+    for (const std::string& invalid : invalid_sequences) {
+        for (size_t offset = 0; offset < 16; ++offset) {
+            std::string text = valid.substr(0, offset);
+            // Keep the prefix on a sequence boundary
+            while (!text.empty() && is_utf8_continuation(valid[text.size()])) {
+                text.pop_back();
+            }
+            text += invalid + valid + valid;
+            ASSERT_GE(text.size(), 34);
+            EXPECT_EQ(to_utf32(text), decode_one_by_one(text)) << "invalid sequence at byte " << offset;
+            EXPECT_FALSE(is_valid_utf8(text)) << "invalid sequence at byte " << offset;
+        }
+    }
+    const std::string long_valid = valid + valid + valid;
+    EXPECT_EQ(to_utf32(long_valid), decode_one_by_one(long_valid));
+    EXPECT_TRUE(is_valid_utf8(long_valid));
+}
+
+TEST(TextNormalizerTest, FoldsCaseAndKeepsOnlyLetters) {
+    EXPECT_EQ(fold_case(U'A'), U'a');
+    EXPECT_EQ(fold_case(U'Ä'), U'ä');
+    EXPECT_EQ(fold_case(U'Ж'), U'ж');
+    EXPECT_EQ(fold_case(U'ς'), U'σ');
+    EXPECT_EQ(fold_case(U'ẞ'), U'ß');
+    EXPECT_EQ(fold_case(U'Ā'), U'ā');
+    EXPECT_EQ(fold_case(U'ā'), U'ā');
+    EXPECT_EQ(fold_case(U'日'), U'日');
+    EXPECT_TRUE(is_letter(U'z'));
+    EXPECT_TRUE(is_letter(U'é'));
+    EXPECT_TRUE(is_letter(U'\u0301'));
+    EXPECT_TRUE(is_letter(U'日'));
+    EXPECT_FALSE(is_letter(U'7'));
+    EXPECT_FALSE(is_letter(U'٣'));
+    EXPECT_FALSE(is_letter(U'«'));
+    EXPECT_FALSE(is_letter(U'€'));
+    EXPECT_FALSE(is_letter(REPLACEMENT_CHARACTER));
+
+    // Whitespace ends words; digits, punctuation and symbols are dropped without splitting them
+    TextNormalizer normalizer;
+    const auto words = normalizer.normalize("  STRASSE, Straße\t\tẞ «ΟΔΟΣ» 12ab٣c\u3000Москва!\xFF ... 42 ");
+    EXPECT_EQ(std::vector<std::string_view>(words.begin(), words.end()),
+              (std::vector<std::string_view>{"strasse", "straße", "ß", "οδοσ", "abc", "москва"}));
+    EXPECT_EQ(normalizer.text(), "strasse straße ß οδοσ abc москва");
+    EXPECT_EQ(normalizer.word_count(), 6);
+    EXPECT_TRUE(normalizer.normalize(" 1, 2. ").empty());
+    EXPECT_EQ(normalizer.text(), "");
+
+    // The normalized text goes straight to the extractor, and normalizing again allocates nothing
+    NgramExtractor extractor;
+    normalizer.normalize("Hello, World 2024!");
+    extractor.extract(normalizer.text());
+    EXPECT_EQ(extractor.word_count(), 2);
+    EXPECT_EQ(extractor.ngrams(5).front(), Ngram("hello"));
+    const size_t before = allocations();
+    normalizer.normalize("Hello, World 2024!");
+    EXPECT_EQ(allocations(), before);
+    EXPECT_EQ(normalizer.words()[1], "world");
+}
+
 TEST(TextProcessorTest, NormalizeUnicode) {
     // Test basic normalization
     std::string normalized = TextProcessor::normalize_unicode("Hello world");
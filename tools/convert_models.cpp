@@ -0,0 +1,101 @@
+// Converts the Brotli-compressed JSON models under models/ into precompiled
+// binary models (*.lfm) that ModelLoader loads without any parsing.
+//
+// Usage: lingua_convert_models [--exact | --false-positive-rate RATE] [--output-dir DIR] [ISO_639_1_CODE...]
+//
+// Run it from the directory that contains models/. Without language codes,
+// every language is converted. Binary models are written next to the JSON
+// models, or into the same models/ layout under DIR.
+
+#include "lingua/model_loader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+
+namespace {
+    void print_usage() {
+        std::cerr << "Usage: lingua_convert_models [--exact | --false-positive-rate RATE] [--output-dir DIR] [ISO_639_1_CODE...]\n";
+    }
+
+    // Writes next to the target and renames, so readers never see a partial file
+    void write_atomically(const FrozenModel& model, const std::string& path) {
+        const std::string temporary_path = path + ".tmp";
+        model.write_to(temporary_path);
+        std::filesystem::rename(temporary_path, path);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    auto& loader = ModelLoader::get_instance();
+    std::vector<Language> languages;
+    std::filesystem::path output_dir;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            if (argument == "--exact") {
+                loader.set_count_model_false_positive_rate(0.0);
+            } else if (argument == "--false-positive-rate" && i + 1 < argc) {
+                loader.set_count_model_false_positive_rate(std::stod(argv[++i]));
+            } else if (argument == "--output-dir" && i + 1 < argc) {
+                output_dir = argv[++i];
+            } else if (argument == "--help" || argument == "-h") {
+                print_usage();
+                return EXIT_SUCCESS;
+            } else {
+                languages.push_back(from_iso_code_639_1(argument));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        print_usage();
+        return EXIT_FAILURE;
+    }
+    if (languages.empty()) {
+        const auto all = all_languages();
+        languages.assign(all.begin(), all.end());
+    }
+
+    size_t converted = 0;
+    size_t failed = 0;
+    uintmax_t json_bytes = 0;
+    uintmax_t binary_bytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (Language language : languages) {
+        for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+            for (ModelKind kind : {ModelKind::PROBABILITY, ModelKind::UNIQUE, ModelKind::MOST_COMMON}) {
+                const std::string json_path = ModelLoader::model_file_path(
+                    language, ngram_length, kind, ModelLoader::JSON_MODEL_EXTENSION);
+                if (!std::filesystem::exists(json_path)) {
+                    continue;
+                }
+                const std::string binary_path = (output_dir / ModelLoader::model_file_path(
+                    language, ngram_length, kind, ModelLoader::BINARY_MODEL_EXTENSION)).string();
+                try {
+                    std::filesystem::create_directories(std::filesystem::path(binary_path).parent_path());
+                    const FrozenModel model = loader.compile_model(language, ngram_length, kind);
+                    write_atomically(model, binary_path);
+                    json_bytes += std::filesystem::file_size(json_path);
+                    binary_bytes += model.bytes().size();
+                    ++converted;
+                } catch (const std::exception& e) {
+                    std::cerr << "Failed to convert " << json_path << ": " << e.what() << "\n";
+                    ++failed;
+                }
+            }
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Converted %zu models (%zu failed) in %.1f s: %.1f MiB compressed JSON -> %.1f MiB binary\n",
+                converted, failed, seconds, json_bytes / 1048576.0, binary_bytes / 1048576.0);
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
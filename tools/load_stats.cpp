@@ -0,0 +1,115 @@
+// Loads the models of some or all languages and prints where the time went:
+// totals per load phase and the slowest models with their phase breakdown.
+//
+// Usage: lingua_load_stats [--threads N] [--top N] [--model-root DIR] [--bundle FILE]
+//                          [--memory-map] [--log] [ISO_639_1_CODE...]
+//
+// Models are loaded as a detector would, through the loader's cache, from
+// embedded models, the bundle, binary models or JSON models under DIR (default:
+// the working directory). Without language codes, every language is loaded.
+// --log also prints one spdlog event per model.
+
+#include "lingua/model_loader.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace lingua;
+
+namespace {
+    void print_usage() {
+        std::cerr << "Usage: lingua_load_stats [--threads N] [--top N] [--model-root DIR] [--bundle FILE]\n"
+                     "                         [--memory-map] [--log] [ISO_639_1_CODE...]\n";
+    }
+
+    double milliseconds(std::chrono::nanoseconds duration) {
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    double mebibytes(size_t bytes) {
+        return bytes / 1048576.0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    auto& loader = ModelLoader::get_instance();
+    std::unordered_set<Language> languages;
+    size_t top_count = 20;
+    std::string bundle_path;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            if (argument == "--threads" && i + 1 < argc) {
+                loader.set_thread_count(std::stoul(argv[++i]));
+            } else if (argument == "--top" && i + 1 < argc) {
+                top_count = std::stoul(argv[++i]);
+            } else if (argument == "--model-root" && i + 1 < argc) {
+                loader.set_model_root(argv[++i]);
+            } else if (argument == "--bundle" && i + 1 < argc) {
+                bundle_path = argv[++i];
+            } else if (argument == "--memory-map") {
+                loader.set_memory_mapping(true);
+            } else if (argument == "--log") {
+                loader.set_load_logging(true);
+            } else if (argument == "--help" || argument == "-h") {
+                print_usage();
+                return EXIT_SUCCESS;
+            } else {
+                languages.insert(from_iso_code_639_1(argument));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        print_usage();
+        return EXIT_FAILURE;
+    }
+    if (languages.empty()) {
+        languages = all_languages();
+    }
+
+    ModelPreloadReport preload;
+    try {
+        if (!bundle_path.empty()) {
+            loader.set_model_bundle(bundle_path);
+        }
+        preload = loader.preload_models(languages, {1, 2, 3, 4, 5});
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to load models: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    ModelLoadStats stats = loader.load_stats();
+    std::printf("Loaded %zu models of %zu languages in %.1f ms on %zu threads\n",
+                stats.load_count, languages.size(), milliseconds(preload.wall_time), preload.thread_count);
+    std::printf("  read        %10.1f ms  %9.1f MiB stored\n", milliseconds(stats.read_time), mebibytes(stats.file_bytes));
+    std::printf("  decompress  %10.1f ms  %9.1f MiB of JSON\n", milliseconds(stats.decompress_time),
+                mebibytes(stats.decompressed_bytes));
+    std::printf("  parse       %10.1f ms  %9zu n-grams\n", milliseconds(stats.parse_time), stats.ngram_count);
+    std::printf("  freeze      %10.1f ms  %9.1f MiB in memory\n", milliseconds(stats.freeze_time), mebibytes(stats.memory_bytes));
+    std::printf("  total       %10.1f ms\n\n", milliseconds(stats.total_time));
+
+    std::sort(stats.loads.begin(), stats.loads.end(), [](const ModelLoadRecord& a, const ModelLoadRecord& b) {
+        return a.total_time > b.total_time;
+    });
+    if (stats.loads.size() > top_count) {
+        stats.loads.resize(top_count);
+    }
+    std::printf("%-14s %2s %-12s %-8s %9s %9s %9s %9s %9s %10s %10s %9s\n", "language", "n", "kind", "source",
+                "total ms", "read", "decomp", "parse", "freeze", "stored KiB", "memory KiB", "n-grams");
+    for (const ModelLoadRecord& record : stats.loads) {
+        std::printf("%-14s %2zu %-12s %-8s %9.2f %9.2f %9.2f %9.2f %9.2f %10.1f %10.1f %9zu\n",
+                    to_string(record.language).c_str(), record.ngram_length, to_string(record.kind).c_str(),
+                    to_string(record.source).c_str(), milliseconds(record.total_time), milliseconds(record.read_time),
+                    milliseconds(record.decompress_time), milliseconds(record.parse_time),
+                    milliseconds(record.freeze_time), record.file_bytes / 1024.0, record.memory_bytes / 1024.0,
+                    record.ngram_count);
+    }
+    return EXIT_SUCCESS;
+}
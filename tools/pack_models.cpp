@@ -0,0 +1,103 @@
+// Packs the models of some or all languages into a single model bundle that
+// ModelLoader::set_model_bundle() serves every model from.
+//
+// Usage: lingua_pack_models [--exact | --false-positive-rate RATE] [--model-root DIR]
+//                           [--output FILE] [ISO_639_1_CODE...]
+//
+// Models are taken from binary models where they exist and match, and from the
+// JSON models otherwise, under DIR (default: the working directory). Without
+// language codes, every language is packed. The bundle is written to FILE,
+// models/models.lfb under the model root by default.
+
+#include "lingua/model_bundle.h"
+#include "lingua/model_loader.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+
+namespace {
+    void print_usage() {
+        std::cerr << "Usage: lingua_pack_models [--exact | --false-positive-rate RATE] [--model-root DIR]\n"
+                     "                          [--output FILE] [ISO_639_1_CODE...]\n";
+    }
+}
+
+int main(int argc, char* argv[]) {
+    auto& loader = ModelLoader::get_instance();
+    std::vector<Language> languages;
+    std::string model_root;
+    std::string output_path;
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            if (argument == "--exact") {
+                loader.set_count_model_false_positive_rate(0.0);
+            } else if (argument == "--false-positive-rate" && i + 1 < argc) {
+                loader.set_count_model_false_positive_rate(std::stod(argv[++i]));
+            } else if (argument == "--model-root" && i + 1 < argc) {
+                model_root = argv[++i];
+            } else if (argument == "--output" && i + 1 < argc) {
+                output_path = argv[++i];
+            } else if (argument == "--help" || argument == "-h") {
+                print_usage();
+                return EXIT_SUCCESS;
+            } else {
+                languages.push_back(from_iso_code_639_1(argument));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        print_usage();
+        return EXIT_FAILURE;
+    }
+    if (languages.empty()) {
+        const auto all = all_languages();
+        languages.assign(all.begin(), all.end());
+    }
+    if (output_path.empty()) {
+        output_path = (std::filesystem::path(model_root) / "models" / "models.lfb").string();
+    }
+    loader.set_model_root(model_root);
+
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        ModelBundleWriter writer(output_path);
+        for (Language language : languages) {
+            for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+                for (ModelKind kind : {ModelKind::PROBABILITY, ModelKind::UNIQUE, ModelKind::MOST_COMMON}) {
+                    const std::string json_path = (std::filesystem::path(model_root) / ModelLoader::model_file_path(
+                        language, ngram_length, kind, ModelLoader::JSON_MODEL_EXTENSION)).string();
+                    if (!std::filesystem::exists(json_path)) {
+                        continue;
+                    }
+                    if (kind == ModelKind::PROBABILITY) {
+                        writer.add(loader.load_probability_model(language, ngram_length)->frozen_model());
+                    } else {
+                        const auto model_type = kind == ModelKind::UNIQUE ? NgramModelType::UNIQUE : NgramModelType::MOST_COMMON;
+                        writer.add(loader.load_count_model(language, ngram_length, model_type)->frozen_model());
+                    }
+                }
+            }
+            // Only the bundle needs the models, so keep at most one language in memory
+            loader.clear_cache();
+        }
+
+        const size_t model_count = writer.size();
+        const uint64_t bundle_bytes = writer.finish();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("Packed %zu models of %zu languages into %s in %.1f s: %.1f MiB\n",
+                    model_count, languages.size(), output_path.c_str(), seconds, bundle_bytes / 1048576.0);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to pack models: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,363 @@
+// Prunes the probability models of some or all languages, writes the pruned
+// models as binary models, and reports what the pruning costs in accuracy
+// against what it saves in memory.
+//
+// Usage: lingua_prune_models (--max-ngrams N | --min-probability P) [--model-root DIR]
+//                            [--output-dir DIR] [--threads N] [--low-accuracy]
+//                            [ISO_639_1_CODE...]
+//
+// --max-ngrams keeps the N most probable n-grams of every probability model;
+// --min-probability drops the n-grams less probable than P; both may be given.
+// Models are read under the model root (default: the working directory) and
+// written in the same models/ layout under the output directory (default:
+// pruned/), together with unchanged copies of the unique and most common
+// n-gram models, so the output directory is a complete model root for
+// ModelLoader::set_model_root().
+//
+// The sentences, word pairs and single words in models/*/testdata are then
+// classified once with the original models and once with the pruned ones among
+// the given languages (default: every language). A sample is assigned the
+// language whose n-grams of length 1 to 5 (3 with --low-accuracy) have the
+// highest sum of log probabilities, an n-gram missing from a model counting
+// with its longest prefix that the model has.
+
+#include "lingua/model_builder.h"
+#include "lingua/model_loader.h"
+#include "lingua/thread_pool.h"
+#include <utf8.h>
+#include <algorithm>
+#include <array>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cwctype>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace lingua;
+
+namespace {
+    using ProbabilityModelPointer = std::shared_ptr<const NgramProbabilityModel>;
+
+    constexpr std::array<const char*, 3> TEST_SETS = {"sentences", "word-pairs", "single-words"};
+
+    struct PruningLevel {
+        std::optional<size_t> max_ngrams;
+        double min_probability = 0.0;
+    };
+
+    struct LanguageReport {
+        size_t original_bytes = 0;
+        size_t pruned_bytes = 0;
+        size_t original_ngrams = 0;
+        size_t pruned_ngrams = 0;
+        std::array<size_t, TEST_SETS.size()> sample_count{};
+        std::array<size_t, TEST_SETS.size()> original_correct{};
+        std::array<size_t, TEST_SETS.size()> pruned_correct{};
+    };
+
+    void print_usage() {
+        std::cerr << "Usage: lingua_prune_models (--max-ngrams N | --min-probability P) [--model-root DIR]\n"
+                     "                           [--output-dir DIR] [--threads N] [--low-accuracy]\n"
+                     "                           [ISO_639_1_CODE...]\n";
+    }
+
+    // Writes next to the target and renames, so readers never see a partial file
+    void write_atomically(const FrozenModel& model, const std::filesystem::path& path) {
+        std::filesystem::create_directories(path.parent_path());
+        const std::string temporary_path = path.string() + ".tmp";
+        model.write_to(temporary_path);
+        std::filesystem::rename(temporary_path, path);
+    }
+
+    FrozenModel prune(const FrozenModel& model, const PruningLevel& level) {
+        std::vector<size_t> kept;
+        kept.reserve(model.size());
+        for (size_t index = 0; index < model.size(); ++index) {
+            if (model.probability_at(index) >= level.min_probability) {
+                kept.push_back(index);
+            }
+        }
+        if (level.max_ngrams && kept.size() > *level.max_ngrams) {
+            // Ties are broken by entry index, so a level always keeps the same n-grams
+            std::nth_element(kept.begin(), kept.begin() + static_cast<std::ptrdiff_t>(*level.max_ngrams), kept.end(),
+                             [&](size_t a, size_t b) {
+                                 const double probability_a = model.probability_at(a);
+                                 const double probability_b = model.probability_at(b);
+                                 return probability_a != probability_b ? probability_a > probability_b : a < b;
+                             });
+            kept.resize(*level.max_ngrams);
+        }
+
+        ModelBuilder builder(model.get_language(), model.get_ngram_length(), ModelKind::PROBABILITY);
+        builder.reserve(kept.size());
+        for (size_t index : kept) {
+            builder.set_probability(model.ngram_at(index), model.probability_at(index));
+        }
+        return builder.freeze();
+    }
+
+    std::vector<std::string> read_lines(const std::filesystem::path& path) {
+        std::vector<std::string> lines;
+        std::ifstream file(path);
+        for (std::string line; std::getline(file, line);) {
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            if (!line.empty()) {
+                lines.push_back(std::move(line));
+            }
+        }
+        return lines;
+    }
+
+    // Lowercased words of a text, with the byte offset of every character and one past the last
+    struct Word {
+        std::string text;
+        std::vector<size_t> offsets;
+    };
+
+    std::vector<Word> words_of(const std::string& text) {
+        std::u32string characters;
+        try {
+            utf8::utf8to32(text.begin(), text.end(), std::back_inserter(characters));
+        } catch (const utf8::invalid_utf8&) {
+            return {};
+        }
+        std::vector<Word> words(1);
+        for (char32_t character : characters) {
+            if (!std::iswalpha(static_cast<wint_t>(character))) {
+                if (!words.back().text.empty()) {
+                    words.emplace_back();
+                }
+                continue;
+            }
+            Word& word = words.back();
+            word.offsets.push_back(word.text.size());
+            utf8::append(static_cast<char32_t>(std::towlower(static_cast<wint_t>(character))), std::back_inserter(word.text));
+        }
+        if (words.back().text.empty()) {
+            words.pop_back();
+        }
+        for (Word& word : words) {
+            word.offsets.push_back(word.text.size());
+        }
+        return words;
+    }
+
+    // The sum of the log probabilities of the n-grams of a text, where an n-gram the
+    // model lacks counts with its longest prefix that it has, as the detector scores them
+    double log_probability(const std::vector<Word>& words, const std::vector<ProbabilityModelPointer>& models,
+                           const std::vector<size_t>& ngram_lengths) {
+        double sum = 0.0;
+        for (size_t ngram_length : ngram_lengths) {
+            for (const Word& word : words) {
+                const size_t character_count = word.offsets.size() - 1;
+                for (size_t start = 0; start + ngram_length <= character_count; ++start) {
+                    for (size_t length = ngram_length; length > 0; --length) {
+                        const std::string_view ngram(word.text.data() + word.offsets[start],
+                                                     word.offsets[start + length] - word.offsets[start]);
+                        const double probability = models[length - 1]->get_probability(ngram);
+                        if (probability > 0.0) {
+                            sum += std::log(probability);
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        return sum;
+    }
+
+    // Classifies every test sample of every language and counts the correct answers
+    void evaluate(const std::vector<Language>& languages, const std::vector<size_t>& ngram_lengths,
+                  const std::filesystem::path& test_root, ThreadPool& pool,
+                  std::map<Language, LanguageReport>& reports, bool pruned) {
+        auto& loader = ModelLoader::get_instance();
+        loader.clear_cache();
+        std::vector<std::vector<ProbabilityModelPointer>> models;
+        for (Language language : languages) {
+            auto& language_models = models.emplace_back();
+            for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+                language_models.push_back(loader.load_probability_model(language, ngram_length));
+            }
+        }
+
+        for (Language language : languages) {
+            LanguageReport& report = reports[language];
+            for (size_t set = 0; set < TEST_SETS.size(); ++set) {
+                const std::vector<std::string> samples = read_lines(
+                    test_root / "models" / iso_code_639_1(language) / "testdata" / (std::string(TEST_SETS[set]) + ".txt"));
+                std::vector<char> correct(samples.size(), 0);
+                pool.parallel_for(samples.size(), [&](size_t sample) {
+                    const std::vector<Word> words = words_of(samples[sample]);
+                    std::optional<size_t> best;
+                    double best_score = 0.0;
+                    bool is_tie = false;
+                    for (size_t candidate = 0; candidate < languages.size(); ++candidate) {
+                        const double score = log_probability(words, models[candidate], ngram_lengths);
+                        // A language that knows none of the n-grams is no candidate
+                        if (score == 0.0) {
+                            continue;
+                        }
+                        if (!best || score > best_score) {
+                            best = candidate;
+                            best_score = score;
+                            is_tie = false;
+                        } else if (score == best_score) {
+                            is_tie = true;
+                        }
+                    }
+                    correct[sample] = best && !is_tie && languages[*best] == language;
+                });
+                report.sample_count[set] = samples.size();
+                (pruned ? report.pruned_correct : report.original_correct)[set] =
+                    static_cast<size_t>(std::count(correct.begin(), correct.end(), 1));
+            }
+        }
+    }
+
+    double accuracy(size_t correct, size_t count) {
+        return count == 0 ? 0.0 : 100.0 * correct / count;
+    }
+
+    double mebibytes(size_t bytes) {
+        return bytes / 1048576.0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // Lets the wide character classes see beyond ASCII
+    std::setlocale(LC_CTYPE, "C.UTF-8");
+    auto& loader = ModelLoader::get_instance();
+    std::vector<Language> languages;
+    PruningLevel level;
+    std::filesystem::path model_root;
+    std::filesystem::path output_dir = "pruned";
+    bool low_accuracy = false;
+    size_t thread_count = ThreadPool::default_thread_count();
+
+    try {
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            if (argument == "--max-ngrams" && i + 1 < argc) {
+                level.max_ngrams = std::stoul(argv[++i]);
+            } else if (argument == "--min-probability" && i + 1 < argc) {
+                level.min_probability = std::stod(argv[++i]);
+            } else if (argument == "--model-root" && i + 1 < argc) {
+                model_root = argv[++i];
+            } else if (argument == "--output-dir" && i + 1 < argc) {
+                output_dir = argv[++i];
+            } else if (argument == "--threads" && i + 1 < argc) {
+                thread_count = std::stoul(argv[++i]);
+            } else if (argument == "--low-accuracy") {
+                low_accuracy = true;
+            } else if (argument == "--help" || argument == "-h") {
+                print_usage();
+                return EXIT_SUCCESS;
+            } else {
+                languages.push_back(from_iso_code_639_1(argument));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid argument: " << e.what() << "\n";
+        print_usage();
+        return EXIT_FAILURE;
+    }
+    if (!level.max_ngrams && level.min_probability <= 0.0) {
+        std::cerr << "Invalid argument: a pruning level is required\n";
+        print_usage();
+        return EXIT_FAILURE;
+    }
+    if (languages.empty()) {
+        const auto all = all_languages();
+        languages.assign(all.begin(), all.end());
+    }
+    std::sort(languages.begin(), languages.end());
+
+    std::map<Language, LanguageReport> reports;
+    try {
+        loader.set_model_root(model_root.string());
+        for (Language language : languages) {
+            LanguageReport& report = reports[language];
+            for (size_t ngram_length = 1; ngram_length <= 5; ++ngram_length) {
+                for (ModelKind kind : {ModelKind::PROBABILITY, ModelKind::UNIQUE, ModelKind::MOST_COMMON}) {
+                    const std::string relative_path = ModelLoader::model_file_path(
+                        language, ngram_length, kind, ModelLoader::JSON_MODEL_EXTENSION);
+                    if (!std::filesystem::exists(model_root / relative_path)) {
+                        continue;
+                    }
+                    const std::filesystem::path output_path = output_dir / ModelLoader::model_file_path(
+                        language, ngram_length, kind, ModelLoader::BINARY_MODEL_EXTENSION);
+                    if (kind != ModelKind::PROBABILITY) {
+                        const auto model_type = kind == ModelKind::UNIQUE ? NgramModelType::UNIQUE : NgramModelType::MOST_COMMON;
+                        write_atomically(loader.load_count_model(language, ngram_length, model_type)->frozen_model(), output_path);
+                        continue;
+                    }
+                    const FrozenModel& original = loader.load_probability_model(language, ngram_length)->frozen_model();
+                    const FrozenModel pruned = prune(original, level);
+                    report.original_bytes += original.memory_usage_bytes();
+                    report.pruned_bytes += pruned.memory_usage_bytes();
+                    report.original_ngrams += original.size();
+                    report.pruned_ngrams += pruned.size();
+                    write_atomically(pruned, output_path);
+                }
+            }
+            // Only the written files are needed, so keep at most one language in memory
+            loader.clear_cache();
+        }
+
+        const std::vector<size_t> ngram_lengths = low_accuracy ? std::vector<size_t>{3} : std::vector<size_t>{1, 2, 3, 4, 5};
+        ThreadPool pool(thread_count);
+        evaluate(languages, ngram_lengths, model_root, pool, reports, false);
+        loader.set_model_root(output_dir.string());
+        evaluate(languages, ngram_lengths, model_root, pool, reports, true);
+        loader.clear_cache();
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to prune models: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    // Memory of the probability models, share of n-grams kept and accuracy change in percentage points
+    std::printf("%-14s %9s %9s %7s %10s %10s %10s %10s\n", "language", "MiB", "pruned", "saved",
+                "kept", "sentences", "word pairs", "words");
+    LanguageReport total;
+    for (const auto& [language, report] : reports) {
+        std::printf("%-14s %9.2f %9.2f %6.1f%% %9.1f%%", to_string(language).c_str(), mebibytes(report.original_bytes),
+                    mebibytes(report.pruned_bytes), 100.0 - accuracy(report.pruned_bytes, report.original_bytes),
+                    accuracy(report.pruned_ngrams, report.original_ngrams));
+        for (size_t set = 0; set < TEST_SETS.size(); ++set) {
+            std::printf(" %+9.2f", accuracy(report.pruned_correct[set], report.sample_count[set])
+                                   - accuracy(report.original_correct[set], report.sample_count[set]));
+            total.sample_count[set] += report.sample_count[set];
+            total.original_correct[set] += report.original_correct[set];
+            total.pruned_correct[set] += report.pruned_correct[set];
+        }
+        std::printf("\n");
+        total.original_bytes += report.original_bytes;
+        total.pruned_bytes += report.pruned_bytes;
+        total.original_ngrams += report.original_ngrams;
+        total.pruned_ngrams += report.pruned_ngrams;
+    }
+
+    std::printf("\nProbability models: %.1f MiB -> %.1f MiB (%.1f%% saved), %zu -> %zu n-grams, written to %s\n",
+                mebibytes(total.original_bytes), mebibytes(total.pruned_bytes),
+                100.0 - accuracy(total.pruned_bytes, total.original_bytes), total.original_ngrams, total.pruned_ngrams,
+                output_dir.string().c_str());
+    for (size_t set = 0; set < TEST_SETS.size(); ++set) {
+        std::printf("Accuracy on %-12s %6.2f%% -> %6.2f%% (%+.2f)\n", TEST_SETS[set],
+                    accuracy(total.original_correct[set], total.sample_count[set]),
+                    accuracy(total.pruned_correct[set], total.sample_count[set]),
+                    accuracy(total.pruned_correct[set], total.sample_count[set])
+                    - accuracy(total.original_correct[set], total.sample_count[set]));
+    }
+    return EXIT_SUCCESS;
+}